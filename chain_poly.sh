@@ -20,43 +20,11 @@ if [ ! -d $2 ]; then
     exit 1
 fi
 
-TEMPDIR=`mktemp -d`
-
-FILE=`grep -xl -m 1 "START" $2/*`
-
-TEMPFILE="$TEMPDIR/temp"
-TEMPFILE2="$TEMPDIR/temp2"
-
-# we remove 'START'
-tail -n +2 "$FILE" > "$TEMPFILE"
-
-LAST_LINE=`tail -1 $TEMPFILE`
-
-while [ "$LAST_LINE" != "STOP" ]; do
-    # last line wasn't stop, so we get the name of the next file from there
-    NEXTFILE="$2/${LAST_LINE:5}"
-    
-    # we remove 'FILE name'
-    head -n -1 "$TEMPFILE" > "$TEMPFILE2"
-    mv "$TEMPFILE2" "$TEMPFILE"
-    
-    # now in TEMPFILE we have content ready to be fed to the program
-    # './' should't ever cause problems while it can help
-    eval "./$1 < $TEMPFILE > $TEMPFILE2"
-    rm "$TEMPFILE"
-    
-    LAST_LINE=`tail -1 "$NEXTFILE"`
-    cat "$TEMPFILE2" "$NEXTFILE" > "$TEMPFILE"
-    rm "$TEMPFILE2"
-done
-
-# the last feeding
-# we remove 'STOP'
-head -n -1 "$TEMPFILE" > "$TEMPFILE2"
-eval "./$1 < $TEMPFILE2"
-
-rm "$TEMPFILE"
-rm "$TEMPFILE2"
-rmdir "$TEMPDIR"
-
-exit 0
+# calc_poly follows the START / FILE name / STOP chain itself, keeping the
+# results of each file in memory instead of printing and re-parsing them
+case "$1" in
+    */*) PROGRAM="$1" ;;
+    *) PROGRAM="./$1" ;;
+esac
+
+exec "$PROGRAM" --chain "$2"
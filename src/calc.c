@@ -0,0 +1,3249 @@
+/** @file
+   Kalkulator działający na stosie wielomianów rzadkich wielu zmiennych.
+
+   Cały stan kalkulatora (stos, parser, bufory wejścia i wyjścia) jest
+   w strukturze Calc, więc kalkulatorów może być wiele (zob. calc.h).
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2017-05-27
+*/
+
+#define _POSIX_C_SOURCE 200809L ///< umożliwia użycie 'fileno' i 'isatty'
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "calc.h"
+#include "poly.h"
+#include "poly_cache.h"
+#include "poly_intern.h"
+#include "poly_reclaim.h"
+#include "poly_ring.h"
+#include "poly_snapshot.h"
+#include "poly_thread.h"
+#include "poly_wire.h"
+#include "stack.h"
+#include "work_stack.h"
+
+#include "unit_tests_poly_utils.h"
+
+#define MAX_COMMAND_LENGTH 255 ///< wielkość bufora komendy, jeżeli to zostanie przekroczone to coś poszło horribly wrong
+#define INPUT_BUFFER_SIZE (1 << 20) ///< rozmiar bloku wczytywanego naraz ze strumienia
+#define OUTPUT_BUFFER_SIZE (1 << 20) ///< rozmiar bufora wyjścia przekazywanego naraz odbiorcy
+#define PIPELINE_BATCH 64 ///< liczba instrukcji, po której parser przekazuje je do wykonania
+#define MUL_PRINT_FRAME_BUDGET (1 << 20) ///< największa ramka MUL_PRINT budowana w pamięci (bajty)
+
+/** Flagi oznaczające typy liczbowe dla funkcji parsujących liczby */
+enum int_type_e {
+	POLY_EXP_T,
+	POLY_COEFF_T,
+	UNSIGNED
+};
+
+/** Flagi błędów */
+enum error_flag_e {
+	NO_ERROR,
+	EOF_FLAG,
+	UNDERFLOW_ERR_FLAG,
+	PARSING_ERR_FLAG,
+	WRONG_COMMAND_ERR_FLAG,
+	WRONG_VALUE_ERR_FLAG,
+	WRONG_VARIABLE_ERR_FLAG,
+	EXCEEDED_COMMAND_BUF_ERR,
+	WRONG_COUNT_ERR_FLAG,
+	TOO_BIG_NUMBER_ERR_FLAG,
+	WRONG_FILE_ERR_FLAG
+};
+
+/* * * CALCULATOR STATE AND ERROR HANDLING * * */
+
+/** Miejsce, do którego trafia treść ramki wyjściowej (tryb binarny) */
+enum wire_sink_e {
+	WIRE_SINK_FRAME, ///< bufor `wire_frame`, wypisywany w ResultEnd
+	WIRE_SINK_BUDGET, ///< bufor `wire_frame` do MUL_PRINT_FRAME_BUDGET bajtów, potem zliczanie
+	WIRE_SINK_COUNT, ///< nigdzie, tylko zliczamy bajty
+	WIRE_SINK_OUTPUT ///< od razu bufor wyjścia (długość ramki jest już wypisana)
+};
+
+/** Stan kalkulatora: stos, stan parsera oraz bufory wejścia i wyjścia */
+struct Calc {
+	Stack stack; ///< stos wielomianów
+
+	unsigned row; ///< numer wiersza na którym jest parser (licząc od 0)
+	unsigned column; ///< numer kolumny parsera w miejscu column_mark
+	const char *column_mark; ///< miejsce w buforze wejścia, do którego odnosi się column
+	enum error_flag_e error_flag; ///< flaga ostatnio wykrytego i nieobsłużoneo błędu
+	enum error_flag_e status; ///< flaga błędu, z którą zakończyło się ostatnie wejście (zob. CalcStatus)
+	bool end_of_line; ///< flaga wskazująca osiągnięcie końca wiersza
+
+	/* Input is read in blocks; the parser scans the buffer with a pointer */
+	char *input_buffer; ///< ostatnio wczytany blok strumienia (INPUT_BUFFER_SIZE bajtów)
+	const char *input_pos; ///< następny znak do przeczytania
+	const char *input_end; ///< koniec wczytanych danych
+	bool input_eof; ///< czy próbowano czytać za końcem wejścia
+	bool input_interactive; ///< czy wejście jest terminalem (czytamy wtedy po linii)
+	FILE *input_file; ///< czytany strumień (NULL – wejście przekazywane przez CalcFeed)
+	size_t input_left; ///< ile bajtów strumienia można jeszcze wczytać
+	WorkStack input_fed; ///< przekazane przez CalcFeed bajty, które nie tworzą jeszcze pełnej linii (ramki)
+	bool input_broken; ///< czy w wejściu binarnym nie da się już odnaleźć początku ramki
+	enum calc_mode_e mode; ///< tryb wejścia przekazywanego przez CalcFeed
+
+	/* Output is collected in a buffer and handed to the writer in large blocks */
+	char *output_buffer; ///< tekst czekający na wypisanie (OUTPUT_BUFFER_SIZE bajtów)
+	size_t output_len; ///< długość tekstu w output_buffer
+	bool output_interactive; ///< czy wypisujemy wyjście po każdej linii
+	CalcWriter out; ///< odbiorca wyjścia
+	CalcWriter err; ///< odbiorca komunikatów o błędach
+	void *user; ///< dane przekazywane odbiorcom
+
+	bool binary_mode; ///< czy wejście i wyjście są w formacie binarnym (poly_wire.h)
+	size_t frame_left; ///< liczba bajtów wczytywanej ramki, które zostały do przeczytania
+	WorkStack wire_frame; ///< treść budowanej ramki wyjściowej (bajty)
+	enum wire_sink_e wire_sink; ///< dokąd trafia treść ramki wyjściowej
+	size_t wire_length; ///< liczba bajtów zliczonych przy WIRE_SINK_COUNT (razem z już zbuforowanymi)
+
+	Stack *chain_results; ///< stos następnego kroku łańcucha, na który trafiają wyniki komend (NULL – wypisujemy je)
+	Ring *print_ring; ///< kolejka wyników do wątku drukującego potoku (PrintJob; NULL – drukujemy od razu)
+	struct Program *program; ///< program, do którego trafiają komendy zamiast wykonania (NULL – wykonujemy je)
+
+	/* Working stacks of the iterative parser and printer, reused between calls */
+	WorkStack print_stack; ///< elementy czekające na wydrukowanie (PrintItem)
+	WorkStack parse_stack; ///< poziomy wczytywanego wielomianu (ParseLevel)
+	WorkStack parse_monos; ///< jednomiany wszystkich poziomów wczytywanego wielomianu (Mono)
+};
+
+/** Rodzaje wyników przekazywanych do drukowania w potoku */
+enum print_job_e {
+	JOB_INT, ///< liczba
+	JOB_POLY, ///< wielomian
+	JOB_MUL, ///< iloczyn dwóch wielomianów (MUL_PRINT)
+	JOB_ERROR, ///< komunikat o błędzie
+	JOB_DROP, ///< wielomian zdjęty ze stosu, do usunięcia po wcześniejszych wynikach
+	JOB_END ///< koniec wyników
+};
+
+/** Wynik komendy przekazywany do drukowania w potoku */
+typedef struct PrintJob {
+	enum print_job_e kind; ///< rodzaj wyniku
+	long v; ///< liczba (JOB_INT)
+	Poly p; ///< wielomian leżący na stosie (JOB_POLY), pierwszy czynnik (JOB_MUL, na własność) albo wielomian do usunięcia (JOB_DROP)
+	Poly q; ///< drugi czynnik (JOB_MUL), na własność
+	enum error_flag_e error; ///< flaga błędu (JOB_ERROR)
+	unsigned row; ///< wiersz błędu (JOB_ERROR)
+	unsigned column; ///< kolumna błędu (JOB_ERROR)
+} PrintJob;
+
+/* Dummy structs for quick escape from functions on error */
+static Poly DUMMY_POLY; ///< stała zwracana przez funkcje typu Poly w trakcie ucieczki z błędu
+
+/**
+ * Zwraca numer kolumny, na której jest parser. Liczony jest tylko wtedy,
+ * gdy jest potrzebny, z odległości od column_mark.
+ * @param[in,out] calc : kalkulator
+ * @return numer kolumny
+ */
+static unsigned Column(Calc *calc) {
+	return calc->column + (unsigned) (calc->input_pos - calc->column_mark);
+}
+
+/**
+ * Ustawia numer kolumny, na której jest parser.
+ * @param[in,out] calc : kalkulator
+ * @param[in] c : numer kolumny
+ */
+static void ColumnSet(Calc *calc, unsigned c) {
+	calc->column = c;
+	calc->column_mark = calc->input_pos;
+}
+
+/**
+ * Ustawia flagę błędu.
+ * Ustawienie flagi błędu powinno wywołać jak najszybszą ucieczkę z kolejnych
+ * kontekstów aż do osiągnięcia main(), gdzie błąd będzie obsłużony przez
+ * ErrorHandle()
+ * @param[in,out] calc : kalkulator
+ * @param[in] flag : flaga błędu
+ */
+static void ErrorSetFlag(Calc *calc, enum error_flag_e flag) {
+	calc->error_flag = flag;
+}
+
+/**
+ * Informuje o nieobsłużonych błędach.
+ * Funkcje po wywołaniu innej funkcji sprawdzają Error() i w razie wystąpienia
+ * błędu jak najszybciej 'propagują go' wyżej
+ * @param[in,out] calc : kalkulator
+ * @return obecnie ustawiona flaga błędu (0, jeżeli błąd jeszcze nie wystąpił)
+ */
+static int Error(Calc *calc) {
+	return calc->error_flag;
+}
+
+/**
+ * Przekazuje odbiorcy wyjścia zawartość bufora wyjścia i opróżnia go.
+ * @param[in,out] calc : kalkulator
+ */
+static void OutputFlush(Calc *calc);
+
+/**
+ * Przekazuje odbiorcy komunikatów o błędach informację o błędzie.
+ * Wcześniejsze wyniki są najpierw przekazywane odbiorcy wyjścia, żeby
+ * wyjście i błędy zachowały kolejność, także we wspólnym odbiorcy.
+ * @param[in,out] calc : kalkulator
+ * @param[in] flag : flaga błędu
+ * @param[in] r : numer wiersza (licząc od 0)
+ * @param[in] c : numer kolumny (tylko dla błędów parsowania)
+ */
+static void ErrorReportWrite(Calc *calc, enum error_flag_e flag, unsigned r,
+							 unsigned c) {
+	char message[64];
+	int len;
+	switch (flag) {
+	case UNDERFLOW_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d STACK UNDERFLOW\n", r + 1);
+		break;
+	case PARSING_ERR_FLAG:
+	case TOO_BIG_NUMBER_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d %d\n", r + 1, c);
+		break;
+	case WRONG_COMMAND_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d WRONG COMMAND\n", r + 1);
+		break;
+	case WRONG_VALUE_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d WRONG VALUE\n", r + 1);
+		break;
+	case WRONG_VARIABLE_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d WRONG VARIABLE\n", r + 1);
+		break;
+	case WRONG_COUNT_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d WRONG COUNT\n", r + 1);
+		break;		
+	case WRONG_FILE_ERR_FLAG:
+		len = snprintf(message, sizeof(message), "ERROR %d WRONG FILE\n", r + 1);
+		break;
+	default:
+		return;
+	}
+	OutputFlush(calc);
+	calc->err(message, len, calc->user);
+}
+
+/**
+ * Zgłasza błąd. W potoku komunikat przechodzi przez kolejkę wyników, żeby
+ * wątek drukujący wypisał go po wynikach wcześniejszych komend.
+ * @param[in,out] calc : kalkulator
+ * @param[in] flag : flaga błędu
+ * @param[in] r : numer wiersza (licząc od 0)
+ * @param[in] c : numer kolumny (tylko dla błędów parsowania)
+ */
+static void ErrorReport(Calc *calc, enum error_flag_e flag, unsigned r, unsigned c) {
+	if (calc->print_ring != NULL) {
+		RingPush(calc->print_ring, &(PrintJob) {.kind = JOB_ERROR, .error = flag,
+												.row = r, .column = c});
+		return;
+	}
+	ErrorReportWrite(calc, flag, r, c);
+}
+
+/**
+ * Obsługuje błąd – akcja zależy od ustawionej flagi błędu.
+ * W kontekscie zadania jedynie przekazuje informację odbiorcy komunikatów
+ * o błędach i resetuje flagę.
+ * @param[in,out] calc : kalkulator
+ */
+static void ErrorHandle(Calc *calc) {
+	bool parsing = calc->error_flag == PARSING_ERR_FLAG ||
+		calc->error_flag == TOO_BIG_NUMBER_ERR_FLAG;
+	ErrorReport(calc, calc->error_flag, calc->row, parsing ? Column(calc) : 0);
+	calc->error_flag = 0;
+}
+
+/**
+ * Przekazuje napis odbiorcy komunikatów o błędach (po wcześniejszych
+ * wynikach, zob. ErrorReport).
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : napis
+ */
+static void ErrorWrite(Calc *calc, const char *s) {
+	OutputFlush(calc);
+	calc->err(s, strlen(s), calc->user);
+}
+
+/* * * OUTPUT FUNCTIONS * * */
+
+/**
+ * Przekazuje znaki odbiorcy wyjścia z pominięciem bufora wyjścia.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : znaki
+ * @param[in] n : liczba znaków
+ */
+static void OutputRaw(Calc *calc, const char *s, size_t n) {
+	if (n > 0) {
+		calc->out(s, n, calc->user);
+	}
+}
+
+/**
+ * Przekazuje odbiorcy wyjścia zawartość bufora wyjścia i opróżnia go.
+ * @param[in,out] calc : kalkulator
+ */
+static void OutputFlush(Calc *calc) {
+	OutputRaw(calc, calc->output_buffer, calc->output_len);
+	calc->output_len = 0;
+}
+
+/**
+ * Dopisuje znaki do bufora wyjścia.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : znaki
+ * @param[in] n : liczba znaków
+ */
+static void OutputWrite(Calc *calc, const char *s, size_t n) {
+	if (calc->output_len + n > OUTPUT_BUFFER_SIZE) {
+		OutputFlush(calc);
+		if (n > OUTPUT_BUFFER_SIZE) {
+			OutputRaw(calc, s, n);
+			return;
+		}
+	}
+	memcpy(calc->output_buffer + calc->output_len, s, n);
+	calc->output_len += n;
+}
+
+/**
+ * Dopisuje napis do bufora wyjścia.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : napis
+ */
+static void OutputString(Calc *calc, const char *s) {
+	OutputWrite(calc, s, strlen(s));
+}
+
+/**
+ * Dopisuje liczbę całkowitą do bufora wyjścia.
+ * @param[in,out] calc : kalkulator
+ * @param[in] v : liczba
+ */
+static void IntPrint(Calc *calc, long v) {
+	char digits[21];
+	int i = sizeof(digits);
+	unsigned long u = v < 0 ? -(unsigned long) v : (unsigned long) v;
+	do {
+		digits[--i] = '0' + u % 10;
+		u /= 10;
+	} while (u != 0);
+	if (v < 0) {
+		digits[--i] = '-';
+	}
+	OutputWrite(calc, digits + i, sizeof(digits) - i);
+}
+
+/**
+ * Dopisuje bajty do treści budowanej ramki wyjściowej (tryb binarny).
+ * @param[in,out] calc : kalkulator
+ * @param[in] b : bajty
+ * @param[in] n : liczba bajtów
+ */
+static void WireWrite(Calc *calc, const unsigned char *b, size_t n) {
+	switch (calc->wire_sink) {
+	case WIRE_SINK_BUDGET:
+		if (calc->wire_frame.count + n > MUL_PRINT_FRAME_BUDGET) {
+			calc->wire_sink = WIRE_SINK_COUNT;
+			calc->wire_length = calc->wire_frame.count + n;
+			break;
+		}
+		/* fall through */
+	case WIRE_SINK_FRAME:
+		for (size_t i = 0; i < n; i++) {
+			*(unsigned char *) WorkStackPush(&calc->wire_frame, 1) = b[i];
+		}
+		break;
+	case WIRE_SINK_COUNT:
+		calc->wire_length += n;
+		break;
+	case WIRE_SINK_OUTPUT:
+		OutputWrite(calc, (const char *) b, n);
+		break;
+	}
+}
+
+/**
+ * Dopisuje liczbę varint do treści budowanej ramki wyjściowej.
+ * @param[in,out] calc : kalkulator
+ * @param[in] v : liczba
+ */
+static void WireVarintPut(Calc *calc, uint64_t v) {
+	unsigned char buf[WIRE_VARINT_MAX_BYTES];
+	WireWrite(calc, buf, WireVarintEncode(v, buf));
+}
+
+/**
+ * Rozpoczyna drukowanie wyniku komendy (w trybie binarnym nową ramkę).
+ * @param[in,out] calc : kalkulator
+ * @param[in] tag : rodzaj wyniku
+ */
+static void ResultBegin(Calc *calc, enum wire_reply_e tag) {
+	if (calc->binary_mode) {
+		calc->wire_frame.count = 0;
+		WireVarintPut(calc, tag);
+	}
+}
+
+/**
+ * Kończy drukowanie wyniku komendy: w trybie tekstowym znakiem nowej linii,
+ * a w trybie binarnym wypisaniem ramki poprzedzonej jej długością.
+ * @param[in,out] calc : kalkulator
+ */
+static void ResultEnd(Calc *calc) {
+	if (calc->binary_mode) {
+		unsigned char len[WIRE_VARINT_MAX_BYTES];
+		OutputWrite(calc, (char *) len, WireVarintEncode(calc->wire_frame.count, len));
+		OutputWrite(calc, calc->wire_frame.items, calc->wire_frame.count);
+	} else {
+		OutputString(calc, "\n");
+	}
+}
+
+/**
+ * Wypisuje liczbę całkowitą będącą wynikiem komendy.
+ * @param[in,out] calc : kalkulator
+ * @param[in] v : liczba
+ */
+static void ResultIntWrite(Calc *calc, long v) {
+	ResultBegin(calc, WIRE_REPLY_INT);
+	if (calc->binary_mode) {
+		WireVarintPut(calc, WireZigzagEncode(v));
+	} else {
+		IntPrint(calc, v);
+	}
+	ResultEnd(calc);
+}
+
+/**
+ * Drukuje liczbę całkowitą będącą wynikiem komendy.
+ * @param[in,out] calc : kalkulator
+ * @param[in] v : liczba
+ */
+static void ResultIntPrint(Calc *calc, long v) {
+	if (calc->chain_results != NULL) {
+		Poly p = PolyFromCoeff(CoeffFromInt(v));
+		Push(calc->chain_results, &p);
+		return;
+	}
+	if (calc->print_ring != NULL) {
+		RingPush(calc->print_ring, &(PrintJob) {.kind = JOB_INT, .v = v});
+		return;
+	}
+	ResultIntWrite(calc, v);
+}
+
+/**
+ * Drukuje wartość logiczną ze znakiem nowej linii.
+ * @param[in,out] calc : kalkulator
+ * @param[in] val : wartość do wydrukowania
+ */
+static void BoolPrint(Calc *calc, bool val) {
+	ResultIntPrint(calc, val ? 1 : 0);
+}
+
+/**
+ * Drukuje wielomiam.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian do wydrukowania
+ */
+static void PolyPrint(Calc *calc, Poly *p);
+
+/**
+ * Drukuje współczynnik.
+ * @param[in,out] calc : kalkulator
+ * @param[in] c : współczynnik do wydrukowania
+ */
+static void CoeffPrint(Calc *calc, poly_coeff_t c) {
+	/* cyfry zapisujemy od końca; moduł każdego współczynnika (także
+	 * __int128) mieści się w poly_ucoeff_t */
+	char digits[41];
+	int i = sizeof(digits);
+	poly_ucoeff_t u = c < 0 ? -(poly_ucoeff_t) c : (poly_ucoeff_t) c;
+	do {
+		digits[--i] = '0' + u % 10;
+		u /= 10;
+	} while (u != 0);
+	if (c < 0) {
+		digits[--i] = '-';
+	}
+	OutputWrite(calc, digits + i, sizeof(digits) - i);
+}
+
+/**
+ * Drukuje koniec jednomianu: ",wykładnik)".
+ * @param[in,out] calc : kalkulator
+ * @param[in] exp : wykładnik jednomianu
+ */
+static void MonoTailPrint(Calc *calc, poly_exp_t exp) {
+	OutputWrite(calc, ",", 1);
+	IntPrint(calc, exp);
+	OutputWrite(calc, ")", 1);
+}
+
+/* Elementy drukowanego wielomianu; każda funkcja drukuje je w formacie
+ * tekstowym albo binarnym (zob. poly_wire.h) */
+
+/**
+ * Drukuje wielomian będący stałą.
+ * @param[in,out] calc : kalkulator
+ * @param[in] c : współczynnik
+ */
+static void PrintConst(Calc *calc, poly_coeff_t c) {
+	if (calc->binary_mode) {
+		unsigned char buf[WIRE_VARINT_MAX_BYTES];
+		WireVarintPut(calc, 0);
+		WireWrite(calc, buf, WireCoeffEncode(c, buf));
+	} else {
+		CoeffPrint(calc, c);
+	}
+}
+
+/**
+ * Drukuje początek jednomianu (przed jego współczynnikiem).
+ * @param[in,out] calc : kalkulator
+ * @param[in] exp : wykładnik jednomianu
+ * @param[in] plus : czy jednomian nie jest pierwszy w sumie
+ */
+static void PrintMonoOpen(Calc *calc, poly_exp_t exp, bool plus) {
+	if (calc->binary_mode) {
+		WireVarintPut(calc, (uint64_t) exp + 1);
+	} else {
+		OutputString(calc, plus ? "+(" : "(");
+	}
+}
+
+/**
+ * Drukuje koniec jednomianu (po jego współczynniku).
+ * @param[in,out] calc : kalkulator
+ * @param[in] exp : wykładnik jednomianu
+ */
+static void PrintMonoClose(Calc *calc, poly_exp_t exp) {
+	if (!calc->binary_mode) {
+		MonoTailPrint(calc, exp);
+	}
+}
+
+/**
+ * Drukuje koniec sumy jednomianów.
+ * @param[in,out] calc : kalkulator
+ */
+static void PrintMonosEnd(Calc *calc) {
+	if (calc->binary_mode) {
+		WireVarintPut(calc, 0);
+	}
+}
+
+/**
+ * Drukuje jednomian `c * x^0` o stałym współczynniku.
+ * @param[in,out] calc : kalkulator
+ * @param[in] c : współczynnik
+ * @param[in] plus : czy jednomian nie jest pierwszy w sumie
+ */
+static void ScalarMonoPrint(Calc *calc, poly_coeff_t c, bool plus) {
+	PrintMonoOpen(calc, 0, plus);
+	PrintConst(calc, c);
+	PrintMonoClose(calc, 0);
+}
+
+/**
+ * Drukuje jednomian.
+ * @param[in,out] calc : kalkulator
+ * @param[in] m : jednomian do wydrukowania
+ * @param[in] plus : czy jednomian nie jest pierwszy w sumie
+ */
+static void MonoPrint(Calc *calc, Mono *m, bool plus) {
+	PrintMonoOpen(calc, m->exp, plus);
+	PolyPrint(calc, &(m->p));
+	PrintMonoClose(calc, m->exp);
+}
+
+/** Rodzaje elementów drukowanych przez PolyPrint */
+enum print_item_e {
+	PRINT_POLY, ///< wielomian
+	PRINT_OPEN, ///< początek jednomianu, ewentualnie poprzedzony "+"
+	PRINT_CLOSE, ///< wykładnik i koniec jednomianu
+	PRINT_END ///< koniec sumy jednomianów
+};
+
+/** Element czekający na wydrukowanie przez PolyPrint */
+typedef struct PrintItem {
+	enum print_item_e kind; ///< rodzaj elementu
+	const Poly *p; ///< drukowany wielomian (PRINT_POLY)
+	poly_coeff_t scalar; ///< wyraz wolny, drukowany zamiast p->scalar
+	unsigned skip; ///< skip, używane zamiast p->skip
+	poly_exp_t exp; ///< wykładnik jednomianu (PRINT_OPEN, PRINT_CLOSE)
+	bool plus; ///< czy poprzedzić jednomian "+" (PRINT_OPEN)
+} PrintItem;
+
+/**
+ * Odkłada element na stos drukowania.
+ * @param[in,out] calc : kalkulator
+ * @param[in] item : element
+ */
+static void PrintItemPush(Calc *calc, PrintItem item) {
+	*(PrintItem *) WorkStackPush(&calc->print_stack, sizeof(PrintItem)) = item;
+}
+
+/**
+ * Drukuje wielomian @p p o wyrazie wolnym @p scalar i pominiętych zmiennych
+ * @p skip, odkładając na stos drukowania to, co drukuje się w głębszych
+ * poziomach.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian
+ * @param[in] scalar : wyraz wolny
+ * @param[in] skip : liczba pominiętych zmiennych
+ */
+static void PolyPrintLevel(Calc *calc, const Poly *p, poly_coeff_t scalar, unsigned skip) {
+	if (PolyIsCoeff(p)) {
+		PrintConst(calc, scalar);
+		return;
+	}
+
+	/* pominięte zmienne drukujemy jako zagnieżdżone jednomiany (...,0) */
+	if (skip > 0) {
+		if (scalar != 0) {
+			ScalarMonoPrint(calc, scalar, false);
+		}
+		PrintMonoOpen(calc, 0, scalar != 0);
+		PrintItemPush(calc, (PrintItem) {PRINT_END, NULL, 0, 0, 0, false});
+		PrintItemPush(calc, (PrintItem) {PRINT_CLOSE, NULL, 0, 0, 0, false});
+		PrintItemPush(calc, (PrintItem) {PRINT_POLY, p, 0, skip - 1, 0, false});
+		return;
+	}
+
+	/* Wielomian w naszej implementacji mógłby chcieć się wydrukwać jako np.
+	 * "7+(((1,1),0)+(2,2),0)+(2,3)"
+	 * a powinien
+	 * "(((7,0)+(1,1),0)+(2,2),0)+(2,3)"
+	 * Skalar przenosimy więc do współczynnika jednomianu o wykładniku 0,
+	 * podając go przy drukowaniu tego współczynnika.
+	 */
+	poly_coeff_t first_scalar = p->monos[0].p.scalar;
+	if (scalar != 0 && p->monos_count > 1 && p->monos[0].exp == 0) {
+		first_scalar = CoeffAdd(first_scalar, scalar);
+		scalar = 0;
+	}
+
+	/* jeżeli został jakiś skalar, to znaczy ze nie było jednomianu
+	 * z exp = 0 gdzie trzeba by go było wsadzić */
+	if (scalar != 0) {
+		ScalarMonoPrint(calc, scalar, false);
+	}
+	PrintItemPush(calc, (PrintItem) {PRINT_END, NULL, 0, 0, 0, false});
+	for (unsigned i = p->monos_count; i-- > 0;) {
+		const Poly *c = &(p->monos[i].p);
+		poly_exp_t exp = p->monos[i].exp;
+		PrintItemPush(calc, (PrintItem) {PRINT_CLOSE, NULL, 0, 0, exp, false});
+		PrintItemPush(calc, (PrintItem) {PRINT_POLY, c,
+								   i == 0 ? first_scalar : c->scalar, c->skip,
+								   0, false});
+		PrintItemPush(calc, (PrintItem) {PRINT_OPEN, NULL, 0, 0, exp,
+								   i > 0 || scalar != 0});
+	}
+}
+
+/**
+ * Drukuje wielomian bez rekurencji: poziomy wielomianu czekające na
+ * wydrukowanie leżą na stosie drukowania.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian do wydrukowania
+ */
+static void PolyPrint(Calc *calc, Poly *p) {
+	size_t base = calc->print_stack.count;
+	PrintItemPush(calc, (PrintItem) {PRINT_POLY, p, p->scalar, p->skip, 0, false});
+	while (calc->print_stack.count > base) {
+		PrintItem item = *(PrintItem *) WorkStackPop(&calc->print_stack,
+													 sizeof(PrintItem));
+		switch (item.kind) {
+		case PRINT_POLY:
+			PolyPrintLevel(calc, item.p, item.scalar, item.skip);
+			break;
+		case PRINT_OPEN:
+			PrintMonoOpen(calc, item.exp, item.plus);
+			break;
+		case PRINT_CLOSE:
+			PrintMonoClose(calc, item.exp);
+			break;
+		case PRINT_END:
+			PrintMonosEnd(calc);
+			break;
+		}
+	}
+}
+
+/** Stan drukowania iloczynu wyliczanego jednomian po jednomianie */
+typedef struct StreamPrinter {
+	Calc *calc; ///< kalkulator, który drukuje iloczyn
+	bool has_pending; ///< czy wstrzymano pierwszy jednomian
+	Mono pending; ///< wstrzymany pierwszy jednomian
+	size_t printed; ///< liczba wydrukowanych jednomianów
+} StreamPrinter;
+
+/**
+ * Drukuje pierwszy jednomian iloczynu tak, jak zrobiłby to PolyPrint.
+ * Jednomian o wykładniku 0 zawiera wyraz wolny, który PolyPrint drukuje
+ * wewnątrz tego jednomianu tylko wtedy, gdy wielomian ma więcej jednomianów.
+ * @param[in,out] calc : kalkulator
+ * @param[in] m : jednomian
+ * @param[in] more : czy po nim są kolejne jednomiany
+ * @return Czy wydrukowano sumę jednomianów (a nie stałą)?
+ */
+static bool StreamPrintFirstMono(Calc *calc, Mono *m, bool more) {
+	Poly *c = &(m->p);
+	if (m->exp != 0 || c->scalar == 0) {
+		MonoPrint(calc, m, false);
+	} else if (PolyIsCoeff(c)) {
+		if (more) {
+			ScalarMonoPrint(calc, c->scalar, false);
+		} else {
+			PrintConst(calc, c->scalar);
+			return false;
+		}
+	} else if (more) {
+		MonoPrint(calc, m, false);
+	} else {
+		poly_coeff_t scalar = c->scalar;
+		ScalarMonoPrint(calc, scalar, false);
+		c->scalar = 0;
+		MonoPrint(calc, m, true);
+		c->scalar = scalar;
+	}
+	return true;
+}
+
+/**
+ * Drukuje kolejny jednomian iloczynu i usuwa go z pamięci.
+ * Pierwszy jednomian jest wstrzymywany do czasu, aż wiadomo, czy jest jedyny.
+ * @param[in] m : jednomian
+ * @param[in] data : stan drukowania (StreamPrinter)
+ */
+static void StreamPrintMono(Mono *m, void *data) {
+	StreamPrinter *printer = data;
+	if (printer->printed == 0 && !printer->has_pending) {
+		printer->pending = *m;
+		printer->has_pending = true;
+		return;
+	}
+	if (printer->has_pending) {
+		StreamPrintFirstMono(printer->calc, &(printer->pending), true);
+		MonoDestroy(&(printer->pending));
+		printer->has_pending = false;
+		printer->printed++;
+	}
+	MonoPrint(printer->calc, m, true);
+	MonoDestroy(m);
+	printer->printed++;
+}
+
+/**
+ * Drukuje iloczyn dwóch wielomianów bez tworzenia go w pamięci.
+ * Format jest taki sam jak PolyPrint.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ */
+static void PolyMulPrint(Calc *calc, const Poly *p, const Poly *q) {
+	StreamPrinter printer;
+	printer.calc = calc;
+	printer.has_pending = false;
+	printer.printed = 0;
+
+	PolyMulForEach(p, q, StreamPrintMono, &printer);
+
+	if (printer.has_pending) {
+		if (StreamPrintFirstMono(calc, &(printer.pending), false)) {
+			PrintMonosEnd(calc);
+		}
+		MonoDestroy(&(printer.pending));
+	} else if (printer.printed == 0) {
+		PrintConst(calc, 0);
+	} else {
+		PrintMonosEnd(calc);
+	}
+}
+
+/**
+ * Wypisuje iloczyn dwóch wielomianów jako wynik komendy MUL_PRINT.
+ * W trybie binarnym długość ramki poprzedza jej treść, więc ramka jest
+ * budowana w pamięci, dopóki nie przekroczy MUL_PRINT_FRAME_BUDGET bajtów.
+ * Dłuższą ramkę dalej tylko zliczamy, a potem wyliczamy iloczyn drugi raz,
+ * wypisując go prosto do bufora wyjścia – pamięć nie rośnie z rozmiarem
+ * iloczynu, ale praca się podwaja.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ */
+static void ResultMulPrint(Calc *calc, const Poly *p, const Poly *q) {
+	if (!calc->binary_mode) {
+		PolyMulPrint(calc, p, q);
+		OutputString(calc, "\n");
+		return;
+	}
+
+	calc->wire_frame.count = 0;
+	calc->wire_sink = WIRE_SINK_BUDGET;
+	WireVarintPut(calc, WIRE_REPLY_POLY);
+	PolyMulPrint(calc, p, q);
+	if (calc->wire_sink == WIRE_SINK_BUDGET) {
+		calc->wire_sink = WIRE_SINK_FRAME;
+		ResultEnd(calc);
+		return;
+	}
+
+	unsigned char len[WIRE_VARINT_MAX_BYTES];
+	OutputWrite(calc, (char *) len, WireVarintEncode(calc->wire_length, len));
+	calc->wire_sink = WIRE_SINK_OUTPUT;
+	WireVarintPut(calc, WIRE_REPLY_POLY);
+	PolyMulPrint(calc, p, q);
+	calc->wire_sink = WIRE_SINK_FRAME;
+}
+
+
+/* * * INPUT FUNCTIONS * * */
+
+/**
+ * Wczytuje do bufora wejścia kolejny blok strumienia (z terminala kolejną
+ * linię, żeby nie czekać na resztę wejścia). Wywoływana, gdy bufor jest
+ * pusty. Wejście przekazane przez CalcFeed jest w całości w buforze, więc
+ * wtedy oznacza tylko jego koniec.
+ * @param[in,out] calc : kalkulator
+ * @return Czy wczytano jakiś znak?
+ */
+static bool InputFill(Calc *calc) {
+	calc->column += (unsigned) (calc->input_pos - calc->column_mark);
+	if (calc->input_file == NULL) {
+		calc->column_mark = calc->input_pos;
+		calc->input_eof = true;
+		return false;
+	}
+
+	size_t n;
+	if (calc->input_interactive) {
+		n = fgets(calc->input_buffer, INPUT_BUFFER_SIZE, calc->input_file) != NULL ?
+			strlen(calc->input_buffer) : 0;
+	} else {
+		n = fread(calc->input_buffer, 1, calc->input_left < INPUT_BUFFER_SIZE ?
+				  calc->input_left : INPUT_BUFFER_SIZE, calc->input_file);
+		calc->input_left -= n;
+	}
+	calc->input_pos = calc->input_buffer;
+	calc->input_end = calc->input_buffer + n;
+	calc->column_mark = calc->input_buffer;
+
+	if (n == 0 && (calc->input_left == 0 || feof(calc->input_file))) {
+		calc->input_eof = true;
+	}
+	return n > 0;
+}
+
+/**
+ * Przygotowuje bufor wejścia do czytania strumienia.
+ * @param[in,out] calc : kalkulator
+ * @param[in] file : strumień
+ * @param[in] limit : liczba bajtów do przeczytania (SIZE_MAX – do końca)
+ */
+static void InputInit(Calc *calc, FILE *file, size_t limit) {
+	if (calc->input_buffer == NULL) {
+		calc->input_buffer = malloc(INPUT_BUFFER_SIZE);
+		assert(calc->input_buffer != NULL);
+	}
+	calc->input_file = file;
+	calc->input_left = limit;
+	/* ramki binarne mogą zawierać bajty 0, więc czytamy je zawsze blokami */
+	calc->input_interactive = !calc->binary_mode && limit == SIZE_MAX &&
+		isatty(fileno(file));
+	calc->input_pos = calc->input_end = calc->input_buffer;
+	calc->input_eof = false;
+	ColumnSet(calc, 0);
+}
+
+/**
+ * Podgląda następny znak z stdin bez usuwania go ze strumienia.
+ * @param[in,out] calc : kalkulator
+ * @return znak na stdin
+ */
+static int SeeChar(Calc *calc) {
+	if (calc->input_pos == calc->input_end) {
+		if (calc->input_eof) {
+			ErrorSetFlag(calc, PARSING_ERR_FLAG);
+			return EOF;
+		}
+		if (!InputFill(calc)) {
+			return EOF;
+		}
+	}
+	return (unsigned char) *calc->input_pos;
+}
+
+/**
+ * Jak getchar(), plus aktualizuje stan parsera.
+ * @param[in,out] calc : kalkulator
+ * @return getchar()
+ */
+static int GetChar(Calc *calc) {
+	if (calc->input_pos == calc->input_end && !InputFill(calc)) {
+		calc->end_of_line = false;
+		calc->column++;
+		return EOF;
+	}
+	int ch = (unsigned char) *(calc->input_pos++);
+	calc->end_of_line = (ch == '\n');
+	return ch;
+}
+
+/**
+ * Pomija znak z stdin, nie licząc go do numeru kolumny.
+ * @param[in,out] calc : kalkulator
+ * @return pominięty znak
+ */
+static int SkipChar(Calc *calc) {
+	if (calc->input_pos == calc->input_end && !InputFill(calc)) {
+		return EOF;
+	}
+	calc->column_mark++;
+	return (unsigned char) *(calc->input_pos++);
+}
+
+/**
+ * Wczytuje z stdin linię (jak fgets()) do bufora komendy, nie licząc jej
+ * znaków do numeru kolumny.
+ * @param[in,out] calc : kalkulator
+ * @param[out] buf : bufor
+ * @param[in] size : rozmiar bufora
+ */
+static void LineRead(Calc *calc, char *buf, size_t size) {
+	unsigned c = Column(calc);
+	size_t len = 0;
+	while (len + 1 < size && (calc->input_pos < calc->input_end || InputFill(calc))) {
+		size_t n = calc->input_end - calc->input_pos;
+		if (n > size - 1 - len) {
+			n = size - 1 - len;
+		}
+		const char *nl = memchr(calc->input_pos, '\n', n);
+		if (nl != NULL) {
+			n = nl - calc->input_pos + 1;
+		}
+		memcpy(buf + len, calc->input_pos, n);
+		calc->input_pos += n;
+		len += n;
+		if (nl != NULL) {
+			break;
+		}
+	}
+	buf[len] = '\0';
+	ColumnSet(calc, c);
+}
+
+/**
+ * Przewija stdin do następnej linii.
+ * @param[in,out] calc : kalkulator
+ * @param[in] eof_flag : informuje fukcję wywołującą, czy napotkano End Of File
+ */
+static void GoToNextLine(Calc *calc, bool *eof_flag) {
+	/* check if we haven't already reached the end of the line */
+	if (calc->end_of_line) { return; }
+
+	int ch = SeeChar(calc);
+
+	/* W momencie wywołania tej funkcji, nie powinno być już znaków na stdin */
+	if (!Error(calc) && ch != '\n' && ch != EOF) {
+		ColumnSet(calc, Column(calc) + 1);
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+	}
+
+	while (Error(calc) && ch != '\n' && ch != EOF) {
+		SkipChar(calc);
+		ch = SeeChar(calc);
+		if (ch == EOF) {
+			*eof_flag = EOF_FLAG;
+			return;
+		}
+	}
+
+	ch = SkipChar(calc); // must be '\n' or End Of File
+	if (ch == EOF) {
+		*eof_flag = true;
+	}
+}
+
+/**
+ * Sprawdza, czy do liczby r można dokleić cyfrę bez przekraczania limitu
+ * @param[in,out] calc : kalkulator
+ * @param[in] r : liczba
+ * @param[in] digit : doklejana cyfra
+ * @param[in] max_val : limit
+ * @param[in] minus : określa czy badana liczba jest ujemna
+ */
+static void ValidateNextDigit(Calc *calc, poly_uinput_t r, int digit, bool minus,
+							  poly_uinput_t max_val) {
+	if (r > max_val / 10 ||
+			(r == max_val / 10 && (unsigned) digit > max_val % 10 + minus)) {
+		ErrorSetFlag(calc, TOO_BIG_NUMBER_ERR_FLAG);
+	}
+}
+
+/**
+ * Sprawdza, czy znak jest liczbą, bądź minusem
+ * @param[in] ch : znak
+ * @return : Czy znak jest liczbą lub minusem?
+ */
+static bool IsDigitOrMinus(int ch) {
+	return isdigit(ch) || ch == '-';
+}
+
+/**
+ * Wczytuje liczbę z tablicy znaków lub stdin, jeżeli nie podano tablicy
+ * @param[in,out] calc : kalkulator
+ * @param[in] c : tablica znaków
+ * @param[in] type : flaga typu liczby, słuzy do obsługi niepoprawnych wartości
+ * @return wczytana liczba
+ */
+static poly_input_t NumberRead(Calc *calc, char *c, enum int_type_e type) {
+	if ((c && !IsDigitOrMinus(c[0])) ||
+	   (!c && !IsDigitOrMinus(SeeChar(calc)))) {
+		if (!c) { GetChar(calc); }
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+
+	/* obsługa minusa */
+	bool minus = false;
+	if ((!c && SeeChar(calc) == '-') ||
+		(c && c[0] == '-')) {
+		if (type == POLY_EXP_T || type == UNSIGNED) {
+			ErrorSetFlag(calc, PARSING_ERR_FLAG);
+			return 0;
+		}
+
+		minus = true;
+		if (c) {
+			c++;
+		} else {
+			GetChar(calc); // '-'
+		}
+	}
+
+	poly_uinput_t max_val = 0;
+	switch (type) {
+	case POLY_EXP_T:
+		max_val = POLY_EXP_MAX;
+		break;
+	case POLY_COEFF_T:
+		max_val = POLY_COEFF_INPUT_MAX;
+		break;
+	case UNSIGNED:
+		max_val = UINT32_MAX;
+		break;
+	default:
+		assert(false);
+		break;
+	}
+
+	/* moduł liczby zbieramy bez znaku – mieści też moduł najmniejszej */
+	int digit;
+	poly_uinput_t r = 0;
+	if (c) {
+		while (isdigit(c[0])) {
+			digit = *(c++) - '0';
+			ValidateNextDigit(calc, r, digit, minus, max_val);
+			if (Error(calc)) { return 0; }
+			r = 10 * r + digit;
+		}
+
+		if (c[0] != '\0') {
+			ErrorSetFlag(calc, PARSING_ERR_FLAG);
+			return 0;
+		}
+	} else {
+		/* cyfry przeglądamy wprost w buforze wejścia, a SeeChar() doczytuje
+		 * kolejny blok, gdy ciąg cyfr dochodzi do końca bufora */
+		while (isdigit(SeeChar(calc))) {
+			calc->end_of_line = false;
+			while (calc->input_pos < calc->input_end && isdigit((unsigned char) *calc->input_pos)) {
+				digit = *(calc->input_pos++) - '0';
+				ValidateNextDigit(calc, r, digit, minus, max_val);
+				if (Error(calc)) { return 0; }
+				r = 10 * r + digit;
+			}
+		}
+	}
+
+	if (minus) {
+		return (poly_input_t) (0 - r);
+	}
+	return (poly_input_t) r;
+}
+
+/**
+ * Wczytuje liczbę z stdin
+ * @param[in,out] calc : kalkulator
+ * @param[in] type : flaga typu liczby, używana do obsługi błędnych wartości
+ * @return wczytana liczba
+ */
+static poly_input_t NumberParse(Calc *calc, int type) {
+	return NumberRead(calc, NULL, type);
+}
+
+/**
+ * Poziom wczytywanego wielomianu. Jednomiany wczytane do tej pory leżą
+ * na wspólnym dla wszystkich poziomów stosie `parse_monos`, od pozycji
+ * `first` do jego wierzchu.
+ */
+typedef struct ParseLevel {
+	size_t first; ///< pozycja pierwszego jednomianu poziomu w parse_monos
+} ParseLevel;
+
+/**
+ * Po błędzie usuwa poziomy wczytywanego wielomianu powyżej @p base razem
+ * z wczytanymi już jednomianami.
+ * @param[in,out] calc : kalkulator
+ * @param[in] base : liczba poziomów, które zostają na stosie
+ * @return DUMMY_POLY
+ */
+static Poly ParseLevelsDrop(Calc *calc, size_t base) {
+	if (calc->parse_stack.count == base) {
+		return DUMMY_POLY;
+	}
+	size_t first = ((ParseLevel *) calc->parse_stack.items)[base].first;
+	while (calc->parse_monos.count > first) {
+		MonoDestroy(WorkStackPop(&calc->parse_monos, sizeof(Mono)));
+	}
+	calc->parse_stack.count = base;
+	return DUMMY_POLY;
+}
+
+/**
+ * Wczytuje ze stdin koniec jednomianu po jego współczynniku: ",wykładnik)".
+ * @param[in,out] calc : kalkulator
+ * @return wykładnik jednomianu
+ */
+static poly_exp_t MonoTailParse(Calc *calc) {
+	if (GetChar(calc) != ',') {
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+
+	int ch = SeeChar(calc);
+	if (!IsDigitOrMinus(ch)) {
+		GetChar(calc);
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+
+	poly_exp_t e = NumberParse(calc, POLY_EXP_T);
+	if (Error(calc)) {
+		return 0;
+	}
+
+	if (GetChar(calc) != ')') {
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+	return e;
+}
+
+/**
+ * Wczytuje wielomian z stdin bez rekurencji: każdy otwarty jednomian to
+ * poziom na stosie parsera, zbierający jednomiany wielomianu, który jest
+ * współczynnikiem jednomianu poziom wyżej.
+ * @param[in,out] calc : kalkulator
+ * @return wczytany wielomian
+ */
+static Poly PolyParse(Calc *calc) {
+	size_t base = calc->parse_stack.count;
+
+	while (true) {
+		if (SeeChar(calc) == '(') { /* array of monos */
+			/* monos of the new level go on top of the shared scratch stack */
+			ParseLevel *level = WorkStackPush(&calc->parse_stack, sizeof(ParseLevel));
+			level->first = calc->parse_monos.count;
+
+			GetChar(calc); // '('
+			continue; // wczytujemy współczynnik pierwszego jednomianu
+		}
+
+		/* a scalar */
+		poly_coeff_t r = CoeffFromInt(NumberParse(calc, POLY_COEFF_T));
+		if (Error(calc)) {
+			return ParseLevelsDrop(calc, base);
+		}
+		Poly p = PolyFromCoeff(r);
+
+		/* p jest współczynnikiem jednomianu z najgłębszego poziomu */
+		while (calc->parse_stack.count > base) {
+			poly_exp_t e = 0;
+			if (!Error(calc)) {
+				e = MonoTailParse(calc);
+			}
+			if (Error(calc)) {
+				PolyDestroy(&p);
+				return ParseLevelsDrop(calc, base);
+			}
+
+			*(Mono *) WorkStackPush(&calc->parse_monos, sizeof(Mono)) =
+				MonoFromPoly(&p, e);
+
+			if (SeeChar(calc) == '+') {
+				GetChar(calc); // '+'
+				if (GetChar(calc) != '(') {
+					ErrorSetFlag(calc, PARSING_ERR_FLAG);
+					return ParseLevelsDrop(calc, base);
+				}
+				break; // wczytujemy współczynnik kolejnego jednomianu
+			}
+
+			/* probably ',' or '\n' or 'EOF': wielomian poziomu jest gotowy,
+			 * PolyAddMonos kopiuje jego jednomiany do tablicy wyniku */
+			ParseLevel *level = WorkStackPop(&calc->parse_stack, sizeof(ParseLevel));
+			p = PolyAddMonos(calc->parse_monos.count - level->first,
+							 (Mono *) calc->parse_monos.items + level->first);
+			calc->parse_monos.count = level->first;
+		}
+
+		if (calc->parse_stack.count == base) {
+			return p;
+		}
+	}
+}
+
+
+/* * * POLY OPERATIONS * * */
+
+/**
+ * jak GetTop(), ale sprawdza, czy na stosie jest wielomian
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @return GetTop(s)
+ */
+static Poly GetTopSafely(Calc *calc, Stack *s) {
+	if (IsEmpty(s)) {
+		ErrorSetFlag(calc, UNDERFLOW_ERR_FLAG);
+		return DUMMY_POLY;
+	}
+	return GetTop(s);
+}
+
+/**
+ * Jak Pop(), ale sprawdza czy na stosie jest wielomian do zrzucenia
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @return Pop(s)
+ */
+static Poly PopSafely(Calc *calc, Stack *s) {
+	if (IsEmpty(s)) {
+		ErrorSetFlag(calc, UNDERFLOW_ERR_FLAG);
+		return DUMMY_POLY;
+	}
+	return Pop(s);
+}
+
+/**
+ * Usuwa wielomian zdjęty ze stosu. W potoku wielomian na stosie mógł trafić
+ * do drukowania bez kopii, więc usuwa go wątek drukujący po wcześniejszych
+ * wynikach.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian
+ */
+static void OperandDrop(Calc *calc, Poly *p) {
+	if (calc->print_ring != NULL) {
+		RingPush(calc->print_ring, &(PrintJob) {.kind = JOB_DROP, .p = *p});
+		return;
+	}
+	PolyReclaim(p);
+}
+
+/**
+ * Działa operacją na dwóch wielomianach na wierzchu stosu i wynik wstawia na
+ * ich miejsce.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] op : działanie wielomian x wielomian → wielomian
+ */
+static void ActOnTwoPolysOnStack(Calc *calc, Stack *s,
+						  Poly (*op)(const Poly *, const Poly *)) {
+	Poly p = PopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	Poly q = PopSafely(calc, s);
+	if (Error(calc)) {
+		/* zwracamy p, żeby stos był w takim stanie jak przed errorem */
+		Push(s, &p);
+		return;
+	}
+
+	Poly r = op(&p, &q);
+	OperandDrop(calc, &p);
+	OperandDrop(calc, &q);
+
+	Push(s, &r);
+}
+
+/**
+ * Zastępuje dwa wielomiany na wierzchu stosu ich sumą
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void AddTwoPolysFromStack(Calc *calc, Stack *s) {
+	return ActOnTwoPolysOnStack(calc, s, PolyAdd);
+}
+
+/**
+ * Zastępuje dwa wielomiany na wierzchu stosu ich iloczynem
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void MultiplyTwoPolysFromStack(Calc *calc, Stack *s) {
+	return ActOnTwoPolysOnStack(calc, s, PolyMulCached);
+}
+
+/**
+ * Zdejmuje dwa wielomiany z wierzchu stosu i drukuje ich iloczyn, nie
+ * tworząc go w pamięci (odpowiednik MUL, PRINT, POP).
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void MultiplyAndPrintTwoPolysFromStack(Calc *calc, Stack *s) {
+	Poly p = PopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	Poly q = PopSafely(calc, s);
+	if (Error(calc)) {
+		Push(s, &p);
+		return;
+	}
+
+	if (calc->chain_results != NULL) {
+		Poly r = PolyMulCached(&p, &q);
+		Push(calc->chain_results, &r);
+	} else if (calc->print_ring != NULL) {
+		RingPush(calc->print_ring, &(PrintJob) {.kind = JOB_MUL, .p = p, .q = q});
+		return;
+	} else {
+		ResultMulPrint(calc, &p, &q);
+	}
+	PolyReclaim(&p);
+	PolyReclaim(&q);
+}
+
+/**
+ * Zastępuje dwa wielomiany na wierzchu stosu ich różnicą
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void SubtractTwoPolysFromStack(Calc *calc, Stack *s) {
+	return ActOnTwoPolysOnStack(calc, s, PolySub);
+}
+
+/**
+ * Drukuje, czy dwa wielomiany na wierzchu stosu są równe
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void PrintAreEqualTwoPolysFromStack(Calc *calc, Stack *s) {
+	Poly p = PopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	Poly q = GetTopSafely(calc, s);
+	if (Error(calc)) {
+		Push(s, &p);
+		return;
+	}
+
+	bool r = PolyIsEq(&p, &q);
+	Push(s, &p);
+	BoolPrint(calc, r);
+}
+
+/**
+ * Drukuje czy wielomian na wierzchu stosu jest skalarem
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void IsCoeffPolyOnStack(Calc *calc, Stack *s) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	BoolPrint(calc, PolyIsCoeff(&top));
+}
+
+/**
+ * Drukuje czy wielomian na wierzchu stosu jest zerem
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void IsZeroPolyOnStack(Calc *calc, Stack *s) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	BoolPrint(calc, PolyIsZero(&top));
+}
+
+/**
+ * Wrzuca na stos kopię wielomianu na wierzchu tego stosu
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void ClonePolyOnStack(Calc *calc, Stack *s) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	/* wielomian ze zrzutu i współdzielony wynik z pamięci podręcznej są tylko
+	   do odczytu, więc kopia może być płytka */
+	Poly p = PolySnapshotShare(&top) || PolyCacheShare(&top) ?
+			 top : PolyClone(&top);
+	Push(s, &p);
+}
+
+/**
+ * Zastępuje wielomian na wierzchu stosu jego przeciwieństwem
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void NegatePolyOnStack(Calc *calc, Stack *s) {
+	Poly p = PopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	Poly q = PolyNeg(&p);
+	OperandDrop(calc, &p);
+	Push(s, &q);
+}
+
+/**
+ * Drukuje stopień wielomianu znajdujacego się na wierzchu stosu
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void PrintDegreePolyOnStack(Calc *calc, Stack *s) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	ResultIntPrint(calc, PolyDeg(&top));
+}
+
+/**
+ * Drukuje wielomian znajdujący się na wierzchu stosu.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ */
+static void PrintPolyOnStack(Calc *calc, Stack *s) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	if (calc->chain_results != NULL) {
+		Poly p = PolySnapshotShare(&top) || PolyCacheShare(&top) ?
+				 top : PolyClone(&top);
+		Push(calc->chain_results, &p);
+		return;
+	}
+	if (calc->print_ring != NULL) {
+		/* wielomian zostaje na stosie aż do OperandDrop, który trafia do
+		   kolejki po tym wyniku, więc kopia nie jest potrzebna */
+		RingPush(calc->print_ring, &(PrintJob) {.kind = JOB_POLY, .p = top});
+		return;
+	}
+
+	ResultBegin(calc, WIRE_REPLY_POLY);
+	PolyPrint(calc, &top);
+	ResultEnd(calc);
+}
+
+/** Polecenie to zdejmuje z wierzchołka stosu najpierw wielomian p, a potem 
+ * kolejno wielomiany x[0], x[1], …, x[count - 1] i umieszcza na stosie wynik
+ * funkcji PolyCompose
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] count : liczba wielomianów do zmielenia
+*/
+static void ComposePolysOnStack(Calc *calc, Stack *s, unsigned count) {
+	if (!HasElements(s, 1)) {
+		ErrorSetFlag(calc, UNDERFLOW_ERR_FLAG);
+		return;
+	}
+
+	Poly p = Pop(s);
+
+	if (!HasElements(s, count)) {
+		ErrorSetFlag(calc, UNDERFLOW_ERR_FLAG);
+		Push(s, &p);
+		return;
+	}
+
+	Poly x[count];
+	for (unsigned i = 0; i < count; i++) {
+		x[i] = Pop(s);
+		if (i == UINT_MAX) {
+			break;
+		}
+	}
+	Poly r = PolyComposeCached(&p, count, x);
+	Push(s, &r);
+	
+	OperandDrop(calc, &p);
+	for (unsigned i = 0; i < count; i++) {
+		OperandDrop(calc, &(x[i]));
+		if (i == UINT_MAX) {
+			break;
+		}
+	}
+}
+
+/**
+ * Drukuje stopień wielomianu na wierzchu stosu ze względu na n-tą zmienną
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] n : n
+ */
+static void PrintDegBy(Calc *calc, Stack *s, unsigned n) {
+	Poly top = GetTopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	int r = PolyDegBy(&top, n);
+	ResultIntPrint(calc, r);
+}
+
+/**
+ * Zastępuje wielomian na wierzchu stosu jego "wartością w punkcie x"
+ * (obcięciem do zbioru `{(x_1, x_2, ...) : x_1 = x}`)
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] x : x
+ */
+static void CalculatePolyAt(Calc *calc, Stack *s, poly_coeff_t x) {
+
+
+	Poly top = PopSafely(calc, s);
+	if (Error(calc)) { return; }
+
+	Poly p = PolyAt(&top, x);
+	OperandDrop(calc, &top);
+	Push(s, &p);
+}
+
+/* * * COMPILATION * * */
+
+/*
+ * W trybie kompilacji (COMPILE_OPTION) całe wejście jest najpierw
+ * tłumaczone na ciąg instrukcji z wczytanymi już wielomianami i argumentami
+ * komend, a dopiero potem wykonywane. Błędy wykryte przy kompilacji też są
+ * instrukcjami, więc komunikaty pojawiają się w kolejności wykonania.
+ *
+ * Przy kompilacji znana jest liczba wielomianów na stosie (po LOAD – tylko
+ * jej dolne ograniczenie), a więc i to, które komendy na pewno się udadzą.
+ * Pozwala to usunąć obliczenia, których wynik zdejmuje POP (np. CLONE i POP
+ * znoszą się, a ADD i POP to dwa POP), i z góry powiększyć stos.
+ */
+
+/** Instrukcja skompilowanego programu */
+typedef struct Instr {
+	enum wire_op_e op; ///< kod operacji (WIRE_POLY – odłożenie wielomianu)
+	enum error_flag_e error; ///< błąd wykryty przy kompilacji (NO_ERROR, gdy instrukcja jest komendą)
+	unsigned row; ///< wiersz wejścia, z którego pochodzi instrukcja
+	bool safe; ///< czy na stosie na pewno będzie dość wielomianów
+	/** argument instrukcji */
+	union {
+		unsigned n; ///< argument DEG_BY i COMPOSE
+		poly_coeff_t x; ///< argument AT
+		char *path; ///< argument SAVE i LOAD
+		Poly p; ///< wielomian odkładany przez WIRE_POLY
+		unsigned column; ///< kolumna błędu
+	} arg;
+} Instr;
+
+/** Kompilowany program */
+typedef struct Program {
+	WorkStack instrs; ///< instrukcje (Instr)
+	size_t depth; ///< liczba wielomianów na stosie po dotychczasowych instrukcjach (po LOAD – dolne ograniczenie)
+	bool exact; ///< czy depth jest dokładna
+	size_t max_depth; ///< największa osiągnięta wartość depth
+	Ring *ring; ///< kolejka, przez którą instrukcje są na bieżąco przekazywane do wykonania (NULL – program jest wykonywany po kompilacji)
+} Program;
+
+/** Działanie instrukcji na stos */
+typedef struct StackEffect {
+	uint64_t need; ///< ile wielomianów musi leżeć na stosie
+	int64_t delta; ///< o ile zmienia się liczba wielomianów, gdy instrukcja się uda
+	int64_t replaces; ///< ile wielomianów z wierzchu instrukcja zastępuje jednym wynikiem, nie robiąc nic więcej (-1, gdy ma inne skutki)
+} StackEffect;
+
+
+/**
+ * Podaje działanie operacji na stos.
+ * @param[in] op : kod operacji
+ * @param[in] n : argument COMPOSE
+ * @return działanie operacji
+ */
+static StackEffect OpStackEffect(enum wire_op_e op, unsigned n) {
+	switch (op) {
+	case WIRE_POLY:
+	case WIRE_ZERO:
+		return (StackEffect) {0, 1, 0};
+	case WIRE_CLONE:
+		return (StackEffect) {1, 1, 0};
+	case WIRE_NEG:
+	case WIRE_AT:
+		return (StackEffect) {1, 0, 1};
+	case WIRE_ADD:
+	case WIRE_MUL:
+	case WIRE_SUB:
+		return (StackEffect) {2, -1, 2};
+	case WIRE_COMPOSE:
+		return (StackEffect) {(uint64_t) n + 1, -(int64_t) n,
+							  (int64_t) n + 1};
+	case WIRE_IS_COEFF:
+	case WIRE_IS_ZERO:
+	case WIRE_DEG:
+	case WIRE_DEG_BY:
+	case WIRE_PRINT:
+		return (StackEffect) {1, 0, -1};
+	case WIRE_IS_EQ:
+		return (StackEffect) {2, 0, -1};
+	case WIRE_POP:
+		return (StackEffect) {1, -1, -1};
+	case WIRE_MUL_PRINT:
+		return (StackEffect) {2, -2, -1};
+	default:
+		return (StackEffect) {0, 0, -1};
+	}
+}
+
+/**
+ * Dopisuje instrukcję na koniec programu i uwzględnia jej działanie
+ * na stos.
+ * @param[in,out] calc : kalkulator
+ * @param[in] in : instrukcja
+ */
+static void ProgramAppend(Calc *calc, Instr in) {
+	if (in.error == NO_ERROR) {
+		StackEffect e =
+			OpStackEffect(in.op, in.op == WIRE_COMPOSE ? in.arg.n : 0);
+		in.safe = calc->program->depth >= e.need;
+		if (in.safe) {
+			calc->program->depth += e.delta;
+		} else if (!calc->program->exact) {
+			/* komenda mogła się udać albo nie */
+			uint64_t after = e.need + e.delta;
+			if (after < calc->program->depth) {
+				calc->program->depth = after;
+			}
+		}
+		if (in.op == WIRE_LOAD) {
+			calc->program->exact = false;
+		}
+		if (calc->program->depth > calc->program->max_depth) {
+			calc->program->max_depth = calc->program->depth;
+		}
+	}
+	*(Instr *) WorkStackPush(&calc->program->instrs, sizeof(Instr)) = in;
+}
+
+/**
+ * Dopisuje do programu POP. Obliczenia, których wynik zostałby zdjęty,
+ * są usuwane, a zamiast nich zdejmowane są ich argumenty.
+ * @param[in,out] calc : kalkulator
+ * @param[in] in : instrukcja POP
+ */
+static void ProgramPopAppend(Calc *calc, Instr in) {
+	uint64_t pops = 1;
+	while (pops > 0 && calc->program->instrs.count > 0) {
+		Instr *last = (Instr *) calc->program->instrs.items +
+			calc->program->instrs.count - 1;
+		StackEffect e = OpStackEffect(last->op,
+			last->op == WIRE_COMPOSE ? last->arg.n : 0);
+		if (last->error != NO_ERROR || !last->safe || e.replaces < 0) {
+			break;
+		}
+		WorkStackPop(&calc->program->instrs, sizeof(Instr));
+		if (last->op == WIRE_POLY) {
+			PolyDestroy(&last->arg.p);
+		}
+		calc->program->depth -= e.delta;
+		pops += e.replaces - 1;
+	}
+	for (; pops > 0; pops--) {
+		ProgramAppend(calc, in);
+	}
+}
+
+/**
+ * Dopisuje komendę do programu.
+ * @param[in,out] calc : kalkulator
+ * @param[in] op : kod operacji
+ * @param[in] n : argument DEG_BY i COMPOSE
+ * @param[in] x : argument AT
+ * @param[in] path : argument SAVE i LOAD
+ */
+static void ProgramCommandAppend(Calc *calc, enum wire_op_e op, unsigned n, poly_coeff_t x,
+						  const char *path) {
+	Instr in = {.op = op, .error = NO_ERROR, .row = calc->row};
+	if (op == WIRE_AT) {
+		in.arg.x = x;
+	} else if (path != NULL) { /* SAVE i LOAD */
+		in.arg.path = strdup(path);
+		assert(in.arg.path != NULL);
+	} else {
+		in.arg.n = n;
+	}
+
+	if (op == WIRE_POP) {
+		ProgramPopAppend(calc, in);
+	} else {
+		ProgramAppend(calc, in);
+	}
+}
+
+/**
+ * Dopisuje do programu odłożenie wielomianu na stos.
+ * @param[in,out] calc : kalkulator
+ * @param[in] p : wielomian (przechodzi na własność programu)
+ */
+static void ProgramPolyAppend(Calc *calc, Poly *p) {
+	Instr in = {.op = WIRE_POLY, .error = NO_ERROR, .row = calc->row};
+	in.arg.p = *p;
+	ProgramAppend(calc, in);
+}
+
+/**
+ * Przekazuje zebrane instrukcje programu do wykonania.
+ * @param[in,out] prog : program wykonywany potokowo
+ */
+static void ProgramSend(Program *prog) {
+	Instr *instrs = prog->instrs.items;
+	for (size_t i = 0; i < prog->instrs.count; i++) {
+		RingPush(prog->ring, &instrs[i]);
+	}
+	prog->instrs.count = 0;
+}
+
+/**
+ * Kończy kompilację linii wejścia. Przy wykonaniu potokowym przekazuje
+ * zebrane instrukcje do wykonania – co PIPELINE_BATCH instrukcji, żeby POP
+ * mógł jeszcze usunąć obliczenia z poprzednich linii, a przy wejściu
+ * z terminala od razu.
+ * @param[in,out] calc : kalkulator
+ */
+static void ProgramLineEnd(Calc *calc) {
+	if (calc->program != NULL && calc->program->ring != NULL &&
+		(calc->program->instrs.count >= PIPELINE_BATCH || calc->input_interactive)) {
+		ProgramSend(calc->program);
+	}
+}
+
+/**
+ * Obsługuje błąd wykryty w linii wejścia. Przy kompilacji błąd jest
+ * dopisywany do programu i zgłaszany dopiero przy wykonaniu.
+ * @param[in,out] calc : kalkulator
+ */
+static void LineErrorHandle(Calc *calc) {
+	if (calc->program == NULL) {
+		ErrorHandle(calc);
+		return;
+	}
+	Instr in = {.error = calc->error_flag, .row = calc->row};
+	in.arg.column = Column(calc);
+	ProgramAppend(calc, in);
+	calc->error_flag = NO_ERROR;
+}
+
+/* * * THE PROGRAM * * */
+
+/**
+ * Wrzuca na stos wielomian wczytany ze zrzutu.
+ * @param[in] p : wielomian
+ * @param[in] data : stos
+ */
+static void LoadedPolyPush(Poly *p, void *data) {
+	Push(data, p);
+}
+
+/**
+ * Zapisuje cały stos do pliku zrzutu.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] path : ścieżka pliku
+ */
+static void SaveStack(Calc *calc, Stack *s, const char *path) {
+	if (!PolySnapshotSave(path, s->elements, s->element_count)) {
+		ErrorSetFlag(calc, WRONG_FILE_ERR_FLAG);
+	}
+}
+
+/**
+ * Wrzuca na stos wielomiany zapisane w pliku zrzutu.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos
+ * @param[in] path : ścieżka pliku
+ */
+static void LoadStack(Calc *calc, Stack *s, const char *path) {
+	if (!PolySnapshotLoad(path, LoadedPolyPush, s)) {
+		ErrorSetFlag(calc, WRONG_FILE_ERR_FLAG);
+	}
+}
+
+/**
+ * Wykonuje operację na stosie (przy kompilacji dopisuje ją do programu).
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] op : kod operacji (zob. poly_wire.h)
+ * @param[in] n : argument DEG_BY i COMPOSE
+ * @param[in] x : argument AT
+ * @param[in] path : argument SAVE i LOAD
+ */
+static void CommandRun(Calc *calc, Stack *s, enum wire_op_e op, unsigned n, poly_coeff_t x,
+				const char *path) {
+	if (calc->program != NULL) {
+		ProgramCommandAppend(calc, op, n, x, path);
+		return;
+	}
+
+	switch (op) {
+	case WIRE_ZERO: {
+		Poly p = PolyZero();
+		Push(s, &p);
+		break;
+	}
+	case WIRE_IS_COEFF:
+		IsCoeffPolyOnStack(calc, s);
+		break;
+	case WIRE_IS_ZERO:
+		IsZeroPolyOnStack(calc, s);
+		break;
+	case WIRE_CLONE:
+		ClonePolyOnStack(calc, s);
+		break;
+	case WIRE_ADD:
+		AddTwoPolysFromStack(calc, s);
+		break;
+	case WIRE_MUL:
+		MultiplyTwoPolysFromStack(calc, s);
+		break;
+	case WIRE_MUL_PRINT:
+		MultiplyAndPrintTwoPolysFromStack(calc, s);
+		break;
+	case WIRE_NEG:
+		NegatePolyOnStack(calc, s);
+		break;
+	case WIRE_SUB:
+		SubtractTwoPolysFromStack(calc, s);
+		break;
+	case WIRE_IS_EQ:
+		PrintAreEqualTwoPolysFromStack(calc, s);
+		break;
+	case WIRE_DEG:
+		PrintDegreePolyOnStack(calc, s);
+		break;
+	case WIRE_PRINT:
+		PrintPolyOnStack(calc, s);
+		break;
+	case WIRE_POP: {
+		Poly p = PopSafely(calc, s);
+		if (Error(calc)) { return; }
+		OperandDrop(calc, &p);
+		break;
+	}
+	case WIRE_COMPOSE:
+		ComposePolysOnStack(calc, s, n);
+		break;
+	case WIRE_DEG_BY:
+		PrintDegBy(calc, s, n);
+		break;
+	case WIRE_AT:
+		CalculatePolyAt(calc, s, x);
+		break;
+	case WIRE_SAVE:
+		SaveStack(calc, s, path);
+		break;
+	case WIRE_LOAD:
+		LoadStack(calc, s, path);
+		break;
+	default:
+		ErrorSetFlag(calc, WRONG_COMMAND_ERR_FLAG);
+		break;
+	}
+}
+
+/** Komenda tekstowa bez argumentów */
+typedef struct CommandName {
+	const char *name; ///< nazwa komendy
+	enum wire_op_e op; ///< kod operacji
+} CommandName;
+
+/** Komendy tekstowe bez argumentów */
+static const CommandName COMMAND_NAMES[] = {
+	{"ZERO", WIRE_ZERO},
+	{"IS_COEFF", WIRE_IS_COEFF},
+	{"IS_ZERO", WIRE_IS_ZERO},
+	{"CLONE", WIRE_CLONE},
+	{"ADD", WIRE_ADD},
+	{"MUL", WIRE_MUL},
+	{"MUL_PRINT", WIRE_MUL_PRINT},
+	{"NEG", WIRE_NEG},
+	{"SUB", WIRE_SUB},
+	{"IS_EQ", WIRE_IS_EQ},
+	{"DEG", WIRE_DEG},
+	{"PRINT", WIRE_PRINT},
+	{"POP", WIRE_POP}
+};
+
+/**
+ * Wykonuje komendę zawartą w tablicy znaków.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] command : tablica znaków zawierająca komendę do wykonania
+ */
+static void ExecuteCommand(Calc *calc, Stack *s, char *command) {
+	for (size_t i = 0; i < sizeof(COMMAND_NAMES) / sizeof(CommandName); i++) {
+		if (strcmp(command, COMMAND_NAMES[i].name) == 0) {
+			CommandRun(calc, s, COMMAND_NAMES[i].op, 0, 0, NULL);
+			return;
+		}
+	}
+
+	if (strncmp(command, "COMPOSE", 7) == 0) {
+		if (Error(calc) == EXCEEDED_COMMAND_BUF_ERR || command[7] != ' ') {
+			ErrorSetFlag(calc, WRONG_COUNT_ERR_FLAG);
+			return;
+		}
+
+		unsigned arg = NumberRead(calc, command + 8, UNSIGNED);
+		if (Error(calc)) {
+			ErrorSetFlag(calc, WRONG_COUNT_ERR_FLAG);
+			return;
+		}
+		CommandRun(calc, s, WIRE_COMPOSE, arg, 0, NULL);
+
+	} else if (strncmp(command, "DEG_BY", 6) == 0) {
+		if (Error(calc) == EXCEEDED_COMMAND_BUF_ERR || command[6] != ' ') {
+			ErrorSetFlag(calc, WRONG_VARIABLE_ERR_FLAG);
+			return;
+		}
+
+		unsigned arg = NumberRead(calc, command + 7, UNSIGNED);
+		if (Error(calc)) {
+			ErrorSetFlag(calc, WRONG_VARIABLE_ERR_FLAG);
+			return;
+		}
+		CommandRun(calc, s, WIRE_DEG_BY, arg, 0, NULL);
+
+	} else if (strncmp(command, "AT", 2) == 0) {
+		if (Error(calc) == EXCEEDED_COMMAND_BUF_ERR || command[2] != ' ') {
+			ErrorSetFlag(calc, WRONG_VALUE_ERR_FLAG);
+			return;
+		}
+
+		poly_coeff_t arg =
+			CoeffFromInt(NumberRead(calc, command + 3, POLY_COEFF_T));
+		if (Error(calc)) {
+			ErrorSetFlag(calc, WRONG_VALUE_ERR_FLAG);
+			return;
+		}
+		CommandRun(calc, s, WIRE_AT, 0, arg, NULL);
+
+	} else if (strncmp(command, "SAVE", 4) == 0 ||
+			   strncmp(command, "LOAD", 4) == 0) {
+		if (Error(calc) == EXCEEDED_COMMAND_BUF_ERR || command[4] != ' ' ||
+				command[5] == '\0') {
+			ErrorSetFlag(calc, WRONG_FILE_ERR_FLAG);
+			return;
+		}
+		CommandRun(calc, s, command[0] == 'S' ? WIRE_SAVE : WIRE_LOAD, 0, 0,
+				   command + 5);
+		
+	} else {
+		ErrorSetFlag(calc, WRONG_COMMAND_ERR_FLAG);
+	}
+}
+
+/**
+ * Wykonuje kolejne linie wejścia w formacie tekstowym.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ */
+static void TextRun(Calc *calc, Stack *s) {
+	char command_buf[MAX_COMMAND_LENGTH] = {'\0'};
+	size_t new_line_pos;
+	int ch;
+	bool eof_flag = false;
+
+	while (!eof_flag) {
+		calc->end_of_line = false;
+		ColumnSet(calc, 0);
+		ch = SeeChar(calc);
+
+		if (ch == EOF) {
+			break;
+		} else if (isalpha(ch)) { /* komenda */
+			/* komendy możemy trzymać w buforze o ograniczonej pojemności */
+			LineRead(calc, command_buf, sizeof command_buf);
+
+			new_line_pos = strcspn(command_buf, "\r\n");
+			if (!(new_line_pos == MAX_COMMAND_LENGTH - 1)) {
+				/* Gdzieś w buforze jest '\n'. Po przeczytaniu go więc
+				   skończy się już linia i musimy to pamiętać.
+				*/
+				calc->end_of_line = true;
+				command_buf[new_line_pos] = 0;
+			} else {
+				/* Ktoś wprowadził zbyt długą komendę lub argument.
+				   Nie możemy jeszcze obsłużyć błędu, bo zależnie od komendy
+				   będziemy podawać różne komunikaty. */
+				ErrorSetFlag(calc, EXCEEDED_COMMAND_BUF_ERR);
+			}
+
+			ExecuteCommand(calc, s, command_buf);
+
+			if (Error(calc)) {
+				LineErrorHandle(calc);
+				GoToNextLine(calc, &eof_flag);
+			}
+
+		} else { /* wielomian */
+			Poly p = PolyParse(calc);
+			GoToNextLine(calc, &eof_flag);
+			if (Error(calc)) {
+				PolyDestroy(&p);
+				LineErrorHandle(calc);
+			} else if (calc->program != NULL) {
+				ProgramPolyAppend(calc, &p);
+			} else {
+				Push(s, &p);
+			}
+		}
+		calc->row++;
+		ProgramLineEnd(calc);
+
+		/* na terminal wypisujemy wynik każdej linii od razu (przy kompilacji
+		   wyniki drukuje dopiero wykonanie programu) */
+		if (calc->output_interactive && calc->program == NULL) {
+			OutputFlush(calc);
+		}
+	}
+}
+
+/* * * COMPILED MODE * * */
+
+/**
+ * Wykonuje instrukcję skompilowanego programu.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] in : instrukcja (jej wielomian i ścieżka przechodzą na własność
+ * stosu albo są usuwane)
+ */
+static void InstrRun(Calc *calc, Stack *s, Instr *in) {
+	calc->row = in->row;
+
+	if (in->error != NO_ERROR) {
+		ErrorReport(calc, in->error, in->row, in->arg.column);
+		return;
+	}
+	switch (in->op) {
+	case WIRE_POLY:
+		Push(s, &in->arg.p);
+		return;
+	case WIRE_AT:
+		CommandRun(calc, s, in->op, 0, in->arg.x, NULL);
+		break;
+	case WIRE_SAVE:
+	case WIRE_LOAD:
+		CommandRun(calc, s, in->op, 0, 0, in->arg.path);
+		free(in->arg.path);
+		break;
+	default:
+		CommandRun(calc, s, in->op, in->arg.n, 0, NULL);
+		break;
+	}
+	if (Error(calc)) {
+		ErrorHandle(calc);
+	}
+}
+
+/*
+ * Gdy działa pula wątków (POLY_THREADS_ENV), skompilowany program jest
+ * wykonywany przez harmonogram. Skoro przy kompilacji wiadomo, które komendy
+ * na pewno się udadzą, ich działanie na stos jest znane z góry: komendy
+ * liczące (ADD, MUL, COMPOSE, AT itd.) nie są wykonywane od razu, tylko
+ * dopisywane do grafu zależności między wartościami na wierzchu stosu.
+ * Dopiero instrukcja, której wynik widać na wyjściu (wypisanie, błąd,
+ * SAVE, LOAD) albo która może się nie udać, wylicza graf – wartości
+ * niezależne od siebie (tego samego poziomu) równolegle – i odkłada
+ * wyniki na stos, a potem wykonuje się normalnie. Wartość pośrednia jest
+ * zwalniana zaraz po wyliczeniu ostatniej wartości, która z niej korzysta,
+ * a graf jest wyliczany także wtedy, gdy szacowany rozmiar jego wartości
+ * przekroczy SCHEDULE_BUDGET.
+ */
+
+#define SCHEDULE_WINDOW 1024 ///< liczba wartości w grafie, po której jest on wyliczany bez czekania na instrukcję z wynikiem
+#define SCHEDULE_BUDGET ((size_t) 64 << 20) ///< szacowana liczba bajtów wartości wyliczanych w grafie, po której jest on wyliczany bez czekania na instrukcję z wynikiem
+
+/** Wartość w grafie harmonogramu */
+typedef struct SchedNode {
+	enum wire_op_e op; ///< operacja wyliczająca wartość (WIRE_POLY – wartość jest gotowa)
+	poly_coeff_t x; ///< argument AT
+	size_t args; ///< początek argumentów wartości w tablicy argumentów
+	unsigned args_count; ///< liczba argumentów (pierwszy to wierzch stosu)
+	unsigned level; ///< poziom: 0 dla gotowych wartości, a dla pozostałych o 1 więcej niż najwyższy poziom argumentu
+	unsigned uses; ///< ile razy wartość leży na wierzchu stosu
+	unsigned consumers; ///< ile potrzebnych, jeszcze niewyliczonych wartości korzysta z wartości
+	bool needed; ///< czy wartość jest potrzebna do wyliczenia stosu
+	size_t bytes; ///< szacowany rozmiar wartości w bajtach
+	Poly value; ///< wartość (gdy jest gotowa lub wyliczona)
+} SchedNode;
+
+/** Harmonogram wykonania skompilowanego programu */
+typedef struct Schedule {
+	Stack *stack; ///< stos, którego wierzch jest w grafie
+	WorkStack nodes; ///< wartości (SchedNode), w kolejności tworzenia – argumenty są przed wartością
+	WorkStack args; ///< argumenty wartości (indeksy wartości, size_t)
+	WorkStack slots; ///< wierzch stosu nad stosem stack (indeksy wartości, size_t, od spodu)
+	WorkStack order; ///< wartości do wyliczenia posortowane po poziomach (size_t)
+	WorkStack levels; ///< początki poziomów w order (size_t)
+	const size_t *batch; ///< wartości wyliczanego poziomu
+	size_t bytes; ///< szacowany rozmiar wartości wyliczanych w grafie
+} Schedule;
+
+/**
+ * Dodaje rozmiary, nie przekraczając SIZE_MAX.
+ * @param[in] a : rozmiar
+ * @param[in] b : rozmiar
+ * @return `min(a + b, SIZE_MAX)`
+ */
+static size_t SizeAdd(size_t a, size_t b) {
+	return a > SIZE_MAX - b ? SIZE_MAX : a + b;
+}
+
+/**
+ * Mnoży rozmiary, nie przekraczając SIZE_MAX.
+ * @param[in] a : rozmiar
+ * @param[in] b : rozmiar
+ * @return `min(a * b, SIZE_MAX)`
+ */
+static size_t SizeMul(size_t a, size_t b) {
+	return b != 0 && a > SIZE_MAX / b ? SIZE_MAX : a * b;
+}
+
+/**
+ * Szacuje rozmiar wartości wyliczanej w grafie na podstawie rozmiarów
+ * argumentów: suma dla ADD i SUB, iloczyn liczby składników dla MUL
+ * i COMPOSE. Oszacowanie służy tylko do ograniczenia pamięci grafu.
+ * @param[in] sch : harmonogram
+ * @param[in] node : wartość (z argumentami już w grafie)
+ * @return szacowana liczba bajtów
+ */
+static size_t ScheduleBytes(const Schedule *sch, const SchedNode *node) {
+	const SchedNode *nodes = sch->nodes.items;
+	const size_t *args = (const size_t *) sch->args.items + node->args;
+	size_t bytes = nodes[args[0]].bytes;
+
+	switch (node->op) {
+	case WIRE_ADD:
+	case WIRE_SUB:
+		return SizeAdd(bytes, nodes[args[1]].bytes);
+	case WIRE_MUL:
+		return SizeMul(bytes, nodes[args[1]].bytes / sizeof(Mono) + 1);
+	case WIRE_COMPOSE:
+		for (unsigned i = 1; i < node->args_count; i++) {
+			bytes = SizeMul(bytes, nodes[args[i]].bytes / sizeof(Mono) + 1);
+		}
+		return bytes;
+	default:
+		return bytes;
+	}
+}
+
+/**
+ * Dodaje wartość do grafu.
+ * @param[in,out] sch : harmonogram
+ * @param[in] node : wartość
+ * @return indeks wartości
+ */
+static size_t ScheduleNode(Schedule *sch, SchedNode node) {
+	if (node.op == WIRE_POLY) {
+		node.bytes = (node.value.monos_count + 1) * sizeof(Mono);
+	} else {
+		node.bytes = ScheduleBytes(sch, &node);
+		sch->bytes = SizeAdd(sch->bytes, node.bytes);
+	}
+	*(SchedNode *) WorkStackPush(&(sch->nodes), sizeof(SchedNode)) = node;
+	return sch->nodes.count - 1;
+}
+
+/**
+ * Kładzie wartość na wierzchu stosu w grafie.
+ * @param[in,out] sch : harmonogram
+ * @param[in] node : indeks wartości
+ */
+static void ScheduleSlotPush(Schedule *sch, size_t node) {
+	*(size_t *) WorkStackPush(&(sch->slots), sizeof(size_t)) = node;
+}
+
+/**
+ * Zdejmuje wartość z wierzchu stosu w grafie. Gdy wierzch w grafie jest
+ * pusty, do grafu przechodzi wielomian ze stosu.
+ * @param[in,out] sch : harmonogram
+ * @return indeks wartości
+ */
+static size_t ScheduleSlotPop(Schedule *sch) {
+	if (sch->slots.count > 0) {
+		return *(size_t *) WorkStackPop(&(sch->slots), sizeof(size_t));
+	}
+	return ScheduleNode(sch, (SchedNode) {.op = WIRE_POLY,
+										  .value = Pop(sch->stack)});
+}
+
+/**
+ * Dopisuje instrukcję do grafu, jeśli to możliwe.
+ * @param[in,out] sch : harmonogram
+ * @param[in] in : instrukcja (wielomian WIRE_POLY przechodzi na własność
+ * harmonogramu)
+ * @return Czy instrukcja trafiła do grafu (jeśli nie, trzeba ją wykonać)?
+ */
+static bool ScheduleInstr(Schedule *sch, Instr *in) {
+	if (in->error != NO_ERROR || !in->safe) {
+		return false;
+	}
+
+	SchedNode node = {.op = in->op};
+	switch (in->op) {
+	case WIRE_POLY:
+		node.value = in->arg.p;
+		break;
+	case WIRE_ZERO:
+		node.op = WIRE_POLY;
+		node.value = PolyZero();
+		break;
+	case WIRE_CLONE: {
+		size_t top = ScheduleSlotPop(sch);
+		ScheduleSlotPush(sch, top);
+		ScheduleSlotPush(sch, top);
+		return true;
+	}
+	case WIRE_POP:
+		ScheduleSlotPop(sch);
+		return true;
+	case WIRE_NEG:
+	case WIRE_AT:
+		node.args_count = 1;
+		break;
+	case WIRE_ADD:
+	case WIRE_MUL:
+	case WIRE_SUB:
+		node.args_count = 2;
+		break;
+	case WIRE_COMPOSE:
+		node.args_count = in->arg.n + 1;
+		break;
+	default:
+		return false;
+	}
+
+	if (in->op == WIRE_AT) {
+		node.x = in->arg.x;
+	}
+	node.args = sch->args.count;
+	for (unsigned i = 0; i < node.args_count; i++) {
+		size_t arg = ScheduleSlotPop(sch);
+		*(size_t *) WorkStackPush(&(sch->args), sizeof(size_t)) = arg;
+	}
+	ScheduleSlotPush(sch, ScheduleNode(sch, node));
+	return true;
+}
+
+/**
+ * Wylicza jedną wartość z wyliczanego poziomu grafu.
+ * @param[in] data : harmonogram
+ * @param[in] n : numer wartości w poziomie
+ */
+static void ScheduleTask(void *data, size_t n) {
+	Schedule *sch = data;
+	SchedNode *nodes = sch->nodes.items;
+	SchedNode *node = &nodes[sch->batch[n]];
+	const size_t *args = (size_t *) sch->args.items + node->args;
+	const Poly *p = &(nodes[args[0]].value);
+
+	switch (node->op) {
+	case WIRE_NEG:
+		node->value = PolyNeg(p);
+		break;
+	case WIRE_AT:
+		node->value = PolyAt(p, node->x);
+		break;
+	case WIRE_ADD:
+		node->value = PolyAdd(p, &(nodes[args[1]].value));
+		break;
+	case WIRE_MUL:
+		node->value = PolyMulCached(p, &(nodes[args[1]].value));
+		break;
+	case WIRE_SUB:
+		node->value = PolySub(p, &(nodes[args[1]].value));
+		break;
+	case WIRE_COMPOSE: {
+		unsigned count = node->args_count - 1;
+		Poly *x = calloc(count > 0 ? count : 1, sizeof(Poly));
+		assert(x != NULL);
+		for (unsigned i = 0; i < count; i++) {
+			x[i] = nodes[args[i + 1]].value;
+		}
+		node->value = PolyComposeCached(p, count, x);
+		free(x);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/**
+ * Zwalnia argumenty wartości wyliczonego poziomu, z których nie korzysta już
+ * żadna niewyliczona wartość ani stos.
+ * @param[in,out] sch : harmonogram
+ * @param[in] count : liczba wartości w poziomie
+ */
+static void ScheduleRelease(Schedule *sch, size_t count) {
+	SchedNode *nodes = sch->nodes.items;
+	const size_t *args = sch->args.items;
+
+	for (size_t i = 0; i < count; i++) {
+		const SchedNode *node = &nodes[sch->batch[i]];
+		for (unsigned j = 0; j < node->args_count; j++) {
+			SchedNode *arg = &nodes[args[node->args + j]];
+			if (--(arg->consumers) == 0 && arg->uses == 0) {
+				PolyReclaim(&(arg->value));
+			}
+		}
+	}
+}
+
+/**
+ * Wylicza potrzebne wartości grafu, poziom po poziomie. Gotowe wartości,
+ * które nie są potrzebne, i wartości pośrednie są zwalniane, więc po
+ * wyliczeniu w grafie zostają tylko wartości na wierzchu stosu.
+ * @param[in,out] sch : harmonogram
+ */
+static void ScheduleEvaluate(Schedule *sch) {
+	SchedNode *nodes = sch->nodes.items;
+	const size_t *args = sch->args.items;
+	const size_t *slots = sch->slots.items;
+	size_t count = sch->nodes.count;
+	unsigned max_level = 0;
+
+	/* potrzebne są wartości na stosie, a wstecz – ich argumenty */
+	for (size_t i = 0; i < sch->slots.count; i++) {
+		nodes[slots[i]].needed = true;
+		nodes[slots[i]].uses++;
+	}
+	for (size_t i = count; i-- > 0;) {
+		if (nodes[i].needed) {
+			for (unsigned j = 0; j < nodes[i].args_count; j++) {
+				nodes[args[nodes[i].args + j]].needed = true;
+				nodes[args[nodes[i].args + j]].consumers++;
+			}
+		} else if (nodes[i].op == WIRE_POLY) {
+			PolyReclaim(&(nodes[i].value));
+		}
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (nodes[i].needed && nodes[i].op != WIRE_POLY) {
+			for (unsigned j = 0; j < nodes[i].args_count; j++) {
+				unsigned level = nodes[args[nodes[i].args + j]].level + 1;
+				if (level > nodes[i].level) {
+					nodes[i].level = level;
+				}
+			}
+			if (nodes[i].level > max_level) {
+				max_level = nodes[i].level;
+			}
+		}
+	}
+
+	/* sortowanie przez zliczanie po poziomach */
+	sch->levels.count = 0;
+	for (unsigned level = 0; level <= max_level + 1; level++) {
+		*(size_t *) WorkStackPush(&(sch->levels), sizeof(size_t)) = 0;
+	}
+	size_t *levels = sch->levels.items;
+	for (size_t i = 0; i < count; i++) {
+		if (nodes[i].needed && nodes[i].op != WIRE_POLY) {
+			levels[nodes[i].level]++;
+		}
+	}
+	for (unsigned level = 1; level <= max_level + 1; level++) {
+		levels[level] += levels[level - 1];
+	}
+	sch->order.count = 0;
+	for (size_t i = 0; i < levels[max_level]; i++) {
+		WorkStackPush(&(sch->order), sizeof(size_t));
+	}
+	size_t *order = sch->order.items;
+	for (size_t i = count; i-- > 0;) {
+		if (nodes[i].needed && nodes[i].op != WIRE_POLY) {
+			order[--levels[nodes[i].level]] = i;
+		}
+	}
+
+	/* wartości jednego poziomu nie zależą od siebie */
+	for (unsigned level = 1; level <= max_level; level++) {
+		sch->batch = order + levels[level];
+		PolyThreadsRun(ScheduleTask, sch, levels[level + 1] - levels[level]);
+		ScheduleRelease(sch, levels[level + 1] - levels[level]);
+	}
+}
+
+/**
+ * Wylicza graf i odkłada wierzch stosu z grafu na stos.
+ * @param[in,out] sch : harmonogram
+ */
+static void ScheduleFlush(Schedule *sch) {
+	if (sch->nodes.count == 0 && sch->slots.count == 0) {
+		return;
+	}
+	ScheduleEvaluate(sch);
+
+	SchedNode *nodes = sch->nodes.items;
+	const size_t *slots = sch->slots.items;
+	for (size_t i = 0; i < sch->slots.count; i++) {
+		SchedNode *node = &nodes[slots[i]];
+		Poly p = node->value;
+		/* wielomian na stosie może zostać internowany, więc kopie
+		   robimy przed odłożeniem oryginału */
+		if (--(node->uses) > 0) {
+			p = PolySnapshotShare(&p) || PolyCacheShare(&p) ?
+				p : PolyClone(&p);
+		}
+		Push(sch->stack, &p);
+	}
+
+	sch->bytes = 0;
+	sch->nodes.count = 0;
+	sch->args.count = 0;
+	sch->slots.count = 0;
+}
+
+/**
+ * Wykonuje skompilowany program przez harmonogram.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] prog : program
+ */
+static void ScheduledRun(Calc *calc, Stack *s, Program *prog) {
+	Instr *instrs = prog->instrs.items;
+	Schedule sch = {.stack = s};
+
+	for (size_t i = 0; i < prog->instrs.count; i++) {
+		if (!ScheduleInstr(&sch, &instrs[i])) {
+			ScheduleFlush(&sch);
+			InstrRun(calc, s, &instrs[i]);
+		} else if (sch.nodes.count >= SCHEDULE_WINDOW ||
+				   sch.bytes >= SCHEDULE_BUDGET) {
+			ScheduleFlush(&sch);
+		}
+	}
+	ScheduleFlush(&sch);
+
+	WorkStackFree(&(sch.nodes));
+	WorkStackFree(&(sch.args));
+	WorkStackFree(&(sch.slots));
+	WorkStackFree(&(sch.order));
+	WorkStackFree(&(sch.levels));
+}
+
+/**
+ * Wykonuje skompilowany program i usuwa go z pamięci. Flaga błędu
+ * pozostawiona przez kompilację (koniec wejścia bez znaku nowej linii)
+ * nie dotyczy żadnej instrukcji, więc jest odkładana na czas wykonania
+ * i przywracana po nim.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] prog : program
+ */
+static void ProgramRun(Calc *calc, Stack *s, Program *prog) {
+	Instr *instrs = prog->instrs.items;
+	enum error_flag_e input_flag = calc->error_flag;
+
+	calc->error_flag = NO_ERROR;
+	StackReserve(s, prog->max_depth);
+	if (PolyThreadsCount() > 1) {
+		ScheduledRun(calc, s, prog);
+	} else {
+		for (size_t i = 0; i < prog->instrs.count; i++) {
+			InstrRun(calc, s, &instrs[i]);
+		}
+	}
+	WorkStackFree(&prog->instrs);
+	calc->error_flag = input_flag;
+}
+
+/**
+ * Kompiluje całe wejście w formacie tekstowym, a potem je wykonuje.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ */
+static void CompiledRun(Calc *calc, Stack *s) {
+	Program prog = {.depth = s->element_count, .exact = true,
+					.max_depth = s->element_count};
+
+	calc->program = &prog;
+	TextRun(calc, s);
+	calc->program = NULL;
+
+	ProgramRun(calc, s, &prog);
+}
+
+/* * * PIPELINE * * */
+
+/*
+ * Przy wykonaniu potokowym (PIPELINE_ENV) wejście tekstowe przechodzi przez
+ * trzy wątki: wątek główny kompiluje kolejne linie (zob. COMPILATION)
+ * i przekazuje instrukcje kolejką do wątku wykonującego, który jako jedyny
+ * używa stosu, a ten przekazuje wyniki komend kolejką do wątku drukującego.
+ * Wyniki i komunikaty o błędach wypisuje wątek drukujący, w kolejności
+ * instrukcji, więc wyjście jest takie samo jak przy wykonaniu w jednym
+ * wątku. Wielomian do wydrukowania nie jest kopiowany: wątek wykonujący
+ * przekazuje też kolejką wielomiany zdjęte ze stosu, które wątek drukujący
+ * usuwa dopiero po wydrukowaniu wcześniejszych wyników.
+ */
+
+/** Wątki potoku */
+typedef struct Pipeline {
+	Calc *calc; ///< kalkulator, którego wejście jest wykonywane (używany przez wątek drukujący)
+	Calc executor; ///< stan wątku wykonującego (błędy i wyniki komend)
+	Stack *stack; ///< stos wielomianów
+	Ring instrs; ///< instrukcje do wykonania (Instr)
+	Ring jobs; ///< wyniki do wydrukowania (PrintJob)
+} Pipeline;
+
+/**
+ * Pętla wątku wykonującego: wykonuje instrukcje, aż dostanie instrukcję
+ * z flagą EOF_FLAG.
+ * @param[in] arg : potok
+ * @return NULL
+ */
+static void *PipelineExecutor(void *arg) {
+	Pipeline *pipeline = arg;
+	Instr in;
+
+	for (;;) {
+		RingPop(&(pipeline->instrs), &in);
+		if (in.error == EOF_FLAG) {
+			break;
+		}
+		InstrRun(&(pipeline->executor), pipeline->stack, &in);
+	}
+	RingPush(&(pipeline->jobs), &(PrintJob) {.kind = JOB_END});
+	return NULL;
+}
+
+/**
+ * Pętla wątku drukującego: drukuje wyniki, aż dostanie JOB_END.
+ * @param[in] arg : potok
+ * @return NULL
+ */
+static void *PipelinePrinter(void *arg) {
+	Pipeline *pipeline = arg;
+	Calc *calc = pipeline->calc;
+	PrintJob job;
+
+	for (;;) {
+		RingPop(&(pipeline->jobs), &job);
+		switch (job.kind) {
+		case JOB_INT:
+			ResultIntWrite(calc, job.v);
+			break;
+		case JOB_POLY:
+			ResultBegin(calc, WIRE_REPLY_POLY);
+			PolyPrint(calc, &(job.p));
+			ResultEnd(calc);
+			break;
+		case JOB_MUL:
+			ResultMulPrint(calc, &(job.p), &(job.q));
+			PolyReclaim(&(job.p));
+			PolyReclaim(&(job.q));
+			break;
+		case JOB_ERROR:
+			ErrorReportWrite(calc, job.error, job.row, job.column);
+			break;
+		case JOB_DROP:
+			PolyReclaim(&(job.p));
+			continue;
+		case JOB_END:
+			return NULL;
+		}
+		if (calc->output_interactive) {
+			OutputFlush(calc);
+		}
+	}
+}
+
+/**
+ * Wykonuje wejście w formacie tekstowym potokowo. Gdy nie uda się
+ * uruchomić wątków, wykonuje je w jednym wątku.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] size : pojemność kolejek potoku
+ */
+static void PipelineRun(Calc *calc, Stack *s, size_t size) {
+	Pipeline pipeline = {.calc = calc, .stack = s};
+	pthread_t executor, printer;
+
+	RingInit(&(pipeline.instrs), sizeof(Instr), size);
+	RingInit(&(pipeline.jobs), sizeof(PrintJob), size);
+	if (pthread_create(&printer, NULL, PipelinePrinter, &pipeline) != 0) {
+		RingFree(&(pipeline.instrs));
+		RingFree(&(pipeline.jobs));
+		TextRun(calc, s);
+		return;
+	}
+	pipeline.executor = (Calc) {.err = calc->err, .user = calc->user,
+								.print_ring = &(pipeline.jobs)};
+	if (pthread_create(&executor, NULL, PipelineExecutor, &pipeline) != 0) {
+		/* wykonujemy i drukujemy w tym wątku; wątek drukujący tylko kończy */
+		CompiledRun(calc, s);
+		RingPush(&(pipeline.jobs), &(PrintJob) {.kind = JOB_END});
+	} else {
+		Program prog = {.depth = s->element_count, .exact = true,
+						.max_depth = s->element_count,
+						.ring = &(pipeline.instrs)};
+		calc->program = &prog;
+		TextRun(calc, s);
+		calc->program = NULL;
+
+		/* reszta instrukcji i znacznik końca */
+		ProgramSend(&prog);
+		WorkStackFree(&(prog.instrs));
+		RingPush(&(pipeline.instrs), &(Instr) {.error = EOF_FLAG});
+		pthread_join(executor, NULL);
+	}
+	pthread_join(printer, NULL);
+
+	RingFree(&(pipeline.instrs));
+	RingFree(&(pipeline.jobs));
+}
+
+/* * * BINARY MODE * * */
+
+/**
+ * Wczytuje bajt wczytywanej ramki.
+ * @param[in,out] calc : kalkulator
+ * @return bajt (0 po błędzie)
+ */
+static int WireByte(Calc *calc) {
+	if (calc->frame_left == 0) {
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+	int ch = GetChar(calc);
+	if (ch == EOF) {
+		ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		return 0;
+	}
+	calc->frame_left--;
+	return ch;
+}
+
+/**
+ * Wczytuje liczbę varint z wczytywanej ramki.
+ * @param[in,out] calc : kalkulator
+ * @param[in] max : największa poprawna wartość
+ * @return liczba (0 po błędzie)
+ */
+static poly_uinput_t WireVarintRead(Calc *calc, poly_uinput_t max) {
+	const unsigned bits = 8 * sizeof(poly_uinput_t);
+	poly_uinput_t v = 0;
+	unsigned shift = 0;
+	int b;
+	do {
+		b = WireByte(calc);
+		if (Error(calc)) { return 0; }
+		if (shift >= bits ||
+				(shift + 7 > bits && ((b & 0x7f) >> (bits - shift)) != 0)) {
+			ErrorSetFlag(calc, TOO_BIG_NUMBER_ERR_FLAG);
+			return 0;
+		}
+		v |= (poly_uinput_t) (b & 0x7f) << shift;
+		shift += 7;
+	} while (b & 0x80);
+
+	if (v > max) {
+		ErrorSetFlag(calc, TOO_BIG_NUMBER_ERR_FLAG);
+		return 0;
+	}
+	return v;
+}
+
+/**
+ * Wczytuje współczynnik (zigzag) z wczytywanej ramki. Dopuszczalne są te
+ * same wartości co w formacie tekstowym.
+ * @param[in,out] calc : kalkulator
+ * @return współczynnik (0 po błędzie)
+ */
+static poly_input_t WireCoeffRead(Calc *calc) {
+	poly_uinput_t v =
+		WireVarintRead(calc, 2 * (poly_uinput_t) POLY_COEFF_INPUT_MAX + 1);
+	if (Error(calc)) { return 0; }
+	return (poly_input_t) (v >> 1) ^ -(poly_input_t) (v & 1);
+}
+
+/**
+ * Wczytuje ścieżkę pliku – resztę wczytywanej ramki.
+ * @param[in,out] calc : kalkulator
+ * @param[out] path : bufor na ścieżkę
+ * @param[in] size : rozmiar bufora
+ */
+static void WirePathRead(Calc *calc, char *path, size_t size) {
+	if (calc->frame_left == 0 || calc->frame_left >= size) {
+		ErrorSetFlag(calc, WRONG_FILE_ERR_FLAG);
+		return;
+	}
+	size_t n = 0;
+	while (calc->frame_left > 0) {
+		path[n] = WireByte(calc);
+		if (Error(calc) || path[n] == '\0') {
+			ErrorSetFlag(calc, WRONG_FILE_ERR_FLAG);
+			return;
+		}
+		n++;
+	}
+	path[n] = '\0';
+}
+
+/**
+ * Wczytuje wielomian z wczytywanej ramki bez rekurencji, na tych samych
+ * stosach co PolyParse(). Jednomian, którego współczynnik jest wczytywany,
+ * czeka na stosie jednomianów z zerowym współczynnikiem.
+ * @param[in,out] calc : kalkulator
+ * @return wczytany wielomian
+ */
+static Poly WirePolyRead(Calc *calc) {
+	size_t base = calc->parse_stack.count;
+
+	while (true) {
+		uint64_t v = WireVarintRead(calc, (uint64_t) POLY_EXP_MAX + 1);
+		if (Error(calc)) {
+			return ParseLevelsDrop(calc, base);
+		}
+
+		if (v != 0) { /* pierwszy jednomian sumy */
+			ParseLevel *level = WorkStackPush(&calc->parse_stack, sizeof(ParseLevel));
+			level->first = calc->parse_monos.count;
+			Poly zero = PolyZero();
+			*(Mono *) WorkStackPush(&calc->parse_monos, sizeof(Mono)) =
+				MonoFromPoly(&zero, v - 1);
+			continue;
+		}
+
+		Poly p = PolyFromCoeff(CoeffFromInt(WireCoeffRead(calc)));
+		if (Error(calc)) {
+			return ParseLevelsDrop(calc, base);
+		}
+
+		/* p jest współczynnikiem ostatniego jednomianu najgłębszej sumy */
+		while (calc->parse_stack.count > base) {
+			((Mono *) calc->parse_monos.items)[calc->parse_monos.count - 1].p = p;
+
+			v = WireVarintRead(calc, (uint64_t) POLY_EXP_MAX + 1);
+			if (Error(calc)) {
+				return ParseLevelsDrop(calc, base);
+			}
+			if (v != 0) {
+				Poly zero = PolyZero();
+				*(Mono *) WorkStackPush(&calc->parse_monos, sizeof(Mono)) =
+					MonoFromPoly(&zero, v - 1);
+				break; // wczytujemy współczynnik kolejnego jednomianu
+			}
+
+			ParseLevel *level = WorkStackPop(&calc->parse_stack, sizeof(ParseLevel));
+			p = PolyAddMonos(calc->parse_monos.count - level->first,
+							 (Mono *) calc->parse_monos.items + level->first);
+			calc->parse_monos.count = level->first;
+		}
+
+		if (calc->parse_stack.count == base) {
+			return p;
+		}
+	}
+}
+
+/**
+ * Wykonuje treść wczytywanej ramki.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ */
+static void WireFrameExecute(Calc *calc, Stack *s) {
+	uint64_t op = WireVarintRead(calc, UINT64_MAX);
+	if (Error(calc)) { return; }
+
+	if (op == WIRE_POLY) {
+		Poly p = WirePolyRead(calc);
+		if (!Error(calc) && calc->frame_left > 0) {
+			ErrorSetFlag(calc, PARSING_ERR_FLAG);
+		}
+		if (Error(calc)) {
+			PolyDestroy(&p);
+			return;
+		}
+		Push(s, &p);
+		return;
+	}
+
+	/* błędny argument zgłaszamy tak jak w komendzie tekstowej */
+	enum error_flag_e arg_error = WRONG_COMMAND_ERR_FLAG;
+	unsigned n = 0;
+	poly_coeff_t x = 0;
+	char path[MAX_COMMAND_LENGTH] = {'\0'};
+	if (op == WIRE_DEG_BY || op == WIRE_COMPOSE) {
+		arg_error = op == WIRE_DEG_BY ? WRONG_VARIABLE_ERR_FLAG :
+										WRONG_COUNT_ERR_FLAG;
+		n = WireVarintRead(calc, UINT32_MAX);
+	} else if (op == WIRE_AT) {
+		arg_error = WRONG_VALUE_ERR_FLAG;
+		x = CoeffFromInt(WireCoeffRead(calc));
+	} else if (op == WIRE_SAVE || op == WIRE_LOAD) {
+		arg_error = WRONG_FILE_ERR_FLAG;
+		WirePathRead(calc, path, sizeof(path));
+	} else if (op > WIRE_LOAD) {
+		ErrorSetFlag(calc, WRONG_COMMAND_ERR_FLAG);
+	}
+	if (Error(calc) || calc->frame_left > 0) {
+		ErrorSetFlag(calc, arg_error);
+		return;
+	}
+	CommandRun(calc, s, op, n, x, path);
+}
+
+/**
+ * Wykonuje kolejne ramki wejścia w formacie binarnym.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ */
+static void BinaryRun(Calc *calc, Stack *s) {
+	while (!calc->input_eof && SeeChar(calc) != EOF) {
+		calc->frame_left = SIZE_MAX;
+		ColumnSet(calc, 0);
+		uint64_t len = WireVarintRead(calc, SIZE_MAX);
+		if (Error(calc)) {
+			/* bez długości ramki nie odnajdziemy początku następnej */
+			ErrorHandle(calc);
+			break;
+		}
+
+		calc->frame_left = len;
+		ColumnSet(calc, 0);
+		WireFrameExecute(calc, s);
+		if (Error(calc)) {
+			ErrorHandle(calc);
+		}
+		while (calc->frame_left > 0 && SkipChar(calc) != EOF) {
+			calc->frame_left--;
+		}
+		calc->row++;
+
+		if (calc->output_interactive) {
+			OutputFlush(calc);
+		}
+	}
+}
+
+/* * * CHAIN MODE * * */
+
+/*
+ * Łańcuch to katalog plików z komendami. Pierwsza linia pliku startowego
+ * to START, a ostatnia linia każdego pliku to FILE nazwa (nazwa kolejnego
+ * pliku) albo STOP. Wynikiem każdego kroku są wyniki wypisane przez jego
+ * komendy; w kolejnym kroku leżą one na stosie (w kolejności wypisania),
+ * a wiersze pliku są numerowane po nich. Dopiero wyniki ostatniego kroku
+ * trafiają na wyjście.
+ */
+
+/**
+ * Sprawdza, czy pierwsza linia pliku to START.
+ * @param[in] path : ścieżka pliku
+ * @return Czy plik rozpoczyna łańcuch?
+ */
+static bool ChainIsStart(const char *path) {
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		return false;
+	}
+	char line[7];
+	size_t n = fread(line, 1, sizeof(line), f);
+	fclose(f);
+	return n >= 5 && memcmp(line, "START", 5) == 0 &&
+		(n == 5 || line[5] == '\n');
+}
+
+/**
+ * Tworzy ścieżkę pliku w katalogu łańcucha.
+ * @param[in] dir : katalog
+ * @param[in] name : nazwa pliku
+ * @return ścieżka (do zwolnienia przez free)
+ */
+static char *ChainPath(const char *dir, const char *name) {
+	size_t size = strlen(dir) + strlen(name) + 2;
+	char *path = malloc(size);
+	assert(path != NULL);
+	snprintf(path, size, "%s/%s", dir, name);
+	return path;
+}
+
+/**
+ * Wyszukuje plik startowy łańcucha – pierwszy w kolejności alfabetycznej.
+ * @param[in] dir : katalog
+ * @return ścieżka pliku (do zwolnienia przez free) albo NULL
+ */
+static char *ChainStart(const char *dir) {
+	struct dirent **names;
+	int count = scandir(dir, &names, NULL, alphasort);
+	if (count < 0) {
+		return NULL;
+	}
+
+	char *start = NULL;
+	for (int i = 0; i < count; i++) {
+		if (start == NULL && names[i]->d_name[0] != '.') {
+			char *path = ChainPath(dir, names[i]->d_name);
+			if (ChainIsStart(path)) {
+				start = path;
+			} else {
+				free(path);
+			}
+		}
+		free(names[i]);
+	}
+	free(names);
+	return start;
+}
+
+/**
+ * Przygotowuje wejście do wykonania kroku łańcucha: komend pliku bez
+ * linii START i bez ostatniej linii, jeśli jest to FILE albo STOP.
+ * Plik bez takiej linii kończy łańcuch i jest wykonywany do końca.
+ * @param[in,out] calc : kalkulator
+ * @param[in] f : plik kroku
+ * @param[in] start : czy to plik startowy
+ * @param[out] next : nazwa kolejnego pliku (pusta, gdy to ostatni krok)
+ * @param[in] size : rozmiar bufora @p next
+ */
+static void ChainStepInput(Calc *calc, FILE *f, bool start, char *next, size_t size) {
+	next[0] = '\0';
+	fseek(f, 0, SEEK_END);
+	long file_size = ftell(f);
+	if (file_size < 0) {
+		file_size = 0;
+	}
+
+	/* ostatnią linię czytamy od tyłu; dłuższa nie jest komendą łańcucha */
+	char tail[MAX_COMMAND_LENGTH + 1];
+	long tail_size = file_size < (long) sizeof(tail) ? file_size :
+		(long) sizeof(tail);
+	fseek(f, file_size - tail_size, SEEK_SET);
+	size_t len = fread(tail, 1, tail_size, f);
+	if (len > 0 && tail[len - 1] == '\n') {
+		len--;
+	}
+	size_t line = len;
+	while (line > 0 && tail[line - 1] != '\n') {
+		line--;
+	}
+
+	long end = file_size;
+	if (line > 0 || tail_size == file_size) {
+		tail[len] = '\0';
+		if (strcmp(tail + line, "STOP") == 0) {
+			end = file_size - tail_size + line;
+		} else if (strncmp(tail + line, "FILE ", 5) == 0 &&
+				   len - line - 5 < size) {
+			end = file_size - tail_size + line;
+			strcpy(next, tail + line + 5);
+		}
+	}
+
+	long begin = start ? 6 : 0;
+	if (begin > end) {
+		begin = end;
+	}
+	fseek(f, begin, SEEK_SET);
+	InputInit(calc, f, end - begin);
+}
+
+/**
+ * Wykonuje łańcuch plików, przekazując wyniki kolejnych kroków w pamięci.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : stos wielomianów na którym operujemy
+ * @param[in] dir : katalog łańcucha
+ * @return Czy udało się otworzyć wszystkie pliki łańcucha?
+ */
+static bool ChainRun(Calc *calc, Stack *s, const char *dir) {
+	char *path = ChainStart(dir);
+	if (path == NULL) {
+		ErrorWrite(calc, "no START file in ");
+		ErrorWrite(calc, dir);
+		ErrorWrite(calc, "\n");
+		return false;
+	}
+
+	bool start = true;
+	while (path != NULL) {
+		FILE *f = fopen(path, "r");
+		if (f == NULL) {
+			ErrorWrite(calc, "cannot open ");
+			ErrorWrite(calc, path);
+			ErrorWrite(calc, "\n");
+			free(path);
+			return false;
+		}
+		free(path);
+		path = NULL;
+
+		char next[MAX_COMMAND_LENGTH];
+		ChainStepInput(calc, f, start, next, sizeof(next));
+		Stack results = {0, 0, NULL};
+		if (next[0] != '\0') {
+			results = StackEmpty();
+			calc->chain_results = &results;
+		}
+		TextRun(calc, s);
+		fclose(f);
+
+		if (calc->chain_results != NULL) {
+			calc->chain_results = NULL;
+			StackDestroy(s);
+			*s = results;
+			calc->row = results.element_count;
+			path = ChainPath(dir, next);
+		}
+		start = false;
+	}
+	return true;
+}
+
+/* * * CALCULATOR * * */
+
+/**
+ * Usuwa z pamięci instrukcje programu, który nie został wykonany.
+ * @param[in,out] prog : program
+ */
+static void ProgramDestroy(Program *prog) {
+	Instr *instrs = prog->instrs.items;
+	for (size_t i = 0; i < prog->instrs.count; i++) {
+		if (instrs[i].error != NO_ERROR) {
+			continue;
+		}
+		if (instrs[i].op == WIRE_POLY) {
+			PolyDestroy(&(instrs[i].arg.p));
+		} else if (instrs[i].op == WIRE_SAVE || instrs[i].op == WIRE_LOAD) {
+			free(instrs[i].arg.path);
+		}
+	}
+	WorkStackFree(&prog->instrs);
+}
+
+Calc *CalcNew(enum calc_mode_e mode, CalcWriter out, CalcWriter err,
+			  void *user) {
+	Calc *calc = calloc(1, sizeof(Calc));
+	assert(calc != NULL);
+	calc->output_buffer = malloc(OUTPUT_BUFFER_SIZE);
+	assert(calc->output_buffer != NULL);
+
+	calc->stack = StackEmpty();
+	calc->error_flag = NO_ERROR;
+	calc->input_left = SIZE_MAX;
+	calc->mode = mode;
+	calc->binary_mode = mode == CALC_BINARY;
+	calc->out = out;
+	calc->err = err;
+	calc->user = user;
+	return calc;
+}
+
+void CalcDelete(Calc *calc) {
+	if (calc->program != NULL) {
+		ProgramDestroy(calc->program);
+		free(calc->program);
+	}
+	StackDestroy(&calc->stack);
+	free(calc->input_buffer);
+	free(calc->output_buffer);
+	WorkStackFree(&calc->input_fed);
+	WorkStackFree(&calc->wire_frame);
+	WorkStackFree(&calc->print_stack);
+	WorkStackFree(&calc->parse_stack);
+	WorkStackFree(&calc->parse_monos);
+	free(calc);
+}
+
+void CalcSetInteractive(Calc *calc, bool interactive) {
+	calc->output_interactive = interactive;
+}
+
+/**
+ * Dopisuje bajty na koniec wejścia przekazanego przez CalcFeed.
+ * @param[in,out] calc : kalkulator
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ */
+static void InputFedAppend(Calc *calc, const char *data, size_t size) {
+	WorkStack *fed = &calc->input_fed;
+	if (fed->count + size > fed->size) {
+		fed->size = fed->count + size > 2 * fed->size ? fed->count + size :
+			2 * fed->size;
+		fed->items = realloc(fed->items, fed->size);
+		assert(fed->items != NULL);
+	}
+	memcpy((char *) fed->items + fed->count, data, size);
+	fed->count += size;
+}
+
+/**
+ * Podaje długość początku wejścia przekazanego przez CalcFeed, który składa
+ * się z pełnych linii (w trybie binarnym – pełnych ramek). Ramka z błędną
+ * długością też jest pełna: jej wykonanie zgłosi błąd.
+ * @param[in,out] calc : kalkulator
+ * @return liczba bajtów
+ */
+static size_t InputFedComplete(Calc *calc) {
+	const unsigned char *data = calc->input_fed.items;
+	size_t count = calc->input_fed.count;
+
+	if (!calc->binary_mode) {
+		size_t end = count;
+		while (end > 0 && data[end - 1] != '\n') {
+			end--;
+		}
+		return end;
+	}
+
+	size_t end = 0;
+	while (end < count) {
+		/* długość ramki ma najwyżej 10 bajtów (zob. WireVarintRead) */
+		size_t n = 0;
+		while (end + n < count && n < 10 && (data[end + n] & 0x80)) {
+			n++;
+		}
+		if (n == 10 || (n == 9 && end + n < count && (data[end + n] & 0x7e))) {
+			return count;
+		}
+		if (end + n == count) {
+			break;
+		}
+		uint64_t len = 0;
+		for (size_t i = 0; i <= n; i++) {
+			len |= (uint64_t) (data[end + i] & 0x7f) << (7 * i);
+		}
+		if (len > count - end - n - 1) {
+			break;
+		}
+		end += n + 1 + len;
+	}
+	return end;
+}
+
+/**
+ * Wykonuje początek wejścia przekazanego przez CalcFeed i usuwa go.
+ * @param[in,out] calc : kalkulator
+ * @param[in] size : liczba bajtów do wykonania
+ */
+static void InputFedRun(Calc *calc, size_t size) {
+	if (calc->mode == CALC_COMPILE && calc->program == NULL) {
+		calc->program = malloc(sizeof(Program));
+		assert(calc->program != NULL);
+		*calc->program = (Program) {.depth = calc->stack.element_count,
+									.exact = true,
+									.max_depth = calc->stack.element_count};
+	}
+
+	calc->input_file = NULL;
+	calc->input_interactive = false;
+	calc->input_pos = calc->input_fed.items;
+	calc->input_end = calc->input_pos + size;
+	calc->input_eof = false;
+	ColumnSet(calc, 0);
+	if (calc->binary_mode) {
+		BinaryRun(calc, &calc->stack);
+		/* BinaryRun przerywa przed końcem wejścia tylko po błędnej długości
+		   ramki, a wtedy reszta wejścia jest nieczytelna */
+		if (!calc->input_eof) {
+			calc->input_broken = true;
+		}
+	} else {
+		TextRun(calc, &calc->stack);
+	}
+
+	calc->input_fed.count -= size;
+	memmove(calc->input_fed.items, (char *) calc->input_fed.items + size,
+			calc->input_fed.count);
+}
+
+void CalcFeed(Calc *calc, const char *data, size_t size) {
+	if (calc->input_broken) {
+		return;
+	}
+	InputFedAppend(calc, data, size);
+	size_t complete = InputFedComplete(calc);
+	if (complete > 0) {
+		InputFedRun(calc, complete);
+	}
+	OutputFlush(calc);
+}
+
+/**
+ * Kończy wykonanie wejścia: wypisuje resztę wyjścia i zapamiętuje flagę
+ * błędu, z którą zakończyło się wejście, żeby kolejne wejście zaczynało się
+ * bez niej.
+ * @param[in,out] calc : kalkulator
+ */
+static void CalcEndInput(Calc *calc) {
+	OutputFlush(calc);
+	calc->status = calc->error_flag;
+	calc->error_flag = NO_ERROR;
+}
+
+void CalcFinish(Calc *calc) {
+	if (!calc->input_broken && calc->input_fed.count > 0) {
+		InputFedRun(calc, calc->input_fed.count);
+	}
+	calc->input_fed.count = 0;
+	if (calc->program != NULL) {
+		Program *prog = calc->program;
+		calc->program = NULL;
+		ProgramRun(calc, &calc->stack, prog);
+		free(prog);
+	}
+	CalcEndInput(calc);
+}
+
+void CalcRunFile(Calc *calc, FILE *file, size_t pipeline) {
+	InputInit(calc, file, SIZE_MAX);
+	if (calc->binary_mode) {
+		BinaryRun(calc, &calc->stack);
+	} else if (calc->mode == CALC_COMPILE) {
+		CompiledRun(calc, &calc->stack);
+	} else if (pipeline > 0) {
+		PipelineRun(calc, &calc->stack, pipeline);
+	} else {
+		TextRun(calc, &calc->stack);
+	}
+	CalcEndInput(calc);
+}
+
+bool CalcRunChain(Calc *calc, const char *dir) {
+	bool ok = ChainRun(calc, &calc->stack, dir);
+	CalcEndInput(calc);
+	return ok;
+}
+
+int CalcStatus(const Calc *calc) {
+	return calc->status;
+}
@@ -0,0 +1,116 @@
+/** @file
+   Interfejs kalkulatora działającego na stosie wielomianów
+
+   Kalkulator (sesja) ma własny stos i stan parsera, więc w jednym procesie
+   może działać wiele niezależnych kalkulatorów, także w różnych wątkach
+   (jeden kalkulator naraz używany jest przez jeden wątek). Wspólne dla
+   procesu są tylko mechanizmy włączane przez zmienne środowiskowe
+   (poly_cache.h, poly_thread.h, poly_intern.h, poly_reclaim.h), które
+   są bezpieczne dla wątków.
+
+   Wejście przekazuje się kalkulatorowi porcjami (CalcFeed) albo jako cały
+   strumień (CalcRunFile). Wyniki i komunikaty o błędach trafiają do funkcji
+   podanych przy tworzeniu kalkulatora.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __CALC_H__
+#define __CALC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/** Kalkulator */
+typedef struct Calc Calc;
+
+/**
+ * Funkcja odbierająca wyjście kalkulatora.
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @param[in] user : dane podane przy tworzeniu kalkulatora
+ */
+typedef void (*CalcWriter)(const char *data, size_t size, void *user);
+
+/** Tryby wejścia kalkulatora */
+enum calc_mode_e {
+	CALC_TEXT, ///< komendy tekstowe, wykonywane linia po linii
+	CALC_COMPILE, ///< komendy tekstowe, kompilowane w całości przed wykonaniem
+	CALC_BINARY ///< ramki binarne (zob. poly_wire.h)
+};
+
+/**
+ * Tworzy kalkulator z pustym stosem.
+ * @param[in] mode : tryb wejścia
+ * @param[in] out : odbiorca wyników
+ * @param[in] err : odbiorca komunikatów o błędach
+ * @param[in] user : dane przekazywane odbiorcom
+ * @return kalkulator
+ */
+Calc *CalcNew(enum calc_mode_e mode, CalcWriter out, CalcWriter err,
+			  void *user);
+
+/**
+ * Usuwa kalkulator razem z jego stosem.
+ * @param[in] calc : kalkulator
+ */
+void CalcDelete(Calc *calc);
+
+/**
+ * Ustawia, czy wynik każdej linii (ramki) jest przekazywany od razu,
+ * a nie większymi blokami.
+ * @param[in,out] calc : kalkulator
+ * @param[in] interactive : czy przekazywać wyniki od razu
+ */
+void CalcSetInteractive(Calc *calc, bool interactive);
+
+/**
+ * Przekazuje kalkulatorowi kolejną porcję wejścia. Wykonywane są wszystkie
+ * pełne linie (ramki); reszta czeka na kolejną porcję.
+ * @param[in,out] calc : kalkulator
+ * @param[in] data : bajty wejścia
+ * @param[in] size : liczba bajtów
+ */
+void CalcFeed(Calc *calc, const char *data, size_t size);
+
+/**
+ * Kończy wejście przekazywane przez CalcFeed: wykonuje ostatnią,
+ * niezakończoną linię, a w trybie CALC_COMPILE cały program.
+ * @param[in,out] calc : kalkulator
+ */
+void CalcFinish(Calc *calc);
+
+/**
+ * Wykonuje całe wejście ze strumienia. Przy wykonaniu potokowym wyniki
+ * i komunikaty o błędach przekazuje odbiorcom wątek drukujący potoku,
+ * a nie wątek wywołujący.
+ * Wejście przekazywane przez CalcFeed musi być wcześniej zakończone
+ * (CalcFinish).
+ * @param[in,out] calc : kalkulator
+ * @param[in] file : strumień
+ * @param[in] pipeline : długość kolejek wykonania potokowego komend
+ * tekstowych (0 – wykonanie w jednym wątku)
+ */
+void CalcRunFile(Calc *calc, FILE *file, size_t pipeline);
+
+/**
+ * Wykonuje łańcuch plików z komendami tekstowymi.
+ * @param[in,out] calc : kalkulator
+ * @param[in] dir : katalog łańcucha
+ * @return Czy udało się otworzyć wszystkie pliki łańcucha?
+ */
+bool CalcRunChain(Calc *calc, const char *dir);
+
+/**
+ * Podaje flagę błędu, z którą zakończyło się ostatnie wejście (CalcFinish,
+ * CalcRunFile albo CalcRunChain). Jest różna od 0, gdy ostatnia linia
+ * wejścia nie kończyła się znakiem nowej linii.
+ * @param[in] calc : kalkulator
+ * @return flaga błędu (0 – brak błędu)
+ */
+int CalcStatus(const Calc *calc);
+
+#endif /* __CALC_H__ */
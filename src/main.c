@@ -1,850 +1,145 @@
 /** @file
-   Kalkulator działający na stosie wielomianów rzadkich wielu zmiennych.
+   Program kalkulatora: wykonuje komendy ze stdin (albo łańcuch plików)
+   i wypisuje wyniki na stdout.
 
    @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
    @copyright Uniwersytet Warszawski
    @date 2017-05-27
 */
 
-#include <assert.h>
-#include <stdlib.h>
-#include <stdio.h>
+#define _POSIX_C_SOURCE 200809L ///< umożliwia użycie 'fileno' i 'isatty'
+
+#include <errno.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <limits.h>
+#include <unistd.h>
 
-#include "poly.h"
-#include "stack.h"
+#include "calc.h"
+#include "poly_cache.h"
+#include "poly_intern.h"
+#include "poly_reclaim.h"
+#include "poly_thread.h"
+#include "poly_wire.h"
 
 #include "unit_tests_poly_utils.h"
 
-#define INITIAL_MONOS_SIZE 256 ///< początkowy rozmiar tablicy monosów dla PolyAddMonos w PolyParse
-#define MAX_COMMAND_LENGTH 255 ///< wielkość bufora komendy, jeżeli to zostanie przekroczone to coś poszło horribly wrong
-
-/** Flagi oznaczające typy liczbowe dla funkcji parsujących liczby */
-enum int_type_e {
-	POLY_EXP_T,
-	POLY_COEFF_T,
-	UNSIGNED
-};
-
-/** Flagi błędów */
-enum error_flag_e {
-	NO_ERROR,
-	EOF_FLAG,
-	UNDERFLOW_ERR_FLAG,
-	PARSING_ERR_FLAG,
-	WRONG_COMMAND_ERR_FLAG,
-	WRONG_VALUE_ERR_FLAG,
-	WRONG_VARIABLE_ERR_FLAG,
-	EXCEEDED_COMMAND_BUF_ERR,
-	WRONG_COUNT_ERR_FLAG,
-	TOO_BIG_NUMBER_ERR_FLAG
-};
-
-/* * * PARSER STATE AND ERROR HANDLING * * */
-
-/* These variables will hold the state of the whole parser */
-static unsigned row = 0; ///< numer wiersza na którym jest parser (licząc od 0)
-static unsigned column = 0; ///< numer kolumny na której jest parser
-static enum error_flag_e error_flag = NO_ERROR; ///< flaga ostatnio wykrytego i nieobsłużoneo błędu
-static bool end_of_line = false; ///< flaga wskazująca osiągnięcie końca wiersza
-
-/* Dummy structs for quick escape from functions on error */
-Poly DUMMY_POLY; ///< stała zwracana przez funkcje typu Poly w trakcie ucieczki z błędu
-Mono DUMMY_MONO; ///< stała zwracana przez funkcje typu Mono w trakcie ucieczki z błędu
-
-/**
- * Ustawia flagę błędu.
- * Ustawienie flagi błędu powinno wywołać jak najszybszą ucieczkę z kolejnych
- * kontekstów aż do osiągnięcia main(), gdzie błąd będzie obsłużony przez
- * ErrorHandle()
- * @param[in] flag : flaga błędu
- */
-void ErrorSetFlag(enum error_flag_e flag) {
-	error_flag = flag;
-}
-
-/**
- * Informuje o nieobsłużonych błędach.
- * Funkcje po wywołaniu innej funkcji sprawdzają Error() i w razie wystąpienia
- * błędu jak najszybciej 'propagują go' wyżej
- * @return obecnie ustawiona flaga błędu (0, jeżeli błąd jeszcze nie wystąpił)
- */
-int Error() {
-	return error_flag;
-}
-
-/**
- * Obsługuje błąd – akcja zależy od ustawionej flagi błędu.
- * W kontekscie zadania jedynie drukuje informację na stderr i resetuje flagę.
- */
-void ErrorHandle() {
-	switch (error_flag) {
-	case UNDERFLOW_ERR_FLAG:
-		fprintf(stderr, "ERROR %d STACK UNDERFLOW\n", row + 1);
-		break;
-	case PARSING_ERR_FLAG:
-	case TOO_BIG_NUMBER_ERR_FLAG:
-		fprintf(stderr, "ERROR %d %d\n", row + 1, column);
-		break;
-	case WRONG_COMMAND_ERR_FLAG:
-		fprintf(stderr, "ERROR %d WRONG COMMAND\n", row + 1);
-		break;
-	case WRONG_VALUE_ERR_FLAG:
-		fprintf(stderr, "ERROR %d WRONG VALUE\n", row + 1);
-		break;
-	case WRONG_VARIABLE_ERR_FLAG:
-		fprintf(stderr, "ERROR %d WRONG VARIABLE\n", row + 1);
-		break;
-	case WRONG_COUNT_ERR_FLAG:
-		fprintf(stderr, "ERROR %d WRONG COUNT\n", row + 1);
-		break;		
-	default:
-		break;
-	}
-	error_flag = 0;
-}
-
-/* * * OUTPUT FUNCTIONS * * */
-
-/**
- * Drukuje wartość logiczną ze znakiem nowej linii.
- * @param[in] val : wartość do wydrukowania
- */
-void BoolPrint(bool val) {
-	if (val) {
-		printf("1\n");
-	} else {
-		printf("0\n");
-	}
-}
-
-/**
- * Drukuje wielomiam.
- * @param[in] p : wielomian do wydrukowania
- */
-void PolyPrint(Poly *p);
-
-/**
- * Drukuje jednomian.
- * @param[in] m : jednomian do wydrukowania
- */
-void MonoPrint(Mono *m) {
-	printf("(");
-	PolyPrint(&(m->p));
-	printf(",%d)", m->exp);
-}
+#define CHAIN_OPTION "--chain" ///< opcja wiersza poleceń włączająca wykonanie łańcucha plików
+#define COMPILE_OPTION "--compile" ///< opcja wiersza poleceń włączająca kompilację wejścia przed wykonaniem
+#define PIPELINE_ENV "CALC_POLY_PIPELINE" ///< zmienna środowiskowa z długością kolejek potoku (zob. PipelineRun)
 
 /**
- * Przekształca wielomian do postaci pozwalającej na wydrukowanie wg wymagań
- * @param[in] p : wielomian do przygotowania
- * @param[in] memory_flag : informuje funkcję wywołującą czy użyto alokacji pamięci
- * @return wielomian gotowy do druku
+ * Wypisuje wyjście kalkulatora na stdout.
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @param[in] user : nieużywane
  */
-Poly PolyPrepareForPrint(Poly *p, bool *memory_flag) {
-	/* Wielomian w naszej implementacji mógłby chcieć się wydrukwać jako np.
-	 * "7+(((1,1),0)+(2,2),0)+(2,3)"
-	 * a powinien
-	 * "(((7,0)+(1,1),0)+(2,2),0)+(2,3)"
-	 * Łatwiej przekształcić wielomian w tej egzotycznej sytuacji, niż wykrywać
-	 * to w funkcji drukującej.
-	 */
-	if (p->scalar != 0 && p->monos_count > 1 && p->monos[0].exp == 0) {
-		Poly r = PolyClone(p);
-		r.scalar = 0;
-		r.monos[0].p.scalar += p->scalar;
-		*memory_flag = true;
-		return r;
-	}
-	return *p;
-}
-
-void PolyPrint(Poly *p) {
-	if (PolyIsCoeff(p)) {
-		printf("%ld", p->scalar);
-	} else {
-		bool was_memory_allocated = false;
-		Poly q = PolyPrepareForPrint(p, &was_memory_allocated);
-
-		/* jeżeli po preparacji został jakiś skalar, to znaczy ze nie było
-		 * jednomianu z exp = 0 gdzie trzeba by go było wsadzić */
-		if (q.scalar != 0) {
-			printf("(%ld,0)", q.scalar);
-		}
-		for (unsigned i = 0; i < q.monos_count; i++) {
-			if (i > 0 || q.scalar != 0) {
-				printf("+");
-			}
-			MonoPrint(&(q.monos[i]));
-		}
-
-		if (was_memory_allocated) {
-			PolyDestroy(&q);
+void StdoutWrite(const char *data, size_t size, void *user) {
+	(void) user;
+	size_t done = 0;
+	while (done < size) {
+		ssize_t written = write(STDOUT_FILENO, data + done, size - done);
+		if (written < 0 && errno == EINTR) {
+			continue;
 		}
-	}
-}
-
-
-/* * * INPUT FUNCTIONS * * */
-
-/**
- * Podgląda następny znak z stdin bez usuwania go ze strumienia.
- * @return znak na stdin
- */
-int SeeChar() {
-	if (feof(stdin)) {
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		return EOF;
-	}
-	int r = getchar();
-	ungetc(r, stdin);
-	return r;
-}
-
-/**
- * Jak getchar(), plus aktualizuje stan parsera.
- * @return getchar()
- */
-int GetChar() {
-	int ch;
-	if ((ch = getchar()) == '\n') {
-		end_of_line = true;
-	} else {
-		end_of_line = false;
-	}
-	column++;
-	return ch;
-}
-
-/**
- * Przewija stdin do następnej linii.
- * @param[in] eof_flag : informuje fukcję wywołującą, czy napotkano End Of File
- */
-void GoToNextLine(bool *eof_flag) {
-	/* check if we haven't already reached the end of the line */
-	if (end_of_line) { return; }
-
-	int ch = SeeChar();
-
-	/* W momencie wywołania tej funkcji, nie powinno być już znaków na stdin */
-	if (!Error() && ch != '\n' && ch != EOF) {
-		column++;
-		ErrorSetFlag(PARSING_ERR_FLAG);
-	}
-
-	while (Error() && ch != '\n' && ch != EOF) {
-		getchar();
-		ch = SeeChar();
-		if (ch == EOF) {
-			*eof_flag = EOF_FLAG;
-			return;
+		if (written <= 0) {
+			break;
 		}
-	}
-
-	ch = getchar(); // must be '\n' or End Of File
-	if (ch == EOF) {
-		*eof_flag = true;
-	}
-}
-
-/**
- * Wczytuje wielomian z stdin.
- * @return wczytany wielomian
- */
-Poly PolyParse();
-
-/**
- * Sprawdza, czy do liczby r można dokleić cyfrę bez przekraczania limitu
- * @param[in] r : liczba
- * @param[in] digit : doklejana cyfra
- * @param[in] max_val : limit
- * @param[in] minus : określa czy badana liczba jest ujemna
- */
-void ValidateNextDigit(long r, int digit, bool minus, long max_val) {
-	if (r > max_val / 10 ||
-			(r == max_val / 10 && digit > (max_val % 10) + minus)) {
-		ErrorSetFlag(TOO_BIG_NUMBER_ERR_FLAG);
+		done += written;
 	}
 }
 
 /**
- * Sprawdza, czy znak jest liczbą, bądź minusem
- * @param[in] ch : znak
- * @return : Czy znak jest liczbą lub minusem?
+ * Wypisuje komunikat kalkulatora o błędzie na stderr.
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @param[in] user : nieużywane
  */
-bool IsDigitOrMinus(int ch) {
-	return isdigit(ch) || ch == '-';
+void StderrWrite(const char *data, size_t size, void *user) {
+	(void) user;
+	fprintf(stderr, "%.*s", (int) size, data);
 }
 
 /**
- * Wczytuje liczbę z tablicy znaków lub stdin, jeżeli nie podano tablicy
- * @param[in] c : tablica znaków
- * @param[in] type : flaga typu liczby, słuzy do obsługi niepoprawnych wartości
- * @return wczytana liczba
- */
-long NumberRead(char *c, enum int_type_e type) {
-	if ((c && !IsDigitOrMinus(c[0])) ||
-	   (!c && !IsDigitOrMinus(SeeChar()))) {
-		if (!c) { GetChar(); }
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		return 0;
-	}
-
-	/* obsługa minusa */
-	bool minus = false;
-	if ((!c && SeeChar() == '-') ||
-		(c && c[0] == '-')) {
-		if (type == POLY_EXP_T || type == UNSIGNED) {
-			ErrorSetFlag(PARSING_ERR_FLAG);
-			return 0;
-		}
-
-		minus = true;
-		if (c) {
-			c++;
-		} else {
-			GetChar(); // '-'
-		}
-	}
-
-	int ch;
-	if (c) {
-		ch = c[0];
-	} else {
-		ch = SeeChar();
-	}
-	int digit;
-	long r = 0;
-	while (isdigit(ch)) {
-		if (c) {
-			c++;
+ * Główna funkcja programu.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty; POLY_WIRE_OPTION włącza tryb binarny,
+ * CHAIN_OPTION z katalogiem – wykonanie łańcucha plików z tego katalogu,
+ * a COMPILE_OPTION – kompilację wejścia przed wykonaniem
+ * @return flaga ostatniego nieobsłużonego błędu (1, gdy nie udało się
+ * wykonać łańcucha)
+ */
+int main(int argc, char *argv[]) {
+	enum calc_mode_e mode = CALC_TEXT;
+	const char *chain_dir = NULL;
+	int modes = 0;
+	for (int i = 1; i < argc; i++, modes++) {
+		if (strcmp(argv[i], POLY_WIRE_OPTION) == 0) {
+			mode = CALC_BINARY;
+		} else if (strcmp(argv[i], CHAIN_OPTION) == 0 && i + 1 < argc) {
+			chain_dir = argv[++i];
+		} else if (strcmp(argv[i], COMPILE_OPTION) == 0) {
+			mode = CALC_COMPILE;
 		} else {
-			ch = GetChar();
-		}
-		digit = ch - 48; // '0' = 48
-
-		switch (type) {
-		case POLY_EXP_T:
-			ValidateNextDigit(r, digit, minus, POLY_EXP_MAX);
+			modes = 2;
 			break;
-		case POLY_COEFF_T:
-			ValidateNextDigit(r, digit, minus,  POLY_COEFF_MAX);
-			break;
-		case UNSIGNED:
-			ValidateNextDigit(r, digit, minus, UINT32_MAX);
-			break;
-		default:
-			assert(false);
-			break;
-		}
-		if (Error()) { return 0; }
-
-		r = 10 * r + digit;
-		if (c) {
-			ch = c[0];
-		} else {
-			ch = SeeChar();
 		}
 	}
-
-	if (c && c[0] != '\0') {
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		return 0;
-	}
-
-	if (minus) {
-		return -r;
-	}
-	return r;
-}
-
-/**
- * Wczytuje liczbę z stdin
- * @param[in] type : flaga typu liczby, używana do obsługi błędnych wartości
- * @return wczytana liczba
- */
-long NumberParse(int type) {
-	return NumberRead(NULL, type);
-}
-
-/**
- * Wczytuje jednomian ze stdin.
- * @return wczytany jednomian
- */
-Mono MonoParse() {
-	if (GetChar() != '(') {
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		return DUMMY_MONO;
-	}
-
-	Poly p = PolyParse();
-	if (Error()) {
-		PolyDestroy(&p);
-		return DUMMY_MONO;
-	}
-
-	if (GetChar() != ',') {
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		PolyDestroy(&p);
-		return DUMMY_MONO;
+	if (modes > 1) {
+		fprintf(stderr, "usage: %s [%s | %s DIR | %s]\n", argv[0],
+				POLY_WIRE_OPTION, CHAIN_OPTION, COMPILE_OPTION);
+		return 1;
 	}
 
-	int ch = SeeChar();
-	if (!IsDigitOrMinus(ch)) {
-		GetChar();
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		PolyDestroy(&p);
-		return DUMMY_MONO;
+	/* pamięć podręczna wyników jest włączana tylko na życzenie */
+	char *cache_bytes = getenv(POLY_CACHE_ENV);
+	if (cache_bytes != NULL) {
+		PolyCacheInit(strtoull(cache_bytes, NULL, 10));
 	}
 
-	poly_exp_t e = NumberParse(POLY_EXP_T);
-	if (Error()) {
-		PolyDestroy(&p);
-		return DUMMY_MONO;
+	/* bez ustawienia liczby wątków liczymy w jednym wątku */
+	char *threads = getenv(POLY_THREADS_ENV);
+	if (threads != NULL) {
+		PolyThreadsInit(strtoul(threads, NULL, 10));
 	}
 
-	if (GetChar() != ')') {
-		ErrorSetFlag(PARSING_ERR_FLAG);
-		PolyDestroy(&p);
-		return DUMMY_MONO;
+	/* wspólne poddrzewa wielomianów na stosie przechowujemy raz */
+	char *intern = getenv(POLY_INTERN_ENV);
+	if (intern != NULL && strtoul(intern, NULL, 10) != 0) {
+		PolyInternInit();
 	}
 
-	return MonoFromPoly(&p, e);
-}
-
-Poly PolyParse() {
-	if (SeeChar() == '(') { /* array of monos */
-		/* we create a dynamic array of monos and will be growing it when
-		 * there's a need for more space */
-		size_t monos_size = INITIAL_MONOS_SIZE;
-		Mono *monos = calloc(monos_size, sizeof(Mono));
-		assert(monos != NULL);
-		size_t monos_count = 0;
-
-		int c;
-		while (true) {
-			if (monos_count == monos_size) {
-				monos_size *= 2;
-				monos = realloc(monos, monos_size * sizeof(Mono));
-				assert(monos != NULL);
-			}
-
-			monos[monos_count] = MonoParse();
-			if (Error()) {
-				free(monos);
-				return DUMMY_POLY;
-			}
-
-			monos_count++;
-			if ((c = SeeChar()) != '+') { // probably ',' or '\n' or 'EOF'
-				break;
-			} else {
-				GetChar(); // '+'
-			}
-		}
-
-		Poly p = PolyAddMonos(monos_count, monos);
-		free(monos);
-		return p;
-
-	} else /* a scalar */ {
-		poly_coeff_t r = NumberParse(POLY_COEFF_T);
-		if (Error()) { return DUMMY_POLY; }
-
-		return PolyFromCoeff(r);
+	/* zużyte wielomiany usuwamy w tle tylko na życzenie */
+	char *reclaim = getenv(POLY_RECLAIM_ENV);
+	if (reclaim != NULL) {
+		PolyReclaimInit(strtoull(reclaim, NULL, 10));
 	}
-}
 
+	/* potokowe wykonanie wejścia tekstowego tylko na życzenie */
+	char *pipeline = getenv(PIPELINE_ENV);
 
-/* * * POLY OPERATIONS * * */
-
-/**
- * jak GetTop(), ale sprawdza, czy na stosie jest wielomian
- * @param[in] s : stos
- * @return GetTop(s)
- */
-Poly GetTopSafely(Stack *s) {
-	if (IsEmpty(s)) {
-		ErrorSetFlag(UNDERFLOW_ERR_FLAG);
-		return DUMMY_POLY;
-	}
-	return GetTop(s);
-}
-
-/**
- * Jak Pop(), ale sprawdza czy na stosie jest wielomian do zrzucenia
- * @param[in] s : stos
- * @return Pop(s)
- */
-Poly PopSafely(Stack *s) {
-	if (IsEmpty(s)) {
-		ErrorSetFlag(UNDERFLOW_ERR_FLAG);
-		return DUMMY_POLY;
-	}
-	return Pop(s);
-}
-
-/**
- * Działa operacją na dwóch wielomianach na wierzchu stosu i wynik wstawia na
- * ich miejsce.
- * @param[in] s : stos
- * @param[in] op : działanie wielomian x wielomian → wielomian
- */
-void ActOnTwoPolysOnStack(Stack *s,
-						  Poly (*op)(const Poly *, const Poly *)) {
-	Poly p = PopSafely(s);
-	if (Error()) { return; }
-
-	Poly q = PopSafely(s);
-	if (Error()) {
-		/* zwracamy p, żeby stos był w takim stanie jak przed errorem */
-		Push(s, &p);
-		return;
-	}
-
-	Poly r = op(&p, &q);
-	PolyDestroy(&p);
-	PolyDestroy(&q);
-
-	Push(s, &r);
-}
-
-/**
- * Zastępuje dwa wielomiany na wierzchu stosu ich sumą
- * @param[in] s : stos
- */
-void AddTwoPolysFromStack(Stack *s) {
-	return ActOnTwoPolysOnStack(s, PolyAdd);
-}
-
-/**
- * Zastępuje dwa wielomiany na wierzchu stosu ich iloczynem
- * @param[in] s : stos
- */
-void MultiplyTwoPolysFromStack(Stack *s) {
-	return ActOnTwoPolysOnStack(s, PolyMul);
-}
-
-/**
- * Zastępuje dwa wielomiany na wierzchu stosu ich różnicą
- * @param[in] s : stos
- */
-void SubtractTwoPolysFromStack(Stack *s) {
-	return ActOnTwoPolysOnStack(s, PolySub);
-}
-
-/**
- * Drukuje, czy dwa wielomiany na wierzchu stosu są równe
- * @param[in] s : stos
- */
-void PrintAreEqualTwoPolysFromStack(Stack *s) {
-	Poly p = PopSafely(s);
-	if (Error()) { return; }
-
-	Poly q = GetTopSafely(s);
-	if (Error()) {
-		Push(s, &p);
-		return;
-	}
-
-	bool r = PolyIsEq(&p, &q);
-	Push(s, &p);
-	BoolPrint(r);
-}
-
-/**
- * Drukuje czy wielomian na wierzchu stosu jest skalarem
- * @param[in] s : stos
- */
-void IsCoeffPolyOnStack(Stack *s) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	BoolPrint(PolyIsCoeff(&top));
-}
-
-/**
- * Drukuje czy wielomian na wierzchu stosu jest zerem
- * @param[in] s : stos
- */
-void IsZeroPolyOnStack(Stack *s) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	BoolPrint(PolyIsZero(&top));
-}
-
-/**
- * Wrzuca na stos kopię wielomianu na wierzchu tego stosu
- * @param[in] s : stos
- */
-void ClonePolyOnStack(Stack *s) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	Poly p = PolyClone(&top);
-	Push(s, &p);
-}
-
-/**
- * Zastępuje wielomian na wierzchu stosu jego przeciwieństwem
- * @param[in] s : stos
- */
-void NegatePolyOnStack(Stack *s) {
-	Poly p = PopSafely(s);
-	if (Error()) { return; }
-
-	Poly q = PolyNeg(&p);
-	PolyDestroy(&p);
-	Push(s, &q);
-}
-
-/**
- * Drukuje stopień wielomianu znajdujacego się na wierzchu stosu
- * @param[in] s : stos
- */
-void PrintDegreePolyOnStack(Stack *s) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	printf("%d\n", PolyDeg(&top));
-}
-
-/**
- * Drukuje wielomian znajdujący się na wierzchu stosu.
- * @param[in] s : stos
- */
-void PrintPolyOnStack(Stack *s) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	PolyPrint(&top);
-	printf("\n");
-}
-
-/** Polecenie to zdejmuje z wierzchołka stosu najpierw wielomian p, a potem 
- * kolejno wielomiany x[0], x[1], …, x[count - 1] i umieszcza na stosie wynik
- * funkcji PolyCompose
- * @param[in] s : stos
- * @param[in] count : liczba wielomianów do zmielenia
-*/
-void ComposePolysOnStack(Stack *s, unsigned count) {
-	if (!HasElements(s, 1)) {
-		ErrorSetFlag(UNDERFLOW_ERR_FLAG);
-		return;
-	}
-
-	Poly p = Pop(s);
-
-	if (!HasElements(s, count)) {
-		ErrorSetFlag(UNDERFLOW_ERR_FLAG);
-		Push(s, &p);
-		return;
-	}
-
-	Poly x[count];
-	for (unsigned i = 0; i < count; i++) {
-		x[i] = Pop(s);
-		if (i == UINT_MAX) {
-			break;
-		}
-	}
-	Poly r = PolyCompose(&p, count, x);
-	Push(s, &r);
-	
-	PolyDestroy(&p);
-	for (unsigned i = 0; i < count; i++) {
-		PolyDestroy(&(x[i]));
-		if (i == UINT_MAX) {
-			break;
-		}
-	}
-}
-
-/**
- * Drukuje stopień wielomianu na wierzchu stosu ze względu na n-tą zmienną
- * @param[in] s : stos
- * @param[in] n : n
- */
-void PrintDegBy(Stack *s, unsigned n) {
-	Poly top = GetTopSafely(s);
-	if (Error()) { return; }
-
-	int r = PolyDegBy(&top, n);
-	printf("%d\n", r);
-}
-
-/**
- * Zastępuje wielomian na wierzchu stosu jego "wartością w punkcie x"
- * (obcięciem do zbioru `{(x_1, x_2, ...) : x_1 = x}`)
- * @param[in] s : stos
- * @param[in] x : x
- */
-void CalculatePolyAt(Stack *s, poly_coeff_t x) {
-
-
-	Poly top = PopSafely(s);
-	if (Error()) { return; }
-
-	Poly p = PolyAt(&top, x);
-	PolyDestroy(&top);
-	Push(s, &p);
-}
-
-/* * * THE PROGRAM * * */
-
-/**
- * Wykonuje komendę zawartą w tablicy znaków.
- * @param[in] s : stos wielomianów na którym operujemy
- * @param[in] command : tablica znaków zawierająca komendę do wykonania
- */
-void ExecuteCommand(Stack *s, char *command) {
-	if (strcmp(command, "ZERO") == 0) {
-		Poly p = PolyZero();
-		Push(s, &p);
-
-	} else if (strcmp(command, "IS_COEFF") == 0) {
-		IsCoeffPolyOnStack(s);
-
-	} else if (strcmp(command, "IS_ZERO") == 0) {
-		IsZeroPolyOnStack(s);
-
-	} else if (strcmp(command, "CLONE") == 0) {
-		ClonePolyOnStack(s);
-
-	} else if (strcmp(command, "ADD") == 0) {
-		AddTwoPolysFromStack(s);
-
-	} else if (strcmp(command, "MUL") == 0) {
-		MultiplyTwoPolysFromStack(s);
-
-	} else if (strcmp(command, "NEG") == 0) {
-		NegatePolyOnStack(s);
-
-	} else if (strcmp(command, "SUB") == 0) {
-		SubtractTwoPolysFromStack(s);
-
-	} else if (strcmp(command, "IS_EQ") == 0) {
-		PrintAreEqualTwoPolysFromStack(s);
-
-	} else if (strcmp(command, "DEG") == 0) {
-		PrintDegreePolyOnStack(s);
-
-	} else if (strcmp(command, "PRINT") == 0) {
-		PrintPolyOnStack(s);
-
-	} else if (strcmp(command, "POP") == 0) {
-		Poly p = PopSafely(s);
-		if (Error()) { return; }
-		PolyDestroy(&p);
-		
-	
-	} else if (strncmp(command, "COMPOSE", 7) == 0) {
-		if (Error() == EXCEEDED_COMMAND_BUF_ERR || command[7] != ' ') {
-			ErrorSetFlag(WRONG_COUNT_ERR_FLAG);
-			return;
-		}
-
-		unsigned arg = NumberRead(command + 8, UNSIGNED);
-		if (Error()) {
-			ErrorSetFlag(WRONG_COUNT_ERR_FLAG);
-			return;
-		}
-		ComposePolysOnStack(s, arg);
-
-	} else if (strncmp(command, "DEG_BY", 6) == 0) {
-		if (Error() == EXCEEDED_COMMAND_BUF_ERR || command[6] != ' ') {
-			ErrorSetFlag(WRONG_VARIABLE_ERR_FLAG);
-			return;
-		}
-
-		unsigned arg = NumberRead(command + 7, UNSIGNED);
-		if (Error()) {
-			ErrorSetFlag(WRONG_VARIABLE_ERR_FLAG);
-			return;
-		}
-		PrintDegBy(s, arg);
-
-	} else if (strncmp(command, "AT", 2) == 0) {
-		if (Error() == EXCEEDED_COMMAND_BUF_ERR || command[2] != ' ') {
-			ErrorSetFlag(WRONG_VALUE_ERR_FLAG);
-			return;
-		}
-
-		poly_coeff_t arg = NumberRead(command + 3, POLY_COEFF_T);
-		if (Error()) {
-			ErrorSetFlag(WRONG_VALUE_ERR_FLAG);
-			return;
-		}
-		CalculatePolyAt(s, arg);
-		
+	bool ok = true;
+	Calc *calc = CalcNew(mode, StdoutWrite, StderrWrite, NULL);
+	CalcSetInteractive(calc, isatty(fileno(stdout)));
+	if (chain_dir != NULL) {
+		ok = CalcRunChain(calc, chain_dir);
 	} else {
-		ErrorSetFlag(WRONG_COMMAND_ERR_FLAG);
+		CalcRunFile(calc, stdin,
+					pipeline != NULL ? strtoull(pipeline, NULL, 10) : 0);
 	}
-}
-
-/**
- * Główna funkcja programu.
- * @return flaga ostatniego nieobsłużonego błędu
- */
-int main() {
-	Stack s = StackEmpty();
-	row = 0;
-	error_flag = NO_ERROR;
+	int status = ok ? CalcStatus(calc) : 1;
+	CalcDelete(calc);
 
-	char command_buf[MAX_COMMAND_LENGTH] = {'\0'};
-	size_t new_line_pos;
-	int ch;
-	bool eof_flag = false;
+	PolyReclaimDestroy();
+	PolyInternDestroy();
 
-	while (!eof_flag) {
-		end_of_line = false;
-		column = 0;
-		ch = SeeChar();
-
-		if (ch == EOF) {
-			break;
-		} else if (isalpha(ch)) { /* komenda */
-			/* komendy możemy trzymać w buforze o ograniczonej pojemności */
-			//scanf("%s", command_buf);
-			fgets(command_buf, sizeof command_buf, stdin);
-
-			new_line_pos = strcspn(command_buf, "\r\n");
-			if (!(new_line_pos == MAX_COMMAND_LENGTH - 1)) {
-				/* Gdzieś w buforze jest '\n'. Po przeczytaniu go więc
-				   skończy się już linia i musimy to pamiętać.
-				*/
-				end_of_line = true;
-				command_buf[new_line_pos] = 0;
-			} else {
-				/* Ktoś wprowadził zbyt długą komendę lub argument.
-				   Nie możemy jeszcze obsłużyć błędu, bo zależnie od komendy
-				   będziemy podawać różne komunikaty. */
-				ErrorSetFlag(EXCEEDED_COMMAND_BUF_ERR);
-			}
-
-			ExecuteCommand(&s, command_buf);
-
-			if (Error()) {
-				ErrorHandle();
-				GoToNextLine(&eof_flag);
-			}
-
-		} else { /* wielomian */
-			Poly p = PolyParse();
-			GoToNextLine(&eof_flag);
-			if (!(Error())) {
-				Push(&s, &p);
-			} else {
-				PolyDestroy(&p);
-				ErrorHandle();
-			}
-		}
-		row++;
+	if (PolyCacheEnabled()) {
+		fprintf(stderr, "CACHE HITS %zu MISSES %zu\n",
+				PolyCacheHits(), PolyCacheMisses());
+		PolyCacheDestroy();
 	}
+	PolyThreadsDestroy();
 
-	StackDestroy(&s);
-	return error_flag;
+	return status;
 }
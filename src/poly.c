@@ -2,9 +2,44 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <pthread.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "poly.h"
+#include "poly_cache.h"
+#include "poly_intern.h"
+#include "poly_snapshot.h"
+#include "poly_thread.h"
+#include "work_stack.h"
+
+/**
+ * Najmniejsza liczba iloczynów jednomianów, od której PolyMul dzieli pracę
+ * między wątki
+ */
+#define PARALLEL_MUL_MIN_PRODUCTS 64
+
+/**
+ * Najmniejsza liczba jednomianów, od której PolyCompose składa jednomiany
+ * w osobnych wątkach
+ */
+#define PARALLEL_COMPOSE_MIN_MONOS 4
+
+/**
+ * Najmniejsza łączna liczba jednomianów składników, od której PolyAdd
+ * dodaje przedziały jednomianów w osobnych wątkach
+ */
+#define PARALLEL_ADD_MIN_MONOS 4096
+
+/**
+ * Najmniejsza (szacowana) liczba jednomianów poddrzewa węzła, od której
+ * PolyClone, PolyDestroy i PolyIsEq przechodzą jego jednomiany w osobnych
+ * wątkach
+ */
+#define PARALLEL_TRAVERSAL_MIN_MONOS 1024
+
+/** Liczba jednomianów węzła, z których szacujemy rozmiar jego poddrzewa */
+#define TRAVERSAL_SAMPLE 8
 
 /**
  * Używana konwencja:
@@ -18,6 +53,51 @@
  */
 
 
+/** klucz stosów roboczych wątku; stosy zwalniane są przy końcu wątku */
+static pthread_key_t work_stacks_key;
+/** tworzy `work_stacks_key` przy pierwszym użyciu */
+static pthread_once_t work_stacks_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Zwalnia stosy robocze kończącego się wątku.
+ * @param[in] data : stosy robocze (WorkStacks)
+ */
+void WorkStacksFree(void *data) {
+	WorkStacks *stacks = data;
+	WorkStackFree(&(stacks->destroy));
+	WorkStackFree(&(stacks->clone));
+	WorkStackFree(&(stacks->add));
+	WorkStackFree(&(stacks->scalar_mul));
+	WorkStackFree(&(stacks->deg_by));
+	WorkStackFree(&(stacks->deg));
+	WorkStackFree(&(stacks->is_eq));
+	WorkStackFree(&(stacks->is_zero));
+	WorkStackFree(&(stacks->intern));
+	WorkStackFree(&(stacks->intern_delete));
+	free(stacks);
+}
+
+/**
+ * Tworzy klucz stosów roboczych.
+ */
+void WorkStacksKeyCreate() {
+	int err = pthread_key_create(&work_stacks_key, WorkStacksFree);
+	assert(err == 0);
+	(void) err;
+}
+
+WorkStacks *ThreadWorkStacks() {
+	pthread_once(&work_stacks_once, WorkStacksKeyCreate);
+	WorkStacks *stacks = pthread_getspecific(work_stacks_key);
+	if (stacks == NULL) {
+		stacks = calloc(1, sizeof(WorkStacks));
+		assert(stacks != NULL);
+		pthread_setspecific(work_stacks_key, stacks);
+	}
+	return stacks;
+}
+
+
 /**
  * Zapisuje jednomian w n-tym polu tablicy.
  * @param[in] list : tablica jednomianów
@@ -50,12 +130,246 @@ int MonoExpCompareForQsort(const void *m, const void *o) {
 }
 
 /**
- * Sortuje w miejscu tablicę jednomianów
+ * Scala dwa przylegające, posortowane fragmenty tablicy jednomianów.
+ * Wynik trafia do tablicy @p dst pod te same indeksy.
+ * @param[in] src : tablica źródłowa
+ * @param[in] dst : tablica docelowa
+ * @param[in] begin : początek pierwszego fragmentu
+ * @param[in] middle : początek drugiego fragmentu
+ * @param[in] end : koniec drugiego fragmentu
+ */
+void MergeMonoRuns(const Mono *src, Mono *dst, size_t begin, size_t middle,
+				   size_t end) {
+	size_t i = begin;
+	size_t j = middle;
+	size_t k = begin;
+
+	while (i < middle && j < end) {
+		if (src[j].exp < src[i].exp) {
+			dst[k++] = src[j++];
+		} else {
+			dst[k++] = src[i++];
+		}
+	}
+	while (i < middle) {
+		dst[k++] = src[i++];
+	}
+	while (j < end) {
+		dst[k++] = src[j++];
+	}
+}
+
+/**
+ * Sortuje w miejscu tablicę jednomianów.
+ * Tablice przekazywane do sortowania zwykle składają się z kilku już
+ * posortowanych serii (np. wynik PolyMul to sklejenie `q->monos_count`
+ * rosnących serii), więc zamiast qsort wyszukujemy serie rosnące i scalamy
+ * je parami (naturalny merge sort). Tablica posortowana kosztuje jeden przebieg.
  * @param[in] list : tablica jednomianów
  * @param[in] count : liczba elementów tablicy jednomianów
  */
 void SortMonosByExp(Mono *list, unsigned count) {
-	qsort(list, count, sizeof(Mono), MonoExpCompareForQsort);
+	/* granice serii: runs[r] to początek r-tej serii, runs[runs_count] = count */
+	size_t runs_count = 0;
+	for (unsigned i = 1; i < count; i++) {
+		if (list[i].exp < list[i - 1].exp) {
+			runs_count++;
+		}
+	}
+	if (runs_count == 0) {
+		return;
+	}
+	runs_count++;
+
+	size_t *runs = malloc((runs_count + 1) * sizeof(size_t));
+	Mono *buf = malloc(count * sizeof(Mono));
+	assert(runs != NULL && buf != NULL);
+
+	size_t r = 0;
+	runs[r++] = 0;
+	for (unsigned i = 1; i < count; i++) {
+		if (list[i].exp < list[i - 1].exp) {
+			runs[r++] = i;
+		}
+	}
+	runs[r] = count;
+
+	Mono *src = list;
+	Mono *dst = buf;
+	while (runs_count > 1) {
+		size_t new_count = 0;
+		for (r = 0; r + 1 < runs_count; r += 2) {
+			MergeMonoRuns(src, dst, runs[r], runs[r + 1], runs[r + 2]);
+			runs[new_count++] = runs[r];
+		}
+		/* nieparzysta seria na końcu przechodzi bez zmian */
+		if (r < runs_count) {
+			for (size_t i = runs[r]; i < runs[r + 1]; i++) {
+				dst[i] = src[i];
+			}
+			runs[new_count++] = runs[r];
+		}
+		runs[new_count] = count;
+		runs_count = new_count;
+
+		Mono *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if (src != list) {
+		for (unsigned i = 0; i < count; i++) {
+			list[i] = src[i];
+		}
+	}
+
+	free(buf);
+	free(runs);
+}
+
+void PolyCollapse(Poly *p) {
+	if (PolyIsCoeff(p)) {
+		p->skip = 0;
+		return;
+	}
+	Poly *c = &(p->monos[0].p);
+	if (p->monos_count != 1 || p->monos[0].exp != 0 || PolyIsCoeff(c)) {
+		return;
+	}
+	assert(c->scalar == 0);
+
+	Mono *monos = p->monos;
+	p->skip += 1 + c->skip;
+	p->monos = c->monos;
+	p->monos_count = c->monos_count;
+	free(monos);
+}
+
+Poly PolyView(const Poly *p, unsigned skip, Mono *tmp) {
+	if (PolyIsCoeff(p) || p->skip == skip) {
+		return *p;
+	}
+	assert(p->skip > skip);
+
+	tmp->p = *p;
+	tmp->p.scalar = 0;
+	tmp->p.skip = p->skip - skip - 1;
+	tmp->exp = 0;
+
+	Poly r = *p;
+	r.monos = tmp;
+	r.monos_count = 1;
+	r.skip = skip;
+	return r;
+}
+
+/**
+ * Zmniejsza w miejscu `skip` wielomianu, tak jak PolyView, ale na własnej
+ * pamięci.
+ * @param[in,out] p : wielomian niebędący skalarem
+ * @param[in] skip : docelowe `skip` (nie większe niż `p->skip`)
+ */
+void PolyExpand(Poly *p, unsigned skip) {
+	if (p->skip == skip) {
+		return;
+	}
+	Mono *monos = malloc(sizeof(Mono));
+	assert(monos != NULL);
+	PolyView(p, skip, monos);
+	p->monos = monos;
+	p->monos_count = 1;
+	p->skip = skip;
+}
+
+/**
+ * Zwraca `skip`, przy którym można działać na jednomianach obu wielomianów:
+ * najmniejsze `skip` wielomianów niebędących skalarami.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return wspólne `skip`
+ */
+unsigned AlignedSkip(const Poly *p, const Poly *q) {
+	if (PolyIsCoeff(p)) {
+		return q->skip;
+	}
+	if (PolyIsCoeff(q) || p->skip < q->skip) {
+		return p->skip;
+	}
+	return q->skip;
+}
+
+/**
+ * Dodaje w miejscu wielomian @p q do wielomianu @p p.
+ * Przejmuje na własność zawartość @p q (po wywołaniu @p q jest zerem).
+ * W odróżnieniu od PolyAdd nie kopiuje jednomianów, tylko je przenosi.
+ * @param[in,out] p : wielomian, do którego dodajemy
+ * @param[in] q : dodawany wielomian
+ */
+void PolyAccumulate(Poly *p, Poly *q) {
+	p->scalar = CoeffAdd(p->scalar, q->scalar);
+
+	if (PolyIsCoeff(q)) {
+		*q = PolyZero();
+		return;
+	}
+	if (PolyIsCoeff(p)) {
+		p->monos = q->monos;
+		p->monos_count = q->monos_count;
+		p->skip = q->skip;
+		*q = PolyZero();
+		return;
+	}
+
+	/* jednomiany muszą być jednomianami tej samej zmiennej */
+	if (p->skip > q->skip) {
+		PolyExpand(p, q->skip);
+	} else {
+		PolyExpand(q, p->skip);
+	}
+
+	Mono *monos = malloc((p->monos_count + q->monos_count) * sizeof(Mono));
+	assert(monos != NULL);
+
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
+	while (i < p->monos_count && j < q->monos_count) {
+		Mono *pm = &(p->monos[i]);
+		Mono *qm = &(q->monos[j]);
+
+		if (pm->exp == qm->exp) {
+			PolyAccumulate(&(pm->p), &(qm->p));
+			if (!PolyIsZero(&(pm->p))) {
+				monos[k++] = *pm;
+			}
+			i++;
+			j++;
+		} else if (pm->exp > qm->exp) {
+			monos[k++] = *qm;
+			j++;
+		} else {
+			monos[k++] = *pm;
+			i++;
+		}
+	}
+	while (i < p->monos_count) {
+		monos[k++] = p->monos[i++];
+	}
+	while (j < q->monos_count) {
+		monos[k++] = q->monos[j++];
+	}
+
+	free(p->monos);
+	free(q->monos);
+	*q = PolyZero();
+
+	if (k == 0) {
+		free(monos);
+		monos = NULL;
+	}
+	p->monos = monos;
+	p->monos_count = k;
+	PolyCollapse(p);
 }
 
 /**
@@ -70,82 +384,255 @@ void SimplifyPoly(Poly *p) {
 
 	unsigned k = 0;
 
-	for (unsigned i = 1; i < p->monos_count; i++) {
+	for (unsigned i = 0; i < p->monos_count; i++) {
 		Mono mi = p->monos[i];
-		Mono mp = p->monos[k];
 
-		/* usuwanie jednomianów skalarnych */
-		if (mi.exp == 0 && PolyIsCoeff(&(mi.p))) {
-			p->scalar += mi.p.scalar;
-			continue;
+		/* skalar jednomianu o wykładniku 0 należy do wyrazu wolnego */
+		if (mi.exp == 0) {
+			p->scalar = CoeffAdd(p->scalar, mi.p.scalar);
+			mi.p.scalar = 0;
+			if (PolyIsCoeff(&(mi.p))) {
+				continue;
+			}
 		}
 
-		if (mi.exp == 0 && mi.p.scalar != 0) {
-			p->scalar += mi.p.scalar;
-			mi.p.scalar = 0;
+		/* łączymy jednomiany o tym samym wykładniku w miejscu */
+		if (k > 0 && p->monos[k - 1].exp == mi.exp) {
+			PolyAccumulate(&(p->monos[k - 1].p), &(mi.p));
+		} else {
+			p->monos[k] = mi;
+			k++;
 		}
+	}
 
-		/* po usunięciu skalara na to miejsce wchodzi następny jednomian */
-		if (mp.exp == 0 && PolyIsCoeff(&(mp.p))) {
-			InsertNthMono(p->monos, k, mi);
-			/*
-			 * nie zwiększamy indeksu k, w ten sposób przesunięte zostaną
-			 * wszystkie następne jednomiany (nie powstanie luka)
-			 */
+	/* usuwamy jednomiany, które po zsumowaniu okazały się zerowe */
+	unsigned n = 0;
+	for (unsigned i = 0; i < k; i++) {
+		if (PolyIsZero(&(p->monos[i].p))) {
 			continue;
 		}
+		p->monos[n] = p->monos[i];
+		n++;
+	}
 
-		/* łączymy jednomiany o tym samym wykładniku */
-		if (mi.exp == mp.exp) {
-			Poly np = PolyAdd(&mi.p, &mp.p);
-			PolyDestroy(&(mi.p));
-			PolyDestroy(&(mp.p));
-			Mono nm = MonoFromPoly(&np, mi.exp);
-			InsertNthMono(p->monos, k, nm);
-			/* znowu nie zwiększamy k → jw. */
+	p->monos_count = n;
+	if (n == 0) {
+		free(p->monos);
+		p->monos = NULL;
+	}
+	PolyCollapse(p);
+}
 
-		/* jeżeli wszystko było w porządku to zostawiamy w spokoju */
-		} else {
-			k++;
-			InsertNthMono(p->monos, k, mi);
+/*
+ * Jądra dla liści drzewa – wielomianów, których wszystkie jednomiany mają
+ * współczynniki skalarne. Działają w jednej pętli po tablicy, bez wywołań
+ * rekurencyjnych. Są to zwykłe pętle skalarne: współczynniki i wykładniki
+ * leżą w tablicy struktur Mono, a LeafAdd jest scalaniem z zależnością
+ * między krokami.
+ */
+
+/**
+ * Sprawdza, czy wszystkie współczynniki wielomianu są skalarami.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest liściem?
+ */
+bool PolyIsLeaf(const Poly *p) {
+	for (unsigned i = 0; i < p->monos_count; i++) {
+		if (!PolyIsCoeff(&(p->monos[i].p))) {
+			return false;
 		}
 	}
-	p->monos_count = k + 1;
+	return true;
+}
 
-	k = 0;
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		if (PolyIsZero(&(p->monos[i].p))) {
-			continue;
+/**
+ * Mnoży jednomiany liścia przez skalar, pomijając wyzerowane.
+ * @param[out] r : tablica wynikowa (co najmniej @p count pól)
+ * @param[in] m : jednomiany ze skalarnymi współczynnikami
+ * @param[in] count : liczba jednomianów
+ * @param[in] scalar : skalar
+ * @return liczba jednomianów wyniku
+ */
+size_t LeafScalarMul(Mono *r, const Mono *m, size_t count,
+					 poly_coeff_t scalar) {
+	size_t k = 0;
+	for (size_t i = 0; i < count; i++) {
+		poly_coeff_t c = CoeffMul(m[i].p.scalar, scalar);
+		r[k].p = PolyFromCoeff(c);
+		r[k].exp = m[i].exp;
+		k += (c != 0);
+	}
+	return k;
+}
+
+/**
+ * Dodaje jednomiany dwóch liści, pomijając te, które się zniosły.
+ * @param[out] r : tablica wynikowa (co najmniej @p pn + @p qn pól)
+ * @param[in] pm : posortowane jednomiany pierwszego liścia
+ * @param[in] pn : liczba jednomianów pierwszego liścia
+ * @param[in] qm : posortowane jednomiany drugiego liścia
+ * @param[in] qn : liczba jednomianów drugiego liścia
+ * @return liczba jednomianów wyniku
+ */
+size_t LeafAdd(Mono *r, const Mono *pm, size_t pn, const Mono *qm, size_t qn) {
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
+	while (i < pn && j < qn) {
+		poly_exp_t pe = pm[i].exp;
+		poly_exp_t qe = qm[j].exp;
+		poly_coeff_t c;
+		if (pe == qe) {
+			c = CoeffAdd(pm[i++].p.scalar, qm[j++].p.scalar);
+		} else if (pe < qe) {
+			c = pm[i++].p.scalar;
+		} else {
+			c = qm[j++].p.scalar;
 		}
-		Mono m = p->monos[i];
-		p->monos[k] = m;
-		k++;
+		r[k].p = PolyFromCoeff(c);
+		r[k].exp = pe < qe ? pe : qe;
+		k += (c != 0);
+	}
+	for (; i < pn; i++, k++) {
+		r[k] = pm[i];
 	}
+	for (; j < qn; j++, k++) {
+		r[k] = qm[j];
+	}
+	return k;
+}
 
-	p->monos_count = k;
+/** Dane równoległego przejścia po jednomianach wielomianu */
+typedef struct TraversalJob {
+	Mono *monos; ///< jednomiany usuwane, kopiowane lub porównywane
+	size_t count; ///< liczba jednomianów
+	const Mono *other; ///< jednomiany drugiego porównywanego wielomianu
+	Mono *r; ///< tablica na kopie jednomianów
+	size_t tasks; ///< liczba przedziałów
+	bool *equal; ///< wyniki porównań przedziałów
+} TraversalJob;
+
+/**
+ * Szacuje liczbę jednomianów poddrzewa węzła: jednomiany węzła i ich
+ * współczynników, z których liczymy tylko TRAVERSAL_SAMPLE równo
+ * rozłożonych.
+ * @param[in] monos : jednomiany węzła
+ * @param[in] count : liczba jednomianów węzła
+ * @return szacowana liczba jednomianów poddrzewa
+ */
+static size_t SubtreeSizeEstimate(const Mono *monos, size_t count) {
+	size_t samples = count < TRAVERSAL_SAMPLE ? count : TRAVERSAL_SAMPLE;
+	size_t sampled = 0;
+	for (size_t n = 0; n < samples; n++) {
+		sampled += monos[count * n / samples].p.monos_count;
+	}
+	return count + sampled * count / samples;
 }
 
+/**
+ * Zwraca liczbę przedziałów, na które warto podzielić jednomiany węzła
+ * przy przechodzeniu drzewa, lub 1, gdy węzeł należy przejść w jednym
+ * wątku. Liczy się rozmiar całego poddrzewa, bo wąski węzeł może mieć
+ * bardzo duże współczynniki.
+ * @param[in] monos : jednomiany węzła
+ * @param[in] count : liczba jednomianów węzła
+ * @return liczba przedziałów
+ */
+size_t TraversalTasks(const Mono *monos, size_t count) {
+	if (count < 2 || !PolyThreadsAvailable()) {
+		return 1;
+	}
+	if (count < PARALLEL_TRAVERSAL_MIN_MONOS &&
+			SubtreeSizeEstimate(monos, count) < PARALLEL_TRAVERSAL_MIN_MONOS) {
+		return 1;
+	}
+	size_t tasks = 4 * PolyThreadsCount();
+	return tasks < count ? tasks : count;
+}
+
+/**
+ * Zadanie puli wątków: usuwa n-ty przedział jednomianów.
+ * @param[in] data : dane przejścia (TraversalJob)
+ * @param[in] n : numer przedziału
+ */
+void DestroyTask(void *data, size_t n) {
+	TraversalJob *job = data;
+	size_t end = job->count * (n + 1) / job->tasks;
+	for (size_t i = job->count * n / job->tasks; i < end; i++) {
+		MonoDestroy(&(job->monos[i]));
+	}
+}
+
+/**
+ * Zadanie puli wątków: kopiuje n-ty przedział jednomianów.
+ * @param[in] data : dane przejścia (TraversalJob)
+ * @param[in] n : numer przedziału
+ */
+void CloneTask(void *data, size_t n) {
+	TraversalJob *job = data;
+	size_t end = job->count * (n + 1) / job->tasks;
+	for (size_t i = job->count * n / job->tasks; i < end; i++) {
+		job->r[i] = MonoClone(&(job->monos[i]));
+	}
+}
 
 /**
  * Usuwa wielomian z pamięci.
+ * Drzewo przechodzone jest bez rekurencji: nagłówki poddrzew czekające
+ * na usunięcie leżą na stosie roboczym wątku. Jednomiany bardzo szerokich
+ * węzłów usuwane są równolegle.
  * @param[in] p : wielomian
  */
 void PolyDestroy(Poly *p) {
 	if (PolyIsCoeff(p)) {
 		return;
 	}
+	/* wielomian ze zrzutu w całości należy do zrzutu, a współdzielony
+	   wynik – do pamięci podręcznej */
+	if (PolySnapshotRelease(p) || PolyCacheRelease(p)) {
+		return;
+	}
 
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		MonoDestroy(&(p->monos[i]));
+	WorkStack *stack = &(ThreadWorkStacks()->destroy);
+	size_t base = stack->count;
+	*(Poly *) WorkStackPush(stack, sizeof(Poly)) = *p;
+	while (stack->count > base) {
+		Poly q = *(Poly *) WorkStackPop(stack, sizeof(Poly));
+		/* internowane tablice są współdzielone, zwalnia je tablica internowania */
+		if (PolyInternEnabled() && PolyInternRelease(&q)) {
+			continue;
+		}
+
+		size_t tasks = TraversalTasks(q.monos, q.monos_count);
+		if (tasks > 1) {
+			TraversalJob job = {q.monos, q.monos_count, NULL, NULL, tasks,
+								NULL};
+			PolyThreadsRun(DestroyTask, &job, tasks);
+		} else {
+			for (unsigned i = 0; i < q.monos_count; i++) {
+				if (!PolyIsCoeff(&(q.monos[i].p))) {
+					*(Poly *) WorkStackPush(stack, sizeof(Poly)) = q.monos[i].p;
+				}
+			}
+		}
+		free(q.monos);
 	}
 
-	free(p->monos);
 	p->monos = NULL;
 	p->monos_count = 0;
+	p->skip = 0;
 }
 
+/** Ramka iteracyjnego kopiowania wielomianu */
+typedef struct CloneFrame {
+	const Poly *p; ///< kopiowane poddrzewo
+	Poly *r; ///< miejsce na kopię
+} CloneFrame;
+
 /**
  * Robi pełną, głęboką kopię wielomianu.
+ * Drzewo przechodzone jest bez rekurencji, jak w PolyDestroy. Jednomiany
+ * bardzo szerokich węzłów kopiowane są równolegle.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
@@ -153,46 +640,52 @@ Poly PolyClone(const Poly *p){
 	if (PolyIsCoeff(p)) {
 		return *p;
 	}
-	Poly r;
-	r.scalar = p->scalar;
-	r.monos_count = p->monos_count;
-	r.monos = (Mono *) calloc(p->monos_count, sizeof(Mono));
-	assert(r.monos != NULL);
 
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		r.monos[i] = MonoClone(&(p->monos[i]));
+	Poly r;
+	WorkStack *stack = &(ThreadWorkStacks()->clone);
+	size_t base = stack->count;
+	*(CloneFrame *) WorkStackPush(stack, sizeof(CloneFrame)) =
+		(CloneFrame) {p, &r};
+	while (stack->count > base) {
+		CloneFrame f = *(CloneFrame *) WorkStackPop(stack, sizeof(CloneFrame));
+		*(f.r) = *(f.p);
+		f.r->monos = (Mono *) calloc(f.p->monos_count, sizeof(Mono));
+		assert(f.r->monos != NULL);
+
+		size_t tasks = TraversalTasks(f.p->monos, f.p->monos_count);
+		if (tasks > 1) {
+			TraversalJob job = {f.p->monos, f.p->monos_count, NULL,
+								f.r->monos, tasks, NULL};
+			PolyThreadsRun(CloneTask, &job, tasks);
+			continue;
+		}
+		for (unsigned i = 0; i < f.p->monos_count; i++) {
+			const Mono *m = &(f.p->monos[i]);
+			f.r->monos[i] = *m;
+			if (!PolyIsCoeff(&(m->p))) {
+				*(CloneFrame *) WorkStackPush(stack, sizeof(CloneFrame)) =
+					(CloneFrame) {&(m->p), &(f.r->monos[i].p)};
+			}
+		}
 	}
 
 	return r;
 }
 
 /**
- * Dodaje dwa wielomiany.
- * @param[in] p : wielomian
- * @param[in] q : wielomian
- * @return `p + q`
+ * Dodaje posortowane tablice jednomianów, kopiując jednomiany do wyniku.
+ * @param[out] r : tablica wynikowa (co najmniej @p pn + @p qn pól)
+ * @param[in] pm : jednomiany pierwszego składnika
+ * @param[in] pn : liczba jednomianów pierwszego składnika
+ * @param[in] qm : jednomiany drugiego składnika
+ * @param[in] qn : liczba jednomianów drugiego składnika
+ * @return liczba jednomianów wyniku
  */
-
-Poly PolyAdd(const Poly *p, const Poly *q) {
-
-	if (PolyIsZero(p)) {
-		return PolyClone(q);
-	}
-
-	if (PolyIsZero(q)) {
-		return PolyClone(p);
-	}
-
-	Poly r;
-	r.scalar = p->scalar + q->scalar;
-	r.monos_count = 0;
-	r.monos = (Mono *) calloc(p->monos_count + q->monos_count, sizeof(Mono));
-	assert(r.monos != NULL);
-
-	unsigned i = 0;
-	unsigned j = 0;
-	Mono *pm;
-	Mono *qm;
+size_t MergeAddMonos(Mono *r, const Mono *pm, size_t pn, const Mono *qm,
+					 size_t qn) {
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
 
 	/*
 	 * Główna pętla zbierająca jednomiany do nowego wielomianu.
@@ -203,68 +696,288 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
 	 * na której się znajdował zwiększamy o 1. W ten sposób tworzony wielomian
 	 * będzie automatycznie posortowany.
 	 */
-	while (true) {
+	while (i < pn && j < qn) {
 		/*
-		 * Jeżeli wysycyliśmy którąś listę, to pozostałe jednomiany z drugiej
-		 * po prostu kopiujemy na koniec i wychodzimy z pętli.
+		 * Jeżeli dwa jednomiany mają ten sam wykładnik, to nie mogą trafić
+		 * osobno do sumy, ale ich współczynniki muszą być dodane do siebie
 		 */
-		if (i == p->monos_count) {
-			for (; j < q->monos_count; j++) {
-				InsertNthMono(r.monos, r.monos_count,
-							  MonoClone(&(q->monos[j])));
-				r.monos_count++;
-			}
-			break;
+		if (pm[i].exp == qm[j].exp) {
+			Poly m_coeff = PolyAdd(&(pm[i].p), &(qm[j].p));
 
-		} else if (j == q->monos_count) {
-			for (; i < p->monos_count; i++) {
-				InsertNthMono(r.monos, r.monos_count,
-							  MonoClone(&(p->monos[i])));
-				r.monos_count++;
+			/*
+			 * Czasem może się zdarzyć, że suma współczynników = 0.
+			 * Wtedy powstaje jednomian zerowy który należy odrzucić
+			 */
+			if (!(PolyIsZero(&m_coeff))) {
+				InsertNthMono(r, k, MonoFromPoly(&m_coeff, pm[i].exp));
+				k++;
 			}
-			break;
+			i++;
+			j++;
+
+		/* Gdy wykładniki są różne, bierzemy jednomian z mniejszym. */
+		} else if (pm[i].exp > qm[j].exp) {
+			InsertNthMono(r, k, MonoClone(&(qm[j])));
+			k++;
+			j++;
+
+		} else /* pm[i].exp < qm[j].exp */ {
+			InsertNthMono(r, k, MonoClone(&(pm[i])));
+			k++;
+			i++;
+		}
+	}
+
+	/*
+	 * Jeżeli wysycyliśmy którąś listę, to pozostałe jednomiany z drugiej
+	 * po prostu kopiujemy na koniec.
+	 */
+	for (; i < pn; i++, k++) {
+		InsertNthMono(r, k, MonoClone(&(pm[i])));
+	}
+	for (; j < qn; j++, k++) {
+		InsertNthMono(r, k, MonoClone(&(qm[j])));
+	}
+	return k;
+}
 
+/**
+ * Wyszukuje binarnie pierwszy jednomian o wykładniku nie mniejszym
+ * niż @p exp.
+ * @param[in] m : posortowana tablica jednomianów
+ * @param[in] count : długość tablicy
+ * @param[in] exp : wykładnik
+ * @return indeks jednomianu (@p count, jeśli takiego nie ma)
+ */
+size_t LowerBoundExp(const Mono *m, size_t count, poly_exp_t exp) {
+	size_t begin = 0;
+	size_t end = count;
+	while (begin < end) {
+		size_t middle = begin + (end - begin) / 2;
+		if (m[middle].exp < exp) {
+			begin = middle + 1;
 		} else {
+			end = middle;
+		}
+	}
+	return begin;
+}
 
-			pm = &(p->monos[i]);
-			qm = &(q->monos[j]);
+/** Dane równoległego dodawania tablic jednomianów */
+typedef struct AddJob {
+	const Poly *p; ///< pierwszy składnik
+	const Poly *q; ///< drugi składnik
+	Mono *r; ///< tablica wynikowa
+	size_t tasks; ///< liczba przedziałów
+	size_t *p_split; ///< początki przedziałów w p (`tasks + 1` pól)
+	size_t *q_split; ///< początki przedziałów w q (`tasks + 1` pól)
+	size_t *count; ///< liczby jednomianów wyniku w przedziałach
+	bool leaf; ///< czy oba składniki są liśćmi
+} AddJob;
 
-			/*
-			 * Jeżeli dwa jednomiany mają ten sam wykładnik, to nie mogą trafić
-			 * osobno do sumy, ale ich współczynniki muszą być dodane do siebie
-			 */
-			if (pm->exp == qm->exp) {
-				Poly m_coeff = PolyAdd(&(pm->p), &(qm->p));
-
-				/*
-				 * Czasem może się zdarzyć, że suma współczynników = 0.
-				 * Wtedy powstaje jednomian zerowy który należy odrzucić
-				 */
-				if (!(PolyIsZero(&m_coeff))) {
-					InsertNthMono(r.monos, r.monos_count,
-							  MonoFromPoly(&m_coeff, pm->exp));
-					r.monos_count++;
-				}
+/**
+ * Zadanie puli wątków: dodaje n-te przedziały p i q, zapisując wynik
+ * w tablicy wynikowej od pozycji `p_split[n] + q_split[n]`.
+ * @param[in] data : dane dodawania (AddJob)
+ * @param[in] n : numer przedziału
+ */
+void AddTask(void *data, size_t n) {
+	AddJob *job = data;
+	const Mono *pm = job->p->monos + job->p_split[n];
+	const Mono *qm = job->q->monos + job->q_split[n];
+	size_t pn = job->p_split[n + 1] - job->p_split[n];
+	size_t qn = job->q_split[n + 1] - job->q_split[n];
+	Mono *r = job->r + job->p_split[n] + job->q_split[n];
+	if (job->leaf) {
+		job->count[n] = LeafAdd(r, pm, pn, qm, qn);
+	} else {
+		job->count[n] = MergeAddMonos(r, pm, pn, qm, qn);
+	}
+}
 
-				i++;
-				j++;
+/**
+ * Dodaje jednomiany p i q w wielu wątkach.
+ * Dłuższy składnik dzielony jest na równe przedziały, a granice
+ * przedziałów drugiego znajdowane są wyszukiwaniem binarnym, tak żeby
+ * jednomiany o równych wykładnikach trafiły do tego samego przedziału.
+ * Każdy przedział zapisuje wynik we własnym fragmencie tablicy,
+ * fragmenty są na koniec sklejane.
+ * @param[out] r : tablica wynikowa (co najmniej `p->monos_count +
+ * q->monos_count` pól)
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return liczba jednomianów wyniku
+ */
+size_t ParallelAddMonos(Mono *r, const Poly *p, const Poly *q) {
+	const Poly *l = p->monos_count >= q->monos_count ? p : q;
+	const Poly *s = l == p ? q : p;
+
+	AddJob job;
+	job.p = l;
+	job.q = s;
+	job.r = r;
+	job.tasks = 4 * PolyThreadsCount();
+	job.p_split = calloc(job.tasks + 1, sizeof(size_t));
+	job.q_split = calloc(job.tasks + 1, sizeof(size_t));
+	job.count = calloc(job.tasks, sizeof(size_t));
+	assert(job.p_split != NULL && job.q_split != NULL && job.count != NULL);
+	job.leaf = PolyIsLeaf(p) && PolyIsLeaf(q);
+
+	for (size_t n = 1; n < job.tasks; n++) {
+		job.p_split[n] = l->monos_count * n / job.tasks;
+		job.q_split[n] = LowerBoundExp(s->monos, s->monos_count,
+									   l->monos[job.p_split[n]].exp);
+	}
+	job.p_split[job.tasks] = l->monos_count;
+	job.q_split[job.tasks] = s->monos_count;
 
-			/* Gdy wykładniki są różne, bierzemy jednomian z mniejszym. */
-			} else if (pm->exp > qm->exp) {
-				InsertNthMono(r.monos, r.monos_count, MonoClone(qm));
-				r.monos_count++;
-				j++;
+	PolyThreadsRun(AddTask, &job, job.tasks);
 
-			} else /* pm->exp < pq->exp */ {
-				InsertNthMono(r.monos, r.monos_count, MonoClone(pm));
-				r.monos_count++;
-				i++;
-			}
+	size_t k = job.count[0];
+	for (size_t n = 1; n < job.tasks; n++) {
+		memmove(r + k, r + job.p_split[n] + job.q_split[n],
+				job.count[n] * sizeof(Mono));
+		k += job.count[n];
+	}
+
+	free(job.p_split);
+	free(job.q_split);
+	free(job.count);
+	return k;
+}
+
+/** Ramka iteracyjnego dodawania wielomianów */
+typedef struct AddFrame {
+	Poly p; ///< pierwszy składnik (nagłówek; jednomiany są współdzielone)
+	Poly q; ///< drugi składnik
+	Poly *r; ///< miejsce na sumę
+	bool finish; ///< czy to ramka kończąca sumę @p r po sumach współczynników
+} AddFrame;
+
+/**
+ * Kończy sumę, której jednomiany są już policzone: usuwa jednomiany, których
+ * współczynniki się zniosły, i sprowadza wynik do postaci standardowej.
+ * @param[in,out] r : suma
+ */
+void PolyAddFinish(Poly *r) {
+	unsigned k = 0;
+	for (unsigned i = 0; i < r->monos_count; i++) {
+		if (!PolyIsZero(&(r->monos[i].p))) {
+			r->monos[k++] = r->monos[i];
 		}
 	}
+	r->monos_count = k;
+
+	if (PolyIsCoeff(r)) {
+		free(r->monos);
+		r->monos = NULL;
+	}
+	PolyCollapse(r);
+}
+
+/**
+ * Scala posortowane tablice jednomianów jak MergeAddMonos, ale sum
+ * współczynników o równych wykładnikach nie liczy od razu, tylko odkłada
+ * je na stos roboczy. Jednomiany, których sumy się zniosą, usuwa potem
+ * PolyAddFinish.
+ * @param[in,out] stack : stos roboczy dodawania
+ * @param[out] r : tablica wynikowa (co najmniej @p pn + @p qn pól)
+ * @param[in] pm : jednomiany pierwszego składnika
+ * @param[in] pn : liczba jednomianów pierwszego składnika
+ * @param[in] qm : jednomiany drugiego składnika
+ * @param[in] qn : liczba jednomianów drugiego składnika
+ * @return liczba jednomianów wyniku
+ */
+size_t MergeAddMonosDeferred(WorkStack *stack, Mono *r, const Mono *pm,
+							 size_t pn, const Mono *qm, size_t qn) {
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
+	while (i < pn && j < qn) {
+		if (pm[i].exp == qm[j].exp) {
+			r[k].exp = pm[i].exp;
+			r[k].p = PolyZero();
+			*(AddFrame *) WorkStackPush(stack, sizeof(AddFrame)) =
+				(AddFrame) {pm[i].p, qm[j].p, &(r[k].p), false};
+			i++;
+			j++;
+		} else if (pm[i].exp > qm[j].exp) {
+			r[k] = MonoClone(&(qm[j++]));
+		} else {
+			r[k] = MonoClone(&(pm[i++]));
+		}
+		k++;
+	}
+	for (; i < pn; i++, k++) {
+		r[k] = MonoClone(&(pm[i]));
+	}
+	for (; j < qn; j++, k++) {
+		r[k] = MonoClone(&(qm[j]));
+	}
+	return k;
+}
+
+/**
+ * Dodaje dwa wielomiany.
+ * Sumy współczynników o równych wykładnikach liczone są bez rekurencji:
+ * pary dodawanych poddrzew czekają na stosie roboczym wątku, a pod nimi
+ * ramka kończąca sumę węzła, zdejmowana po sumach wszystkich współczynników.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p + q`
+ */
+Poly PolyAdd(const Poly *p, const Poly *q) {
+	Poly r;
+	WorkStack *stack = &(ThreadWorkStacks()->add);
+	size_t base = stack->count;
+	*(AddFrame *) WorkStackPush(stack, sizeof(AddFrame)) =
+		(AddFrame) {*p, *q, &r, false};
+
+	while (stack->count > base) {
+		AddFrame f = *(AddFrame *) WorkStackPop(stack, sizeof(AddFrame));
+		if (f.finish) {
+			PolyAddFinish(f.r);
+			continue;
+		}
 
-	if (PolyIsCoeff(&r)) {
-		free(r.monos);
+		if (PolyIsZero(&(f.p))) {
+			*(f.r) = PolyClone(&(f.q));
+			continue;
+		}
+		if (PolyIsZero(&(f.q))) {
+			*(f.r) = PolyClone(&(f.p));
+			continue;
+		}
+
+		/* wielomian o większym skip dodajemy jako jednomian o wykładniku 0 */
+		unsigned skip = AlignedSkip(&(f.p), &(f.q));
+		Mono p_tmp;
+		Mono q_tmp;
+		Poly pv = PolyView(&(f.p), skip, &p_tmp);
+		Poly qv = PolyView(&(f.q), skip, &q_tmp);
+
+		Poly *s = f.r;
+		s->scalar = CoeffAdd(pv.scalar, qv.scalar);
+		s->skip = skip;
+		s->monos = (Mono *) calloc(pv.monos_count + qv.monos_count,
+								   sizeof(Mono));
+		assert(s->monos != NULL);
+
+		if (pv.monos_count + qv.monos_count >= PARALLEL_ADD_MIN_MONOS &&
+				PolyThreadsAvailable()) {
+			s->monos_count = ParallelAddMonos(s->monos, &pv, &qv);
+		} else if (PolyIsLeaf(&pv) && PolyIsLeaf(&qv)) {
+			s->monos_count = LeafAdd(s->monos, pv.monos, pv.monos_count,
+									 qv.monos, qv.monos_count);
+		} else {
+			*(AddFrame *) WorkStackPush(stack, sizeof(AddFrame)) =
+				(AddFrame) {PolyZero(), PolyZero(), s, true};
+			s->monos_count = MergeAddMonosDeferred(stack, s->monos, pv.monos,
+												   pv.monos_count, qv.monos,
+												   qv.monos_count);
+			continue;
+		}
+		PolyAddFinish(s);
 	}
 
 	return r;
@@ -273,119 +986,325 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
+ * Jednomiany są kopiowane raz, do tablicy wyniku, i tam sortowane oraz
+ * łączone w miejscu; tablica jest na koniec przycinana, jeśli część
+ * jednomianów się połączyła lub zniosła.
  * @param[in] count : liczba jednomianów
  * @param[in] monos : tablica jednomianów
  * @return wielomian będący sumą jednomianów
  */
 Poly PolyAddMonos(unsigned count, const Mono *monos){
-	Poly r;
-	r.scalar = 0;
-	r.monos_count = 0;
-	r.monos = calloc(count, sizeof(Mono));
+	Poly r = PolyZero();
+	if (count == 0) {
+		return r;
+	}
+
+	r.monos = malloc(count * sizeof(Mono));
 	assert(r.monos != NULL);
+	memcpy(r.monos, monos, count * sizeof(Mono));
+	r.monos_count = count;
 
-	unsigned k = 0;
-	Mono *mptr; // wskaźnik na aktualnie dodawany jednomian
+	/*
+	 * Lista wejściowa mogła być nieposortowana, mieć powtarzające się
+	 * wykładniki i skalary przy x^0 – SimplifyPoly sprowadza ją do postaci
+	 * standardowej, przenosząc współczynniki zamiast je kopiować
+	 */
+	SimplifyPoly(&r);
 
-	Mono nmonos[count]; // tablica robocza
-	for (unsigned i = 0; i < count; i++) {
-		nmonos[i] = monos[i];
+	if (!PolyIsCoeff(&r) && r.monos_count < count) {
+		Mono *monos_fit = realloc(r.monos, r.monos_count * sizeof(Mono));
+		if (monos_fit != NULL) {
+			r.monos = monos_fit;
+		}
 	}
-	SortMonosByExp(nmonos, count);
+	return r;
+}
+
+
+/** Ramka iteracyjnego mnożenia wielomianu przez skalar */
+typedef struct ScalarMulFrame {
+	const Poly *p; ///< mnożone poddrzewo
+	Poly *r; ///< miejsce na iloczyn
+	bool finish; ///< czy to ramka kończąca iloczyn @p r
+} ScalarMulFrame;
 
+/**
+ * Mnoży wielomian ze skalarem.
+ * Współczynniki mnożone są bez rekurencji: poddrzewa czekają na stosie
+ * roboczym wątku, a pod nimi ramka kończąca iloczyn węzła.
+ * @param[in] p : wielomian
+ * @param[in] scalar : skalar
+ * @return `p * scalar`
+ */
+Poly PolyScalarMul(const Poly *p, poly_coeff_t scalar) {
+	if (scalar == 0 && !PolyIsCoeff(p)) {
+		return PolyZero();
+	}
 
-	for (unsigned i = 0; i < count; i++) {
-		mptr = &(nmonos[i]);
+	Poly r;
+	WorkStack *stack = &(ThreadWorkStacks()->scalar_mul);
+	size_t base = stack->count;
+	*(ScalarMulFrame *) WorkStackPush(stack, sizeof(ScalarMulFrame)) =
+		(ScalarMulFrame) {p, &r, false};
+
+	while (stack->count > base) {
+		ScalarMulFrame f = *(ScalarMulFrame *) WorkStackPop(
+			stack, sizeof(ScalarMulFrame));
+		/* iloczyn może się wyzerować (przepełnienie), wtedy usuwamy jednomian */
+		if (f.finish) {
+			PolyAddFinish(f.r);
+			continue;
+		}
 
-		/* Jednomiany–skalary nie mają prawa istnieć samodzielnie */
-		if (mptr->exp == 0 && mptr->p.scalar != 0) {
-			r.scalar += mptr->p.scalar;
-			mptr->p.scalar = 0;
+		if (PolyIsCoeff(f.p)) {
+			*(f.r) = PolyFromCoeff(CoeffMul(f.p->scalar, scalar));
+			continue;
 		}
 
-		if (PolyIsZero(&(mptr->p))) {
+		Poly *s = f.r;
+		s->scalar = CoeffMul(f.p->scalar, scalar);
+		s->monos_count = 0;
+		s->skip = f.p->skip;
+		s->monos = (Mono *) calloc(f.p->monos_count, sizeof(Mono));
+		assert(s->monos != NULL);
+
+		if (PolyIsLeaf(f.p)) {
+			s->monos_count = LeafScalarMul(s->monos, f.p->monos,
+										   f.p->monos_count, scalar);
+			if (PolyIsCoeff(s)) {
+				free(s->monos);
+				s->monos = NULL;
+			}
+			PolyCollapse(s);
 			continue;
 		}
 
-		if (PolyIsCoeff(&(mptr->p)) && mptr->exp == 0) {
-			r.scalar += mptr->p.scalar;
+		*(ScalarMulFrame *) WorkStackPush(stack, sizeof(ScalarMulFrame)) =
+			(ScalarMulFrame) {NULL, s, true};
+		s->monos_count = f.p->monos_count;
+		for (unsigned i = 0; i < f.p->monos_count; i++) {
+			s->monos[i].exp = f.p->monos[i].exp;
+			*(ScalarMulFrame *) WorkStackPush(stack, sizeof(ScalarMulFrame)) =
+				(ScalarMulFrame) {&(f.p->monos[i].p), &(s->monos[i].p), false};
+		}
+	}
 
-		} else if (k > 0 && mptr->exp == r.monos[k - 1].exp) {
-			Poly m_coeff = PolyAdd(&(mptr->p), &(r.monos[k - 1].p));
-			PolyDestroy(&(r.monos[k - 1].p));
-			PolyDestroy(&(mptr->p));
-			r.monos[k - 1].p = m_coeff;
+	return r;
+}
 
-		} else {
-			r.monos[k] = *mptr;
+Poly PolyMul(const Poly *p, const Poly *q);
+
+/**
+ * Mnoży jednomiany
+ * @param[in] m : jednomian
+ * @param[in] o : jednomian
+ * @return `m * o`
+ */
+Mono MonoMul(const Mono *m, const Mono *o) {
+	Mono r;
+	r.exp = m->exp + o->exp;
+	r.p = PolyMul(&(m->p), &(o->p));
+	return r;
+}
+
+/**
+ * Sprawdza, czy wielomian jest pojedynczym jednomianem `p * x^e`
+ * (bez wyrazu wolnego).
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest jednomianem?
+ */
+bool PolyIsMono(const Poly *p) {
+	return p->scalar == 0 && p->monos_count == 1;
+}
+
+/**
+ * Zwraca liczbę składników wielomianu (jednomianów i niezerowego wyrazu
+ * wolnego).
+ * @param[in] p : wielomian
+ * @return liczba składników
+ */
+size_t PolyTermsCount(const Poly *p) {
+	return p->monos_count + (p->scalar != 0);
+}
+
+/**
+ * Mnoży wielomian przez jednomian.
+ * Wystarczy przesunąć wykładniki i pomnożyć współczynniki, wynik jest już
+ * posortowany – jeden przebieg po @p p.
+ * @param[in] p : wielomian
+ * @param[in] m : jednomian
+ * @return `p * m`
+ */
+Poly PolyMulByMono(const Poly *p, const Mono *m) {
+	Poly r;
+	r.scalar = 0;
+	r.monos_count = 0;
+	r.skip = p->skip;
+	r.monos = (Mono *) calloc(p->monos_count + 1, sizeof(Mono));
+	assert(r.monos != NULL);
+
+	if (p->scalar != 0) {
+		Poly c = PolyScalarMul(&(m->p), p->scalar);
+		if (!PolyIsZero(&c)) {
+			InsertNthMono(r.monos, r.monos_count, MonoFromPoly(&c, m->exp));
 			r.monos_count++;
-			k++;
 		}
 	}
 
-	if (PolyIsCoeff(&r)) {
-		free(r.monos);
-		return r;
+	for (unsigned i = 0; i < p->monos_count; i++) {
+		Poly c = PolyMul(&(p->monos[i].p), &(m->p));
+		if (!PolyIsZero(&c)) {
+			InsertNthMono(r.monos, r.monos_count,
+						  MonoFromPoly(&c, p->monos[i].exp + m->exp));
+			r.monos_count++;
+		}
 	}
 
-	/* Lista wejściowa mogła być nieposortowana. Trzeba więc wynik posortować */
+	/* łączy ewentualny jednomian z wyrazu wolnego i przenosi skalar z x^0 */
 	SimplifyPoly(&r);
 	return r;
 }
 
-
-Mono MonoScalarMul(const Mono *m, poly_coeff_t scalar);
-
 /**
- * Mnoży wielomian ze skalarem.
- * @param[in] p : wielomian
- * @param[in] scalar : skalar
- * @return `p * scalar`
+ * Mnoży wielomian przez wielomian o niewielu składnikach (np. dwumian),
+ * sumując iloczyny przez kolejne składniki.
+ * @param[in] p : wielomian o niewielu składnikach
+ * @param[in] q : wielomian
+ * @return `p * q`
  */
-Poly PolyScalarMul(const Poly *p, poly_coeff_t scalar) {
-	if (PolyIsCoeff(p)) {
-		return PolyFromCoeff(p->scalar * scalar);
+Poly PolyMulByFewTerms(const Poly *p, const Poly *q) {
+	Poly r = PolyScalarMul(q, p->scalar);
+	for (unsigned i = 0; i < p->monos_count; i++) {
+		Poly t = PolyMulByMono(q, &(p->monos[i]));
+		PolyAccumulate(&r, &t);
 	}
+	return r;
+}
 
+/**
+ * Mnoży jednomiany p o indeksach z przedziału [begin, end) przez wszystkie
+ * jednomiany q (bez wyrazów wolnych).
+ * @param[in] p : wielomian
+ * @param[in] begin : indeks pierwszego jednomianu p
+ * @param[in] end : indeks za ostatnim jednomianem p
+ * @param[in] q : wielomian
+ * @return suma iloczynów jednomianów
+ */
+Poly PolyMulMonoRows(const Poly *p, size_t begin, size_t end, const Poly *q) {
 	Poly r;
-	r.scalar = p->scalar * scalar;
-	r.monos_count = p->monos_count;
+	r.scalar = 0;
+	r.skip = p->skip;
+	r.monos_count = (end - begin) * q->monos_count;
 	r.monos = (Mono *) calloc(r.monos_count, sizeof(Mono));
 	assert(r.monos != NULL);
 
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		InsertNthMono(r.monos, i,
-					  MonoScalarMul(&(p->monos[i]), scalar));
+	unsigned counter = 0;
+	for (size_t i = begin; i < end; i++) {
+		for (unsigned j = 0; j < q->monos_count; j++) {
+			Mono *mp = &(p->monos[i]);
+			Mono *mq = &(q->monos[j]);
+			Mono nm = MonoMul(mp, mq);
+			if (!PolyIsZero(&(nm.p))) {
+				InsertNthMono(r.monos, counter, nm);
+				counter++;
+			}
+		}
+	}
+	r.monos_count = counter;
+	/*
+	 * w mnożeniu nie zachowane były zasady tworzenia poprawnych wielomianów;
+	 * r składa się jednak z posortowanych serii, po jednej na jednomian p
+	 */
+	SimplifyPoly(&r);
+	return r;
+}
+
+/** Dane równoległego mnożenia jednomianów */
+typedef struct MulRowsJob {
+	const Poly *p; ///< pierwszy czynnik, dzielony na przedziały jednomianów
+	const Poly *q; ///< drugi czynnik
+	size_t tasks; ///< liczba przedziałów
+	Poly *partial; ///< iloczyny kolejnych przedziałów przez q
+} MulRowsJob;
+
+/**
+ * Zadanie puli wątków: mnoży n-ty przedział jednomianów p przez q.
+ * @param[in] data : dane mnożenia (MulRowsJob)
+ * @param[in] n : numer przedziału
+ */
+void MulRowsTask(void *data, size_t n) {
+	MulRowsJob *job = data;
+	size_t rows = job->p->monos_count;
+	size_t begin = rows * n / job->tasks;
+	size_t end = rows * (n + 1) / job->tasks;
+	job->partial[n] = PolyMulMonoRows(job->p, begin, end, job->q);
+}
+
+/** Dane jednego poziomu sumowania wielomianów parami */
+typedef struct AccumulateJob {
+	Poly *polys; ///< sumowane wielomiany
+	size_t count; ///< liczba wielomianów
+	size_t step; ///< odległość między sumowanymi wielomianami
+} AccumulateJob;
+
+/**
+ * Zadanie puli wątków: dodaje wielomian o indeksie `(2n + 1) step`
+ * do wielomianu o indeksie `2n step`.
+ * @param[in] data : dane sumowania (AccumulateJob)
+ * @param[in] n : numer pary
+ */
+void AccumulateTask(void *data, size_t n) {
+	AccumulateJob *job = data;
+	size_t i = 2 * job->step * n;
+	if (i + job->step < job->count) {
+		PolyAccumulate(&(job->polys[i]), &(job->polys[i + job->step]));
 	}
-
-	return r;
 }
 
 /**
- * Mnoży jednomian przez skalar.
- * @param[in] m : jednomian
- * @param[in] scalar : skalar.
- * @return `m * scalar`
+ * Sumuje wielomiany drzewem sumowań parami; pary z jednego poziomu
+ * sumowane są równolegle. Wynik trafia do `polys[0]`, pozostałe
+ * wielomiany są zużyte.
+ * @param[in,out] polys : wielomiany
+ * @param[in] count : liczba wielomianów (co najmniej 1)
  */
-Mono MonoScalarMul(const Mono *m, poly_coeff_t scalar) {
-	Mono r;
-	r.exp = m->exp;
-	r.p = PolyScalarMul(&(m->p), scalar);
-	return r;
+void PolyAccumulateTree(Poly polys[], size_t count) {
+	AccumulateJob job = {polys, count, 1};
+	for (; job.step < count; job.step *= 2) {
+		PolyThreadsRun(AccumulateTask, &job,
+					   (count + 2 * job.step - 1) / (2 * job.step));
+	}
 }
 
-Poly PolyMul(const Poly *p, const Poly *q);
-
 /**
- * Mnoży jednomiany
- * @param[in] m : jednomian
- * @param[in] o : jednomian
- * @return `m * o`
+ * Mnoży jednomiany p przez jednomiany q (bez wyrazów wolnych).
+ * Duże iloczyny dzielone są między wątki według jednomianów p: każdy wątek
+ * scala swoje serie lokalnie, a częściowe wyniki sumowane są parami.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return suma iloczynów jednomianów
  */
-Mono MonoMul(const Mono *m, const Mono *o) {
-	Mono r;
-	r.exp = m->exp + o->exp;
-	r.p = PolyMul(&(m->p), &(o->p));
+Poly PolyMulMonos(const Poly *p, const Poly *q) {
+	size_t tasks = 1;
+	if (p->monos_count * q->monos_count >= PARALLEL_MUL_MIN_PRODUCTS &&
+			PolyThreadsAvailable()) {
+		/* kilka przedziałów na wątek wyrównuje nierówne koszty wierszy */
+		tasks = 4 * PolyThreadsCount();
+		if (tasks > p->monos_count) {
+			tasks = p->monos_count;
+		}
+	}
+	if (tasks <= 1) {
+		return PolyMulMonoRows(p, 0, p->monos_count, q);
+	}
+
+	MulRowsJob job = {p, q, tasks, calloc(tasks, sizeof(Poly))};
+	assert(job.partial != NULL);
+	PolyThreadsRun(MulRowsTask, &job, tasks);
+	PolyAccumulateTree(job.partial, tasks);
+
+	Poly r = job.partial[0];
+	free(job.partial);
 	return r;
 }
 
@@ -407,35 +1326,39 @@ Poly PolyMul(const Poly *p, const Poly *q) {
 		return PolyScalarMul(p, q->scalar);
 	}
 
+	/* czynnik o większym skip mnożymy jako jednomian o wykładniku 0 */
+	unsigned skip = AlignedSkip(p, q);
+	Mono p_tmp;
+	Mono q_tmp;
+	Poly p_view = PolyView(p, skip, &p_tmp);
+	Poly q_view = PolyView(q, skip, &q_tmp);
+	p = &p_view;
+	q = &q_view;
+
+	/* mnożenie przez jednomian i dwumian */
+	if (PolyIsMono(p)) {
+		return PolyMulByMono(q, &(p->monos[0]));
+	}
+	if (PolyIsMono(q)) {
+		return PolyMulByMono(p, &(q->monos[0]));
+	}
+	if (PolyTermsCount(p) <= 2) {
+		return PolyMulByFewTerms(p, q);
+	}
+	if (PolyTermsCount(q) <= 2) {
+		return PolyMulByFewTerms(q, p);
+	}
+
 	/* mnożenie przez wyrazy wolne */
 	Poly r1 = PolyScalarMul(p, q->scalar);
 	Poly r2 = PolyScalarMul(q, p->scalar);
 	Poly r12 = PolyAdd(&r1, &r2);
 	PolyDestroy(&r1);
 	PolyDestroy(&r2);
-	r12.scalar = p->scalar * q->scalar;
+	r12.scalar = CoeffMul(p->scalar, q->scalar);
 
 	/* mnożenie jednomianów */
-	Poly r3;
-	r3.scalar = 0;
-	r3.monos_count = p->monos_count * q->monos_count;
-	r3.monos = (Mono *) calloc(r3.monos_count, sizeof(Mono));
-	assert(r3.monos != NULL);
-
-	unsigned counter = 0;
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		for (unsigned j = 0; j < q->monos_count; j++) {
-			Mono *mp = &(p->monos[i]);
-			Mono *mq = &(q->monos[j]);
-			Mono nm = MonoMul(mp, mq);
-			if (!PolyIsZero(&(nm.p))) {
-				InsertNthMono(r3.monos, counter, nm);
-				counter++;
-			}
-		}
-	}
-	/* w mnożeniu nie zachowane były zasady tworzenia poprawnych wielomianów */
-	SimplifyPoly(&r3);
+	Poly r3 = PolyMulMonos(p, q);
 
 	Poly r = PolyAdd(&r12, &r3);
 	PolyDestroy(&r12);
@@ -446,38 +1369,164 @@ Poly PolyMul(const Poly *p, const Poly *q) {
 	return r;
 }
 
+/** Składnik czynnika iloczynu strumieniowego: `p * x^exp` */
+typedef struct MulTerm {
+	poly_exp_t exp; ///< wykładnik
+	const Poly *p; ///< współczynnik
+} MulTerm;
+
 /**
- * Zwraca przeciwny jednomian.
- * @param[in] p : jednomian
- * @return `-p`
+ * Rozkłada wielomian na składniki (wyraz wolny jest składnikiem
+ * o wykładniku 0) posortowane według wykładników.
+ * @param[in] p : wielomian
+ * @param[in] scalar : miejsce na wyraz wolny jako wielomian
+ * @param[in] terms : tablica wynikowa (co najmniej `monos_count + 1` pól)
+ * @return liczba składników
  */
-Mono MonoNeg(const Mono *m) {
-	Mono r;
-	r.exp = m->exp;
-	r.p = PolyNeg(&(m->p));
-	return r;
+size_t PolyToMulTerms(const Poly *p, Poly *scalar, MulTerm terms[]) {
+	size_t k = 0;
+	if (p->scalar != 0) {
+		*scalar = PolyFromCoeff(p->scalar);
+		terms[k].exp = 0;
+		terms[k].p = scalar;
+		k++;
+	}
+	for (size_t i = 0; i < p->monos_count; i++) {
+		terms[k].exp = p->monos[i].exp;
+		terms[k].p = &(p->monos[i].p);
+		k++;
+	}
+	return k;
 }
 
 /**
- * Zwraca przeciwny wielomian.
- * @param[in] p : wielomian
- * @return `-p`
+ * Przywraca własność kopca w poddrzewie o korzeniu @p n.
+ * Kopiec przechowuje numery wierszy, kluczem wiersza i jest wykładnik
+ * iloczynu `pt[i] * qt[cursor[i]]`.
+ * @param[in] heap : kopiec
+ * @param[in] size : rozmiar kopca
+ * @param[in] n : indeks korzenia
+ * @param[in] pt : składniki pierwszego czynnika
+ * @param[in] qt : składniki drugiego czynnika
+ * @param[in] cursor : pozycje wierszy w drugim czynniku
  */
-Poly PolyNeg(const Poly *p) {
-	if (PolyIsCoeff(p)) {
-		return PolyFromCoeff(-(p->scalar));
+void MulHeapSiftDown(size_t heap[], size_t size, size_t n, const MulTerm pt[],
+					 const MulTerm qt[], const size_t cursor[]) {
+	while (true) {
+		size_t min = n;
+		size_t l = 2 * n + 1;
+		size_t r = 2 * n + 2;
+		poly_exp_t min_exp = pt[heap[min]].exp + qt[cursor[heap[min]]].exp;
+		if (l < size && pt[heap[l]].exp + qt[cursor[heap[l]]].exp < min_exp) {
+			min = l;
+			min_exp = pt[heap[l]].exp + qt[cursor[heap[l]]].exp;
+		}
+		if (r < size && pt[heap[r]].exp + qt[cursor[heap[r]]].exp < min_exp) {
+			min = r;
+		}
+		if (min == n) {
+			return;
+		}
+		size_t tmp = heap[n];
+		heap[n] = heap[min];
+		heap[min] = tmp;
+		n = min;
 	}
+}
 
-	Poly r;
-	r.scalar = -(p->scalar);
-	r.monos_count = p->monos_count;
-	r.monos = (Mono *) calloc(r.monos_count, sizeof(Mono));
-	assert(r.monos != NULL);
+void PolyMulForEach(const Poly *p, const Poly *q,
+					void (*emit)(Mono *m, void *data), void *data) {
+	if (PolyIsZero(p) || PolyIsZero(q)) {
+		return;
+	}
 
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		InsertNthMono(r.monos, i, MonoNeg(&(p->monos[i])));
+	/* iloczyn nie zależy od x0: jest współczynnikiem jednomianu x0^0 */
+	unsigned skip = AlignedSkip(p, q);
+	if (skip > 0) {
+		Poly r = PolyMul(p, q);
+		if (!PolyIsCoeff(&r)) {
+			r.skip--;
+		}
+		Mono m = MonoFromPoly(&r, 0);
+		emit(&m, data);
+		return;
 	}
-	return r;
+	Mono p_tmp;
+	Mono q_tmp;
+	Poly p_view = PolyView(p, skip, &p_tmp);
+	Poly q_view = PolyView(q, skip, &q_tmp);
+	p = &p_view;
+	q = &q_view;
+
+	Poly p_scalar;
+	Poly q_scalar;
+	MulTerm *pt = malloc((p->monos_count + 1) * sizeof(MulTerm));
+	MulTerm *qt = malloc((q->monos_count + 1) * sizeof(MulTerm));
+	assert(pt != NULL && qt != NULL);
+	size_t pn = PolyToMulTerms(p, &p_scalar, pt);
+	size_t qn = PolyToMulTerms(q, &q_scalar, qt);
+
+	/*
+	 * Każdy składnik p wyznacza posortowany wiersz iloczynów z kolejnymi
+	 * składnikami q. Kopiec wierszy wybiera zawsze najmniejszy wykładnik,
+	 * więc w pamięci trzymamy tylko jeden jednomian wyniku naraz.
+	 */
+	size_t *cursor = calloc(pn, sizeof(size_t));
+	size_t *heap = malloc(pn * sizeof(size_t));
+	assert(cursor != NULL && heap != NULL);
+	for (size_t i = 0; i < pn; i++) {
+		heap[i] = i;
+	}
+	size_t size = pn;
+	for (size_t n = size / 2; n-- > 0;) {
+		MulHeapSiftDown(heap, size, n, pt, qt, cursor);
+	}
+
+	Poly acc = PolyZero();
+	poly_exp_t acc_exp = 0;
+	while (size > 0) {
+		size_t i = heap[0];
+		poly_exp_t exp = pt[i].exp + qt[cursor[i]].exp;
+
+		if (exp != acc_exp && !PolyIsZero(&acc)) {
+			Mono m = MonoFromPoly(&acc, acc_exp);
+			emit(&m, data);
+			acc = PolyZero();
+		}
+		acc_exp = exp;
+
+		Poly t = PolyMul(pt[i].p, qt[cursor[i]].p);
+		PolyAccumulate(&acc, &t);
+
+		cursor[i]++;
+		if (cursor[i] == qn) {
+			size--;
+			heap[0] = heap[size];
+		}
+		if (size > 0) {
+			MulHeapSiftDown(heap, size, 0, pt, qt, cursor);
+		}
+	}
+	if (!PolyIsZero(&acc)) {
+		Mono m = MonoFromPoly(&acc, acc_exp);
+		emit(&m, data);
+	}
+
+	free(heap);
+	free(cursor);
+	free(pt);
+	free(qt);
+}
+
+/**
+ * Zwraca przeciwny wielomian.
+ * Mnożenie przez -1 nie zeruje żadnego współczynnika, więc wynik ma ten sam
+ * kształt co @p p.
+ * @param[in] p : wielomian
+ * @return `-p`
+ */
+Poly PolyNeg(const Poly *p) {
+	return PolyScalarMul(p, CoeffFromInt(-1));
 }
 
 /**
@@ -493,6 +1542,12 @@ Poly PolySub(const Poly *p, const Poly *q) {
 	return r;
 }
 
+/** Ramka iteracyjnego liczenia stopnia ze względu na zmienną */
+typedef struct DegByFrame {
+	const Poly *p; ///< przeszukiwane poddrzewo
+	unsigned var_idx; ///< indeks zmiennej z perspektywy poddrzewa
+} DegByFrame;
+
 /**
  * Zwraca stopień wielomianu ze względu na zadaną zmienną (-1 dla wielomianu
  * tożsamościowo równego zeru).
@@ -509,35 +1564,51 @@ poly_exp_t PolyDegBy(const Poly *p, unsigned var_idx){
 	if (PolyIsZero(p)) {
 		return -1;
 	}
-	if (PolyIsCoeff(p)) {
-		return 0;
-	}
-
-	/* gdy zmienną jest x0, zwracamy po prostu najwyższy wykładnik */
-	if (var_idx == 0) {
-		return p->monos[p->monos_count - 1].exp;
-	}
-
-	/* dla zmiennych wyższych, trzeba wejsc do każdego jednomianu z osobna */
 
+	/*
+	 * nie wiemy w którym jednomianie znajdziemy najwyższą potęgę,
+	 * więc musimy szukać maximum "tradycyjnie"; poddrzewa do przejrzenia
+	 * czekają na stosie roboczym wątku
+	 */
 	poly_exp_t max_deg = 0;
-	poly_exp_t curr_deg = 0;
+	WorkStack *stack = &(ThreadWorkStacks()->deg_by);
+	size_t base = stack->count;
+	*(DegByFrame *) WorkStackPush(stack, sizeof(DegByFrame)) =
+		(DegByFrame) {p, var_idx};
+	while (stack->count > base) {
+		DegByFrame f = *(DegByFrame *) WorkStackPop(stack, sizeof(DegByFrame));
+
+		/* pominięte zmienne (i wszystkie w skalarach) występują w potędze 0 */
+		if (PolyIsCoeff(f.p) || f.var_idx < f.p->skip) {
+			continue;
+		}
+		f.var_idx -= f.p->skip;
 
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		/* z perspektywy współczynnika szukamy zminnej o 1 mniejszym indeksie */
-		curr_deg = PolyDegBy(&(p->monos[i].p), var_idx - 1);
-		/**
-		 * nie wiemy w którym jednomianie znajdziemy najwyższą potęgę,
-		 * więc musimy szukać maximum "tradycyjnie"
-		 */
-		if (curr_deg > max_deg) {
-			max_deg = curr_deg;
+		/* gdy zmienną jest x0, bierzemy po prostu najwyższy wykładnik */
+		if (f.var_idx == 0) {
+			poly_exp_t deg = f.p->monos[f.p->monos_count - 1].exp;
+			if (deg > max_deg) {
+				max_deg = deg;
+			}
+			continue;
+		}
+
+		/* z perspektywy współczynnika szukamy zmiennej o 1 mniejszym indeksie */
+		for (unsigned i = 0; i < f.p->monos_count; i++) {
+			*(DegByFrame *) WorkStackPush(stack, sizeof(DegByFrame)) =
+				(DegByFrame) {&(f.p->monos[i].p), f.var_idx - 1};
 		}
 	}
 
 	return max_deg;
 }
 
+/** Ramka iteracyjnego liczenia stopnia wielomianu */
+typedef struct DegFrame {
+	const Poly *p; ///< przeszukiwane poddrzewo
+	poly_exp_t deg; ///< suma wykładników na ścieżce od korzenia do poddrzewa
+} DegFrame;
+
 /**
  * Zwraca stopień wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
  * @param[in] p : wielomian
@@ -548,20 +1619,27 @@ poly_exp_t PolyDeg(const Poly *p) {
 	if (PolyIsZero(p)) {
 		return -1;
 	}
-	if (PolyIsCoeff(p)) {
-		return 0;
-	}
 
-	/* tak samo jak w PolyDegBy, tyle że sumujemy potęgi po drodze */
+	/*
+	 * tak samo jak w PolyDegBy, tyle że sumujemy potęgi po drodze;
+	 * współczynniki są niezerowe, więc każdy ma stopień sumy nad nim
+	 */
 	poly_exp_t max_deg = 0;
-	poly_exp_t curr_deg = 0;
-	Mono *m;
-
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		m = &(p->monos[i]);
-		curr_deg = PolyDeg(&(m->p)) + m->exp;
-		if (curr_deg > max_deg) {
-			max_deg = curr_deg;
+	WorkStack *stack = &(ThreadWorkStacks()->deg);
+	size_t base = stack->count;
+	*(DegFrame *) WorkStackPush(stack, sizeof(DegFrame)) = (DegFrame) {p, 0};
+	while (stack->count > base) {
+		DegFrame f = *(DegFrame *) WorkStackPop(stack, sizeof(DegFrame));
+		if (PolyIsCoeff(f.p)) {
+			if (f.deg > max_deg) {
+				max_deg = f.deg;
+			}
+			continue;
+		}
+		for (unsigned i = 0; i < f.p->monos_count; i++) {
+			const Mono *m = &(f.p->monos[i]);
+			*(DegFrame *) WorkStackPush(stack, sizeof(DegFrame)) =
+				(DegFrame) {&(m->p), f.deg + m->exp};
 		}
 	}
 
@@ -584,21 +1662,92 @@ bool MonoIsEq(const Mono *m, const Mono *o) {
 	return PolyIsEq(&(m->p), &(o->p));
 }
 
+/**
+ * Zadanie puli wątków: porównuje n-te przedziały jednomianów.
+ * @param[in] data : dane przejścia (TraversalJob)
+ * @param[in] n : numer przedziału
+ */
+void IsEqTask(void *data, size_t n) {
+	TraversalJob *job = data;
+	size_t end = job->count * (n + 1) / job->tasks;
+	job->equal[n] = true;
+	for (size_t i = job->count * n / job->tasks; i < end; i++) {
+		if (!MonoIsEq(&(job->monos[i]), &(job->other[i]))) {
+			job->equal[n] = false;
+			return;
+		}
+	}
+}
+
+/**
+ * Porównuje jednomiany bardzo szerokiego węzła równolegle.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian o tej samej liczbie jednomianów
+ * @param[in] tasks : liczba przedziałów
+ * @return czy jednomiany są równe
+ */
+bool ParallelMonosIsEq(const Poly *p, const Poly *q, size_t tasks) {
+	bool equal[tasks];
+	TraversalJob job = {p->monos, p->monos_count, q->monos, NULL, tasks,
+						equal};
+	PolyThreadsRun(IsEqTask, &job, tasks);
+	for (size_t n = 0; n < tasks; n++) {
+		if (!equal[n]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Ramka iteracyjnego porównywania wielomianów */
+typedef struct IsEqFrame {
+	const Poly *p; ///< poddrzewo pierwszego wielomianu
+	const Poly *q; ///< odpowiadające mu poddrzewo drugiego wielomianu
+} IsEqFrame;
+
 /**
  * Sprawdza równość dwóch wielomianów.
+ * Pary poddrzew do porównania czekają na stosie roboczym wątku.
+ * Jednomiany bardzo szerokich węzłów porównywane są równolegle.
  * @param[in] p : wielomian
  * @param[in] q : wielomian
  * @return `p = q`
  */
 bool PolyIsEq(const Poly *p, const Poly *q) {
-	if (p->scalar != q->scalar || p->monos_count != q->monos_count) {
-		return false;
-	}
-
-	for (unsigned i = 0; i < p->monos_count; i++) {
-		if (!MonoIsEq(&(p->monos[i]), &(q->monos[i]))) {
+	WorkStack *stack = &(ThreadWorkStacks()->is_eq);
+	size_t base = stack->count;
+	*(IsEqFrame *) WorkStackPush(stack, sizeof(IsEqFrame)) =
+		(IsEqFrame) {p, q};
+	while (stack->count > base) {
+		IsEqFrame f = *(IsEqFrame *) WorkStackPop(stack, sizeof(IsEqFrame));
+		if (f.p->scalar != f.q->scalar ||
+				f.p->monos_count != f.q->monos_count ||
+				f.p->skip != f.q->skip) {
+			stack->count = base;
 			return false;
 		}
+		/* np. internowane poddrzewa */
+		if (f.p->monos == f.q->monos) {
+			continue;
+		}
+
+		size_t tasks = TraversalTasks(f.p->monos, f.p->monos_count);
+		if (tasks > 1) {
+			if (!ParallelMonosIsEq(f.p, f.q, tasks)) {
+				stack->count = base;
+				return false;
+			}
+			continue;
+		}
+
+		for (unsigned i = 0; i < f.p->monos_count; i++) {
+			if (f.p->monos[i].exp != f.q->monos[i].exp) {
+				stack->count = base;
+				return false;
+			}
+			*(IsEqFrame *) WorkStackPush(stack, sizeof(IsEqFrame)) =
+				(IsEqFrame) {&(f.p->monos[i].p), &(f.q->monos[i].p)};
+		}
 	}
 
 	return true;
@@ -610,14 +1759,188 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
  * @return @f$x^e @f$
  */
 poly_coeff_t Pow(poly_coeff_t x, poly_exp_t e) {
-	poly_coeff_t r = 1;
+	poly_coeff_t r = CoeffFromInt(1);
 	while (e) {
 		if (e & 1) {
-			r *= x;
+			r = CoeffMul(r, x);
 		}
 		e >>= 1;
-		x *= x;
+		x = CoeffMul(x, x);
+	}
+	return r;
+}
+
+/** Stan liczenia kolejnych współczynników dwumianowych @f$\binom{n}{k}@f$ */
+typedef struct Binomial {
+	poly_coeff_t value; ///< bieżący współczynnik w pierścieniu współczynników
+	poly_ucoeff_t odd; ///< nieparzysta część współczynnika
+	unsigned twos; ///< wykładnik potęgi dwójki we współczynniku
+} Binomial;
+
+#if defined(POLY_COEFF_MOD)
+
+/** Czy wzór Newtona daje się policzyć w pierścieniu współczynników */
+#define BINOMIAL_POW_FITS(e) ((uint64_t) (e) < POLY_COEFF_MODULUS)
+
+/**
+ * Zwraca odwrotność współczynnika (z małego twierdzenia Fermata).
+ * @param[in] a : niezerowy współczynnik
+ * @return @f$a^{-1}@f$
+ */
+poly_coeff_t CoeffInverse(poly_coeff_t a) {
+	poly_coeff_t r = CoeffFromInt(1);
+	for (uint64_t e = POLY_COEFF_MODULUS - 2; e > 0; e >>= 1) {
+		if (e & 1) {
+			r = CoeffMul(r, a);
+		}
+		a = CoeffMul(a, a);
+	}
+	return r;
+}
+
+/**
+ * Przechodzi od @f$\binom{n}{k - 1}@f$ do @f$\binom{n}{k}@f$ modulo P.
+ * @param[in,out] b : stan
+ * @param[in] n : n
+ * @param[in] k : k (mniejsze od P)
+ */
+void BinomialNext(Binomial *b, poly_exp_t n, poly_exp_t k) {
+	b->value = CoeffMul(b->value, CoeffFromInt(n - k + 1));
+	b->value = CoeffMul(b->value, CoeffInverse(CoeffFromInt(k)));
+}
+
+#else
+
+/** Czy wzór Newtona daje się policzyć w pierścieniu współczynników */
+#define BINOMIAL_POW_FITS(e) true
+
+/**
+ * Przechodzi od @f$\binom{n}{k - 1}@f$ do @f$\binom{n}{k}@f$ modulo
+ * rozmiar typu (tak jak przepełnia się poly_coeff_t).
+ * Dzielenie przez k nie jest w tej arytmetyce wykonalne wprost, dlatego
+ * osobno pamiętamy potęgę dwójki i nieparzystą część współczynnika, którą
+ * dzielimy mnożąc przez odwrotność.
+ * @param[in,out] b : stan
+ * @param[in] n : n
+ * @param[in] k : k
+ */
+void BinomialNext(Binomial *b, poly_exp_t n, poly_exp_t k) {
+	poly_ucoeff_t num = n - k + 1;
+	poly_ucoeff_t den = k;
+	while ((num & 1) == 0) {
+		num >>= 1;
+		b->twos++;
+	}
+	while ((den & 1) == 0) {
+		den >>= 1;
+		b->twos--;
+	}
+
+	/* odwrotność liczby nieparzystej metodą Newtona: 3, 6, ..., 384 bity */
+	poly_ucoeff_t inv = den;
+	for (int i = 0; i < 7; i++) {
+		inv *= 2 - den * inv;
+	}
+	b->odd *= num * inv;
+
+	if (b->twos >= 8 * sizeof(poly_ucoeff_t)) {
+		b->value = 0;
+	} else {
+		b->value = (poly_coeff_t) (b->odd << b->twos);
+	}
+}
+
+#endif
+
+/** Największa szacowana liczba jednomianów rozwinięcia dwumianu ze wzoru
+ * Newtona – większe potęgi liczone są przez podnoszenie do kwadratu */
+#define BINOMIAL_POW_MAX_TERMS ((size_t) 1 << 20)
+
+/**
+ * Szacuje od góry rozmiar rozwinięcia @f$(u + v)^e@f$ ze wzoru Newtona:
+ * @f$e + 1@f$ wyrazów, każdy o współczynniku nie większym niż
+ * @f$t^e@f$, gdzie @f$t@f$ to większa z liczb składników współczynników
+ * @p u i @p v.
+ * @param[in] u : jednomian
+ * @param[in] v : jednomian
+ * @param[in] e : wykładnik
+ * @return szacowana liczba jednomianów (nie więcej niż SIZE_MAX)
+ */
+static size_t BinomialPowTerms(const Mono *u, const Mono *v, poly_exp_t e) {
+	size_t t = PolyTermsCount(&(u->p));
+	if (PolyTermsCount(&(v->p)) > t) {
+		t = PolyTermsCount(&(v->p));
+	}
+	size_t r = (size_t) e + 1;
+	for (poly_exp_t k = 0; t > 1 && k < e; k++) {
+		if (r > SIZE_MAX / t) {
+			return SIZE_MAX;
+		}
+		r *= t;
+	}
+	return r;
+}
+
+/**
+ * Podnosi dwumian @f$(u + v)^e@f$ do potęgi ze wzoru Newtona.
+ * Składniki są jednomianami o wykładnikach @f$e_u < e_v@f$, więc kolejne
+ * wyrazy rozwinięcia mają rosnące wykładniki i wynik nie wymaga sortowania.
+ * @param[in] u : jednomian o mniejszym wykładniku
+ * @param[in] v : jednomian o większym wykładniku
+ * @param[in] skip : `skip` wielomianu, którego jednomianami są @p u i @p v
+ * @param[in] e : wykładnik
+ * @return @f$(u + v)^e@f$
+ */
+Poly BinomialPow(const Mono *u, const Mono *v, unsigned skip, poly_exp_t e) {
+	/* potęgi współczynników: up[k] = u.p^k, vp[k] = v.p^k */
+	Poly *up = (Poly *) calloc(e + 1, sizeof(Poly));
+	Poly *vp = (Poly *) calloc(e + 1, sizeof(Poly));
+	assert(up != NULL && vp != NULL);
+	up[0] = PolyFromCoeff(1);
+	vp[0] = PolyFromCoeff(1);
+	for (poly_exp_t k = 1; k <= e; k++) {
+		up[k] = PolyMul(&(up[k - 1]), &(u->p));
+		vp[k] = PolyMul(&(vp[k - 1]), &(v->p));
+	}
+
+	Poly r;
+	r.scalar = 0;
+	r.monos_count = 0;
+	r.skip = skip;
+	r.monos = (Mono *) calloc(e + 1, sizeof(Mono));
+	assert(r.monos != NULL);
+
+	Binomial binomial;
+	binomial.value = CoeffFromInt(1);
+	binomial.odd = 1;
+	binomial.twos = 0;
+	for (poly_exp_t k = 0; k <= e; k++) {
+		if (k > 0) {
+			BinomialNext(&binomial, e, k);
+		}
+		if (binomial.value == 0) {
+			continue;
+		}
+
+		Poly c = PolyMul(&(up[e - k]), &(vp[k]));
+		Poly nc = PolyScalarMul(&c, binomial.value);
+		PolyDestroy(&c);
+		if (!PolyIsZero(&nc)) {
+			poly_exp_t exp = u->exp * (e - k) + v->exp * k;
+			InsertNthMono(r.monos, r.monos_count, MonoFromPoly(&nc, exp));
+			r.monos_count++;
+		}
+	}
+
+	for (poly_exp_t k = 0; k <= e; k++) {
+		PolyDestroy(&(up[k]));
+		PolyDestroy(&(vp[k]));
 	}
+	free(up);
+	free(vp);
+
+	/* przenosi skalar z x^0 do wyrazu wolnego, usuwa puste tablice */
+	SimplifyPoly(&r);
 	return r;
 }
 
@@ -626,25 +1949,59 @@ poly_coeff_t Pow(poly_coeff_t x, poly_exp_t e) {
  * @param[in] e : wykładnik
  * @return @f$x^e @f$
  */
- Poly PolyPow(const Poly *p, poly_exp_t e) {
+Poly PolyPow(const Poly *p, poly_exp_t e) {
+	/* przypadki szczególne: skalar, jednomian i dwumian mają postać jawną */
+	if (e == 0) {
+		return PolyFromCoeff(1);
+	}
+	if (PolyIsCoeff(p)) {
+		return PolyFromCoeff(Pow(p->scalar, e));
+	}
+	if (e == 1) {
+		return PolyClone(p);
+	}
+	if (PolyIsMono(p)) {
+		Poly c = PolyPow(&(p->monos[0].p), e);
+		Mono m = MonoFromPoly(&c, p->monos[0].exp * e);
+		Poly r = PolyAddMonos(1, &m);
+		/* PolyAddMonos buduje jednomiany zmiennej głównej */
+		if (!PolyIsCoeff(&r)) {
+			r.skip += p->skip;
+		}
+		return r;
+	}
+	if (PolyTermsCount(p) == 2 && BINOMIAL_POW_FITS(e)) {
+		Poly c = PolyFromCoeff(p->scalar);
+		Mono s = MonoFromPoly(&c, 0);
+		const Mono *u = p->scalar != 0 ? &s : &(p->monos[0]);
+		const Mono *v = p->scalar != 0 ? &(p->monos[0]) : &(p->monos[1]);
+		if (BinomialPowTerms(u, v, e) <= BINOMIAL_POW_MAX_TERMS) {
+			return BinomialPow(u, v, p->skip, e);
+		}
+	}
+
 	Poly r = PolyFromCoeff(1);
 	Poly q = PolyClone(p);
 	Poly nr;
 	Poly nq;
-	while (e) {
+	while (true) {
 		if (e & 1) {
 			nr = PolyMul(&r, &q);
 			PolyDestroy(&r);
 			r = nr;
 		}
 		e >>= 1;
+		/* nie podnosimy q do kwadratu, gdy nie będzie już potrzebne */
+		if (e == 0) {
+			break;
+		}
 		nq = PolyMul(&q, &q);
 		PolyDestroy(&q);
 		q = nq;
 	}
 	PolyDestroy(&q);
 	return r;
- }
+}
 
 /**
  * Wylicza wartość wielomianu w punkcie @p x.
@@ -662,6 +2019,12 @@ Poly PolyAt(const Poly *p, poly_coeff_t x) {
 	if (PolyIsCoeff(p)) {
 		return *p;
 	}
+	/* p nie zależy od x0, indeksy pozostałych zmiennych maleją o jeden */
+	if (p->skip > 0) {
+		Poly r = PolyClone(p);
+		r.skip--;
+		return r;
+	}
 
 	/*
 	 * będziemy szli po kolei po jednomianach i wyciągali ich wartość–wielomian
@@ -692,13 +2055,19 @@ Poly PolyAt(const Poly *p, poly_coeff_t x) {
  * @return wielomian
  */
 Poly MonoCompose(const Mono *m, unsigned count, const Poly x[]) {
-	Poly p = PolyPow(x, m->exp);
 	Poly q;
 	if (count == 0) {
-		q = m->p;
+		q = PolyClone(&(m->p));
 	} else {
 		q = PolyCompose(&(m->p), count - 1, &(x[1]));
 	}
+
+	/* x^0 = 1, nie ma czego mnożyć */
+	if (m->exp == 0 || PolyIsZero(&q)) {
+		return q;
+	}
+
+	Poly p = PolyPowCached(x, m->exp);
 	Poly r = PolyMul(&p, &q);
 	PolyDestroy(&p);
 	PolyDestroy(&q);
@@ -707,25 +2076,70 @@ Poly MonoCompose(const Mono *m, unsigned count, const Poly x[]) {
 
 /**
  * Robi głębokie przeszukiwanie w dół, sprawdzając czy przypadkiem
- * nie jest tak ze wszstkie wspolczynniki w jednomianie sie zerują
+ * nie jest tak ze wszstkie wspolczynniki w jednomianie sie zerują.
+ * Poddrzewa do sprawdzenia czekają na stosie roboczym wątku.
  * @param[in] m : jednomian
  * @return m to zero
  */
 bool MonoIsZero(const Mono *m) {
-	if (PolyIsZero(&(m->p))) {
-		return true;
-	}
-	if (m->p.scalar != 0) {
-		return false;
-	}
-	for (unsigned i = 0; i < m->p.monos_count; i++) {
-		if (!MonoIsZero(&m->p.monos[i])) {
+	WorkStack *stack = &(ThreadWorkStacks()->is_zero);
+	size_t base = stack->count;
+	*(const Poly **) WorkStackPush(stack, sizeof(const Poly *)) = &(m->p);
+	while (stack->count > base) {
+		const Poly *p = *(const Poly **) WorkStackPop(stack,
+													  sizeof(const Poly *));
+		if (p->scalar != 0) {
+			stack->count = base;
 			return false;
 		}
+		for (unsigned i = 0; i < p->monos_count; i++) {
+			*(const Poly **) WorkStackPush(stack, sizeof(const Poly *)) =
+				&(p->monos[i].p);
+		}
 	}
 	return true;
 }
 
+/** Dane równoległego złożenia wielomianu */
+typedef struct ComposeJob {
+	const Poly *p; ///< składany wielomian
+	unsigned count; ///< długość tablicy x
+	const Poly *x; ///< podstawiane wielomiany
+	Poly *terms; ///< złożenia kolejnych jednomianów p
+} ComposeJob;
+
+/**
+ * Zadanie puli wątków: składa n-ty jednomian p.
+ * @param[in] data : dane złożenia (ComposeJob)
+ * @param[in] n : numer jednomianu
+ */
+void ComposeTask(void *data, size_t n) {
+	ComposeJob *job = data;
+	job->terms[n + 1] = MonoCompose(&(job->p->monos[n]), job->count, job->x);
+}
+
+/**
+ * Składa wielomian, licząc złożenia jednomianów równolegle (każdy jednomian
+ * to osobne zadanie, przydzielane wolnym wątkom na bieżąco) i sumując je
+ * parami, też równolegle.
+ * @param[in] p : wielomian "główny"
+ * @param[in] count : długość tablicy x (co najmniej 1)
+ * @param[in] x : tablica wielomianów
+ * @return p(x[0], x[1], ..., x[count - 1], 0, 0, 0, ...)
+ */
+Poly PolyComposeParallel(const Poly *p, unsigned count, const Poly x[]) {
+	ComposeJob job = {p, count, x, calloc(p->monos_count + 1, sizeof(Poly))};
+	assert(job.terms != NULL);
+
+	job.terms[0] = PolyFromCoeff(p->scalar);
+	PolyThreadsRun(ComposeTask, &job, p->monos_count);
+	PolyAccumulateTree(job.terms, p->monos_count + 1);
+
+	Poly r = job.terms[0];
+	free(job.terms);
+	return r;
+}
+
 /**
  * Zwraca wielomian @p w którym pod i-tą zmienną podstawia wielomian x[i]
  * @param[in] p : wielomian "główny"
@@ -734,9 +2148,17 @@ bool MonoIsZero(const Mono *m) {
  * @return p(x[0], x[1], ..., x[count - 1], 0, 0, 0, ...)
  */
 Poly PolyCompose(const Poly *p, unsigned count, const Poly x[]) {
-	if (count == 0) {
+	/* za pominięte zmienne niczego nie podstawiamy */
+	if (count <= p->skip) {
 		return PolyFromCoeff(p->scalar);
 	}
+	count -= p->skip;
+	x += p->skip;
+
+	if (p->monos_count >= PARALLEL_COMPOSE_MIN_MONOS &&
+			PolyThreadsAvailable()) {
+		return PolyComposeParallel(p, count, x);
+	}
 
 	Poly r = PolyFromCoeff(p->scalar);
 	Poly tmp;
@@ -15,20 +15,28 @@
 #include <stdlib.h>
 #include <stdint.h>
 
-/** Typ współczynników wielomianu */
-typedef int64_t poly_coeff_t;
-#define POLY_COEFF_MAX INT64_MAX ///< maxymalna wartosc poly_coeff_t
+#include "poly_coeff.h"
+
 
 /** Typ wykładników wielomianu */
 typedef int32_t poly_exp_t;
 #define POLY_EXP_MAX INT32_MAX ///< maxymalna wartosc poly_exp_t
 
-/** Struktura przechowująca wielomian */
+/**
+ * Struktura przechowująca wielomian
+ * Jednomiany wielomianu niebędącego skalarem są jednomianami zmiennej
+ * o `skip` dalszej niż zmienna główna; pominięte zmienne występują w nim
+ * w potędze 0. Dzięki temu np. @f$x_{200}@f$ zajmuje jeden węzeł, a nie 200.
+ * Węzeł nie może składać się z samego jednomianu o wykładniku 0 (taki
+ * jednomian wchłania się, zwiększając `skip`), a skalar ma zawsze `skip`
+ * równe 0, więc postać wielomianu pozostaje jednoznaczna.
+ */
 typedef struct Poly
 {
 	poly_coeff_t scalar; ///< wyraz wolny wielomianu (skalar)
 	struct Mono *monos; ///< tablica jednomianów niebędących skalarami
-	size_t monos_count; ///< liczba elementów tablicy monos
+	unsigned monos_count; ///< liczba elementów tablicy monos
+	unsigned skip; ///< liczba pominiętych zmiennych przed zmienną jednomianów
 } Poly;
 
 /**
@@ -53,6 +61,7 @@ static inline Poly PolyFromCoeff(poly_coeff_t c) {
 	p.scalar = c;
 	p.monos = NULL;
 	p.monos_count = 0;
+	p.skip = 0;
 	return p;
 }
 
@@ -150,6 +159,28 @@ Poly PolyAdd(const Poly *p, const Poly *q);
  */
 Poly PolyAddMonos(unsigned count, const Mono monos[]);
 
+/**
+ * Sprowadza budowany wielomian do postaci z pominiętymi zmiennymi:
+ * węzeł złożony z jednego jednomianu o wykładniku 0 zastępuje tablicą
+ * jednomianów jego współczynnika, a skalarowi zeruje `skip`.
+ * @param[in,out] p : wielomian (jednomiany muszą już być w postaci
+ * standardowej)
+ */
+void PolyCollapse(Poly *p);
+
+/**
+ * Przedstawia wielomian jako wielomian o mniejszym `skip` bez kopiowania:
+ * wynik ma jeden jednomian o wykładniku 0 (zapisany w @p tmp), którego
+ * współczynnikiem jest @p p bez wyrazu wolnego. Wynik wskazuje na pamięć
+ * @p p i @p tmp, nie wolno go usuwać ani modyfikować. Skalary i wielomiany
+ * o równym @p skip zwracane są bez zmian.
+ * @param[in] p : wielomian
+ * @param[in] skip : docelowe `skip` (nie większe niż `p->skip`)
+ * @param[out] tmp : miejsce na jednomian
+ * @return wielomian równy @p p
+ */
+Poly PolyView(const Poly *p, unsigned skip, Mono *tmp);
+
 /**
  * Mnoży dwa wielomiany.
  * @param[in] p : wielomian
@@ -158,6 +189,21 @@ Poly PolyAddMonos(unsigned count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Wylicza kolejne jednomiany iloczynu `p * q` w kolejności rosnących
+ * wykładników, nie tworząc przy tym całego iloczynu.
+ * Każdy jednomian przekazywany jest na własność funkcji @p emit.
+ * Współczynnik jednomianu o wykładniku 0 zawiera też wyraz wolny iloczynu.
+ * Jednomiany zerowe są pomijane. Gdy żaden czynnik nie zależy od zmiennej
+ * głównej, cały iloczyn jest jednym jednomianem o wykładniku 0.
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @param[in] emit : funkcja otrzymująca kolejne jednomiany
+ * @param[in] data : dane przekazywane do @p emit
+ */
+void PolyMulForEach(const Poly *p, const Poly *q,
+					void (*emit)(Mono *m, void *data), void *data);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian
@@ -214,6 +260,14 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Podnosi wielomian do potęgi.
+ * @param[in] p : wielomian
+ * @param[in] e : wykładnik
+ * @return @f$p^e@f$
+ */
+Poly PolyPow(const Poly *p, poly_exp_t e);
+
 /**
  * Zwraca wielomian @p w którym pod i-tą zmienną podstawia wielomian x[i]
  * @param[in] p : wielomian "główny"
@@ -0,0 +1,594 @@
+/** @file
+   Implementacja pamięci podręcznej wyników MUL, POW i COMPOSE.
+
+   Wpisy są kluczowane haszem strukturalnym argumentów, a przy trafieniu
+   argumenty są dodatkowo porównywane przez PolyIsEq, więc kolizje haszy nie
+   mogą dać błędnego wyniku. Wpisy tworzą listę LRU; gdy suma rozmiarów
+   przekracza limit, usuwane są najdawniej używane.
+
+   Wyniki nie są kopiowane: wpis i wszyscy, którzy dostali wynik, dzielą
+   jego tablicę jednomianów, tylko do odczytu, tak jak wielomiany ze zrzutu
+   (zob. poly_snapshot.h). Tablica ma licznik odwołań w rejestrze
+   współdzielonych wyników i jest usuwana z ostatnim odwołaniem, także gdy
+   wpis został już usunięty z pamięci podręcznej. Rejestr jest podzielony
+   na części z osobnymi muteksami, bo sprawdza go każde PolyDestroy.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "poly.h"
+#include "poly_cache.h"
+
+#define INITIAL_BUCKETS_COUNT 1024 ///< początkowa liczba kubełków tablicy haszującej
+#define SHARED_STRIPES 64 ///< liczba części rejestru współdzielonych wyników
+#define SHARED_INITIAL_BUCKETS_COUNT 16 ///< początkowa liczba kubełków części rejestru
+
+/** Rodzaje zapamiętywanych operacji */
+enum cache_op_e {
+	CACHE_OP_MUL,
+	CACHE_OP_POW,
+	CACHE_OP_COMPOSE
+};
+
+/** Wpis pamięci podręcznej */
+typedef struct CacheEntry {
+	enum cache_op_e op; ///< operacja
+	uint64_t hash; ///< hasz operacji i argumentów
+	poly_exp_t exp; ///< wykładnik (tylko dla POW)
+	unsigned args_count; ///< liczba argumentów
+	Poly *args; ///< kopie argumentów (lub współdzielone argumenty)
+	Poly result; ///< wynik operacji (współdzielony)
+	size_t bytes; ///< pamięć zajmowana przez wpis
+	struct CacheEntry *bucket_next; ///< następny wpis w kubełku
+	struct CacheEntry *lru_prev; ///< wpis używany później
+	struct CacheEntry *lru_next; ///< wpis używany wcześniej
+} CacheEntry;
+
+/** Stan pamięci podręcznej */
+typedef struct PolyCache {
+	size_t max_bytes; ///< limit pamięci
+	size_t bytes; ///< zajęta pamięć
+	size_t hits; ///< liczba trafień
+	size_t misses; ///< liczba chybień
+	size_t entries_count; ///< liczba wpisów
+	size_t buckets_count; ///< liczba kubełków
+	CacheEntry **buckets; ///< tablica haszująca
+	CacheEntry *lru_head; ///< ostatnio używany wpis
+	CacheEntry *lru_tail; ///< najdawniej używany wpis
+} PolyCache;
+
+/** Współdzielony wynik – tablica jednomianów z licznikiem odwołań */
+typedef struct SharedResult {
+	const Mono *monos; ///< tablica jednomianów wyniku
+	size_t refs; ///< liczba odwołań (wpis pamięci podręcznej i wydane wyniki)
+	struct SharedResult *next; ///< następny wynik w kubełku
+} SharedResult;
+
+/** Część rejestru współdzielonych wyników */
+typedef struct SharedStripe {
+	pthread_mutex_t lock; ///< chroni część rejestru
+	SharedResult **buckets; ///< tablica haszująca według adresu tablicy
+	size_t buckets_count; ///< liczba kubełków
+	size_t count; ///< liczba wyników
+} SharedStripe;
+
+static PolyCache cache; ///< jedyna instancja pamięci podręcznej
+/** chroni pamięć podręczną przed równoczesnym dostępem z puli wątków */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static SharedStripe shared[SHARED_STRIPES]; ///< rejestr współdzielonych wyników
+static bool shared_ready = false; ///< czy muteksy rejestru są zainicjowane
+/** liczba wyników w rejestrze – gdy 0, PolyDestroy nie zagląda do rejestru */
+static atomic_size_t shared_count;
+
+/**
+ * Miesza wartość z haszem.
+ * @param[in] h : hasz
+ * @param[in] v : wartość
+ * @return nowy hasz
+ */
+static inline uint64_t HashMix(uint64_t h, uint64_t v) {
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h * 0xff51afd7ed558ccdULL;
+}
+
+/**
+ * Liczy hasz strukturalny wielomianu.
+ * @param[in] p : wielomian
+ * @return hasz
+ */
+uint64_t PolyHash(const Poly *p) {
+	uint64_t h = HashMix(0, (uint64_t) p->scalar);
+	h = HashMix(h, p->monos_count);
+	h = HashMix(h, p->skip);
+	for (size_t i = 0; i < p->monos_count; i++) {
+		h = HashMix(h, (uint64_t) p->monos[i].exp);
+		h = HashMix(h, PolyHash(&(p->monos[i].p)));
+	}
+	return h;
+}
+
+/**
+ * Szacuje pamięć zajmowaną przez tablice jednomianów wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba bajtów
+ */
+size_t PolyBytes(const Poly *p) {
+	size_t r = p->monos_count * sizeof(Mono);
+	for (size_t i = 0; i < p->monos_count; i++) {
+		r += PolyBytes(&(p->monos[i].p));
+	}
+	return r;
+}
+
+/**
+ * Szuka współdzielonego wyniku o podanej tablicy jednomianów
+ * (z zablokowaną częścią rejestru).
+ * @param[in] stripe : część rejestru
+ * @param[in] monos : tablica jednomianów
+ * @param[in] h : hasz adresu tablicy
+ * @return miejsce w kubełku, w którym jest wynik (lub NULL)
+ */
+static SharedResult **SharedFindLocked(SharedStripe *stripe,
+									   const Mono *monos, uint64_t h) {
+	SharedResult **link = &(stripe->buckets[h % stripe->buckets_count]);
+	while (*link != NULL && (*link)->monos != monos) {
+		link = &((*link)->next);
+	}
+	return link;
+}
+
+/**
+ * Wybiera część rejestru dla tablicy jednomianów.
+ * @param[in] monos : tablica jednomianów
+ * @param[out] h : hasz adresu tablicy
+ * @return część rejestru
+ */
+static SharedStripe *SharedStripeOf(const Mono *monos, uint64_t *h) {
+	uint64_t a = HashMix(0, (uintptr_t) monos);
+	*h = a / SHARED_STRIPES;
+	return &(shared[a % SHARED_STRIPES]);
+}
+
+/**
+ * Dodaje wynik do rejestru z podaną liczbą odwołań.
+ * @param[in] p : wynik (nie skalar)
+ * @param[in] refs : liczba odwołań
+ */
+static void SharedRegister(const Poly *p, size_t refs) {
+	uint64_t h;
+	SharedStripe *stripe = SharedStripeOf(p->monos, &h);
+	SharedResult *result = malloc(sizeof(SharedResult));
+	assert(result != NULL);
+	result->monos = p->monos;
+	result->refs = refs;
+
+	pthread_mutex_lock(&(stripe->lock));
+	if (stripe->count >= stripe->buckets_count) {
+		size_t new_count = stripe->buckets_count > 0 ?
+						   2 * stripe->buckets_count :
+						   SHARED_INITIAL_BUCKETS_COUNT;
+		SharedResult **buckets = calloc(new_count, sizeof(SharedResult *));
+		assert(buckets != NULL);
+		for (size_t b = 0; b < stripe->buckets_count; b++) {
+			while (stripe->buckets[b] != NULL) {
+				SharedResult *moved = stripe->buckets[b];
+				stripe->buckets[b] = moved->next;
+				uint64_t mh;
+				SharedStripeOf(moved->monos, &mh);
+				moved->next = buckets[mh % new_count];
+				buckets[mh % new_count] = moved;
+			}
+		}
+		free(stripe->buckets);
+		stripe->buckets = buckets;
+		stripe->buckets_count = new_count;
+	}
+	SharedResult **link = &(stripe->buckets[h % stripe->buckets_count]);
+	result->next = *link;
+	*link = result;
+	stripe->count++;
+	atomic_fetch_add(&shared_count, 1);
+	pthread_mutex_unlock(&(stripe->lock));
+}
+
+/**
+ * Zmienia liczbę odwołań do współdzielonego wyniku.
+ * @param[in] p : wielomian
+ * @param[in] delta : 1 (nowe odwołanie), -1 (zwolnienie odwołania) albo
+ * 0 (tylko sprawdzenie)
+ * @param[out] last : czy zwolnione zostało ostatnie odwołanie (wynik jest
+ * wtedy usunięty z rejestru)
+ * @return Czy wielomian jest współdzielonym wynikiem?
+ */
+static bool SharedUpdate(const Poly *p, int delta, bool *last) {
+	*last = false;
+	if (PolyIsCoeff(p) ||
+			atomic_load_explicit(&shared_count, memory_order_relaxed) == 0) {
+		return false;
+	}
+	uint64_t h;
+	SharedStripe *stripe = SharedStripeOf(p->monos, &h);
+	pthread_mutex_lock(&(stripe->lock));
+	if (stripe->count == 0) {
+		pthread_mutex_unlock(&(stripe->lock));
+		return false;
+	}
+	SharedResult **link = SharedFindLocked(stripe, p->monos, h);
+	SharedResult *result = *link;
+	if (result != NULL && delta > 0) {
+		result->refs++;
+	} else if (result != NULL && delta < 0 && --(result->refs) == 0) {
+		*link = result->next;
+		stripe->count--;
+		atomic_fetch_sub(&shared_count, 1);
+		free(result);
+		*last = true;
+	}
+	pthread_mutex_unlock(&(stripe->lock));
+	return result != NULL;
+}
+
+/**
+ * Kopiuje argument do wpisu: współdzielone wielomiany dostają nowe
+ * odwołanie, pozostałe są kopiowane.
+ * @param[in] p : argument
+ * @return wielomian należący do wpisu
+ */
+static Poly ArgShare(const Poly *p) {
+	bool last;
+	if (SharedUpdate(p, 1, &last)) {
+		return *p;
+	}
+	return PolyClone(p);
+}
+
+/**
+ * Liczy hasz klucza operacji.
+ * @param[in] op : operacja
+ * @param[in] args_count : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] e : wykładnik
+ * @return hasz
+ */
+static uint64_t KeyHash(enum cache_op_e op, unsigned args_count,
+						const Poly args[], poly_exp_t e) {
+	uint64_t h = HashMix(op, args_count);
+	h = HashMix(h, (uint64_t) e);
+	for (unsigned i = 0; i < args_count; i++) {
+		h = HashMix(h, PolyHash(&(args[i])));
+	}
+	return h;
+}
+
+/**
+ * Odpina wpis z listy LRU.
+ * @param[in] entry : wpis
+ */
+static void LruUnlink(CacheEntry *entry) {
+	if (entry->lru_prev != NULL) {
+		entry->lru_prev->lru_next = entry->lru_next;
+	} else {
+		cache.lru_head = entry->lru_next;
+	}
+	if (entry->lru_next != NULL) {
+		entry->lru_next->lru_prev = entry->lru_prev;
+	} else {
+		cache.lru_tail = entry->lru_prev;
+	}
+	entry->lru_prev = NULL;
+	entry->lru_next = NULL;
+}
+
+/**
+ * Wstawia wpis na początek listy LRU.
+ * @param[in] entry : wpis
+ */
+static void LruPushFront(CacheEntry *entry) {
+	entry->lru_prev = NULL;
+	entry->lru_next = cache.lru_head;
+	if (cache.lru_head != NULL) {
+		cache.lru_head->lru_prev = entry;
+	} else {
+		cache.lru_tail = entry;
+	}
+	cache.lru_head = entry;
+}
+
+/**
+ * Usuwa wpis z tablicy haszującej, listy LRU i pamięci.
+ * @param[in] entry : wpis
+ */
+static void EntryRemove(CacheEntry *entry) {
+	CacheEntry **slot = &(cache.buckets[entry->hash % cache.buckets_count]);
+	while (*slot != entry) {
+		slot = &((*slot)->bucket_next);
+	}
+	*slot = entry->bucket_next;
+	LruUnlink(entry);
+
+	for (unsigned i = 0; i < entry->args_count; i++) {
+		PolyDestroy(&(entry->args[i]));
+	}
+	free(entry->args);
+	PolyDestroy(&(entry->result));
+
+	cache.bytes -= entry->bytes;
+	cache.entries_count--;
+	free(entry);
+}
+
+/**
+ * Podwaja liczbę kubełków tablicy haszującej.
+ */
+static void GrowBuckets() {
+	size_t new_count = 2 * cache.buckets_count;
+	CacheEntry **buckets = calloc(new_count, sizeof(CacheEntry *));
+	assert(buckets != NULL);
+
+	for (size_t b = 0; b < cache.buckets_count; b++) {
+		CacheEntry *entry = cache.buckets[b];
+		while (entry != NULL) {
+			CacheEntry *next = entry->bucket_next;
+			entry->bucket_next = buckets[entry->hash % new_count];
+			buckets[entry->hash % new_count] = entry;
+			entry = next;
+		}
+	}
+
+	free(cache.buckets);
+	cache.buckets = buckets;
+	cache.buckets_count = new_count;
+}
+
+/**
+ * Szuka wyniku operacji w pamięci podręcznej.
+ * @param[in] op : operacja
+ * @param[in] hash : hasz klucza
+ * @param[in] args_count : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] e : wykładnik
+ * @return znaleziony wpis lub NULL
+ */
+static CacheEntry *Lookup(enum cache_op_e op, uint64_t hash,
+						  unsigned args_count, const Poly args[],
+						  poly_exp_t e) {
+	CacheEntry *entry = cache.buckets[hash % cache.buckets_count];
+	for (; entry != NULL; entry = entry->bucket_next) {
+		if (entry->hash != hash || entry->op != op || entry->exp != e ||
+				entry->args_count != args_count) {
+			continue;
+		}
+		bool equal = true;
+		for (unsigned i = 0; i < args_count && equal; i++) {
+			equal = PolyIsEq(&(entry->args[i]), &(args[i]));
+		}
+		if (equal) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Zapamiętuje wynik operacji, usuwając najdawniej używane wpisy, jeżeli
+ * przekroczony zostałby limit pamięci.
+ * @param[in] op : operacja
+ * @param[in] hash : hasz klucza
+ * @param[in] args_count : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] e : wykładnik
+ * @param[in] result : wynik
+ */
+static void Store(enum cache_op_e op, uint64_t hash, unsigned args_count,
+				  const Poly args[], poly_exp_t e, const Poly *result) {
+	size_t bytes = sizeof(CacheEntry) + args_count * sizeof(Poly) +
+				   PolyBytes(result);
+	for (unsigned i = 0; i < args_count; i++) {
+		bytes += PolyBytes(&(args[i]));
+	}
+	/* wpis, który i tak by się nie zmieścił, nie wypycha innych */
+	if (bytes > cache.max_bytes) {
+		return;
+	}
+
+	while (cache.bytes + bytes > cache.max_bytes) {
+		EntryRemove(cache.lru_tail);
+	}
+
+	CacheEntry *entry = malloc(sizeof(CacheEntry));
+	assert(entry != NULL);
+	entry->op = op;
+	entry->hash = hash;
+	entry->exp = e;
+	entry->args_count = args_count;
+	entry->args = calloc(args_count, sizeof(Poly));
+	assert(args_count == 0 || entry->args != NULL);
+	for (unsigned i = 0; i < args_count; i++) {
+		entry->args[i] = ArgShare(&(args[i]));
+	}
+	/* jedno odwołanie ma wpis, drugie ten, kto policzył wynik */
+	entry->result = *result;
+	if (!PolyIsCoeff(result)) {
+		SharedRegister(result, 2);
+	}
+	entry->bytes = bytes;
+
+	if (cache.entries_count >= 2 * cache.buckets_count) {
+		GrowBuckets();
+	}
+	size_t b = hash % cache.buckets_count;
+	entry->bucket_next = cache.buckets[b];
+	cache.buckets[b] = entry;
+	LruPushFront(entry);
+
+	cache.bytes += bytes;
+	cache.entries_count++;
+}
+
+/**
+ * Zwraca wynik z pamięci podręcznej albo liczy go i zapamiętuje.
+ * @param[in] op : operacja
+ * @param[in] args_count : liczba argumentów
+ * @param[in] args : argumenty
+ * @param[in] e : wykładnik
+ * @return wynik operacji
+ */
+static Poly Memoize(enum cache_op_e op, unsigned args_count,
+					const Poly args[], poly_exp_t e) {
+	uint64_t hash = KeyHash(op, args_count, args, e);
+
+	pthread_mutex_lock(&cache_lock);
+	CacheEntry *entry = Lookup(op, hash, args_count, args, e);
+	if (entry != NULL) {
+		cache.hits++;
+		LruUnlink(entry);
+		LruPushFront(entry);
+		Poly r = entry->result;
+		PolyCacheShare(&r);
+		pthread_mutex_unlock(&cache_lock);
+		return r;
+	}
+	cache.misses++;
+	pthread_mutex_unlock(&cache_lock);
+
+	Poly r;
+	switch (op) {
+	case CACHE_OP_MUL:
+		r = PolyMul(&(args[0]), &(args[1]));
+		break;
+	case CACHE_OP_POW:
+		r = PolyPow(&(args[0]), e);
+		break;
+	case CACHE_OP_COMPOSE:
+		r = PolyCompose(&(args[0]), args_count - 1, &(args[1]));
+		break;
+	default:
+		assert(false);
+		r = PolyZero();
+		break;
+	}
+
+	pthread_mutex_lock(&cache_lock);
+	/* inny wątek mógł w międzyczasie zapamiętać ten sam wynik */
+	if (Lookup(op, hash, args_count, args, e) == NULL) {
+		Store(op, hash, args_count, args, e, &r);
+	}
+	pthread_mutex_unlock(&cache_lock);
+	return r;
+}
+
+void PolyCacheInit(size_t max_bytes) {
+	PolyCacheDestroy();
+	if (max_bytes == 0) {
+		return;
+	}
+
+	if (!shared_ready) {
+		for (size_t i = 0; i < SHARED_STRIPES; i++) {
+			pthread_mutex_init(&(shared[i].lock), NULL);
+		}
+		shared_ready = true;
+	}
+
+	cache.max_bytes = max_bytes;
+	cache.buckets_count = INITIAL_BUCKETS_COUNT;
+	cache.buckets = calloc(cache.buckets_count, sizeof(CacheEntry *));
+	assert(cache.buckets != NULL);
+}
+
+void PolyCacheDestroy() {
+	while (cache.lru_tail != NULL) {
+		EntryRemove(cache.lru_tail);
+	}
+	free(cache.buckets);
+
+	cache.max_bytes = 0;
+	cache.bytes = 0;
+	cache.hits = 0;
+	cache.misses = 0;
+	cache.entries_count = 0;
+	cache.buckets_count = 0;
+	cache.buckets = NULL;
+}
+
+bool PolyCacheEnabled() {
+	return cache.buckets != NULL;
+}
+
+size_t PolyCacheHits() {
+	return cache.hits;
+}
+
+size_t PolyCacheMisses() {
+	return cache.misses;
+}
+
+size_t PolyCacheBytes() {
+	return cache.bytes;
+}
+
+bool PolyCacheShared(const Poly *p) {
+	bool last;
+	return SharedUpdate(p, 0, &last);
+}
+
+bool PolyCacheShare(const Poly *p) {
+	bool last;
+	return SharedUpdate(p, 1, &last);
+}
+
+bool PolyCacheRelease(Poly *p) {
+	bool last;
+	if (!SharedUpdate(p, -1, &last)) {
+		return false;
+	}
+	/* wyniku nie ma już w rejestrze, więc usuwa się go zwyczajnie */
+	if (last) {
+		PolyDestroy(p);
+	}
+	*p = PolyZero();
+	return true;
+}
+
+Poly PolyMulCached(const Poly *p, const Poly *q) {
+	/* iloczyn przez skalar jest tańszy niż haszowanie */
+	if (!PolyCacheEnabled() || PolyIsCoeff(p) || PolyIsCoeff(q)) {
+		return PolyMul(p, q);
+	}
+	Poly args[2] = {*p, *q};
+	return Memoize(CACHE_OP_MUL, 2, args, 0);
+}
+
+Poly PolyPowCached(const Poly *p, poly_exp_t e) {
+	if (!PolyCacheEnabled() || PolyIsCoeff(p) || e <= 1) {
+		return PolyPow(p, e);
+	}
+	return Memoize(CACHE_OP_POW, 1, p, e);
+}
+
+Poly PolyComposeCached(const Poly *p, unsigned count, const Poly x[]) {
+	if (!PolyCacheEnabled() || PolyIsCoeff(p)) {
+		return PolyCompose(p, count, x);
+	}
+
+	Poly *args = calloc(count + 1, sizeof(Poly));
+	assert(args != NULL);
+	args[0] = *p;
+	for (unsigned i = 0; i < count; i++) {
+		args[i + 1] = x[i];
+	}
+	Poly r = Memoize(CACHE_OP_COMPOSE, count + 1, args, 0);
+	free(args);
+	return r;
+}
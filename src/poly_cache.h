@@ -0,0 +1,109 @@
+/** @file
+   Interfejs pamięci podręcznej wyników MUL, POW i COMPOSE
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_CACHE_H__
+#define __POLY_CACHE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+
+/** Zmienna środowiskowa z limitem pamięci podręcznej w bajtach */
+#define POLY_CACHE_ENV "CALC_POLY_CACHE_BYTES"
+
+/**
+ * Włącza pamięć podręczną wyników.
+ * Domyślnie pamięć podręczna jest wyłączona i funkcje *Cached działają
+ * dokładnie tak jak ich odpowiedniki bez pamięci.
+ * @param[in] max_bytes : limit pamięci zajmowanej przez wpisy (0 wyłącza)
+ */
+void PolyCacheInit(size_t max_bytes);
+
+/**
+ * Usuwa wszystkie wpisy i wyłącza pamięć podręczną.
+ */
+void PolyCacheDestroy();
+
+/**
+ * Sprawdza, czy pamięć podręczna jest włączona.
+ * @return Czy pamięć podręczna jest włączona?
+ */
+bool PolyCacheEnabled();
+
+/**
+ * Zwraca liczbę trafień od momentu włączenia pamięci podręcznej.
+ * @return liczba trafień
+ */
+size_t PolyCacheHits();
+
+/**
+ * Zwraca liczbę chybień od momentu włączenia pamięci podręcznej.
+ * @return liczba chybień
+ */
+size_t PolyCacheMisses();
+
+/**
+ * Zwraca liczbę bajtów zajmowanych obecnie przez wpisy.
+ * @return zajęta pamięć
+ */
+size_t PolyCacheBytes();
+
+/**
+ * Sprawdza, czy wielomian jest wynikiem współdzielonym z pamięcią
+ * podręczną. Taki wielomian jest tylko do odczytu.
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest współdzielonym wynikiem?
+ */
+bool PolyCacheShared(const Poly *p);
+
+/**
+ * Dodaje odwołanie do współdzielonego wyniku – wielomian można wtedy
+ * skopiować płytko (każda kopia jest osobno usuwana przez PolyDestroy).
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest współdzielonym wynikiem (jeśli nie, nic się
+ * nie dzieje)?
+ */
+bool PolyCacheShare(const Poly *p);
+
+/**
+ * Zwalnia odwołanie do współdzielonego wyniku; wynik jest usuwany razem
+ * z ostatnim odwołaniem.
+ * @param[in,out] p : wielomian
+ * @return Czy wielomian był współdzielonym wynikiem (jeśli nie, nic się
+ * nie dzieje)?
+ */
+bool PolyCacheRelease(Poly *p);
+
+/**
+ * Jak PolyMul, ale korzysta z pamięci podręcznej. Wynik może być
+ * współdzielony z pamięcią podręczną (zob. PolyCacheShared).
+ * @param[in] p : wielomian
+ * @param[in] q : wielomian
+ * @return `p * q`
+ */
+Poly PolyMulCached(const Poly *p, const Poly *q);
+
+/**
+ * Jak PolyPow, ale korzysta z pamięci podręcznej.
+ * @param[in] p : wielomian
+ * @param[in] e : wykładnik
+ * @return @f$p^e@f$
+ */
+Poly PolyPowCached(const Poly *p, poly_exp_t e);
+
+/**
+ * Jak PolyCompose, ale korzysta z pamięci podręcznej.
+ * @param[in] p : wielomian "główny"
+ * @param[in] count : długość tablicy x
+ * @param[in] x : tablica wielomianów
+ * @return p(x[0], x[1], ..., x[count - 1], 0, 0, 0, ...)
+ */
+Poly PolyComposeCached(const Poly *p, unsigned count, const Poly x[]);
+
+#endif /* __POLY_CACHE_H__ */
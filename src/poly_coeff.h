@@ -0,0 +1,227 @@
+/** @file
+   Typ i arytmetyka współczynników wielomianów
+
+   Pierścień współczynników wybierany jest w czasie kompilacji:
+   - domyślnie `int64_t` z arytmetyką modulo @f$2^{64}@f$,
+   - `POLY_COEFF_I32` – `int32_t` (mniej pamięci),
+   - `POLY_COEFF_I128` – `__int128` (rzadziej przepełnia się),
+   - `POLY_COEFF_MOD` – reszty modulo nieparzysta liczba pierwsza
+     `POLY_COEFF_MODULUS` mniejsza niż @f$2^{63}@f$; dla domyślnego modułu
+     @f$2^{61} - 1@f$ iloczyn redukowany jest przesunięciami, a dla innych
+     metodą Montgomery'ego.
+
+   Wszystkie operacje na współczynnikach przechodzą przez funkcje Coeff*,
+   które są inline, więc w każdym wariancie arytmetyka wchodzi bezpośrednio
+   do pętli obliczeniowych.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_COEFF_H__
+#define __POLY_COEFF_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(POLY_COEFF_I32)
+
+/** Typ współczynników wielomianu */
+typedef int32_t poly_coeff_t;
+/** Typ bez znaku tej samej szerokości co poly_coeff_t */
+typedef uint32_t poly_ucoeff_t;
+/** Typ wczytywanych liczb (mieści każdą poprawną liczbę wejścia) */
+typedef int64_t poly_input_t;
+/** Typ bez znaku tej samej szerokości co poly_input_t */
+typedef uint64_t poly_uinput_t;
+#define POLY_COEFF_MAX INT32_MAX ///< maxymalna wartosc poly_coeff_t
+#define POLY_COEFF_INPUT_MAX INT32_MAX ///< maksymalny moduł wczytywanej liczby
+
+#elif defined(POLY_COEFF_I128)
+
+/** Typ współczynników wielomianu */
+typedef __int128 poly_coeff_t;
+/** Typ bez znaku tej samej szerokości co poly_coeff_t */
+typedef unsigned __int128 poly_ucoeff_t;
+/** Typ wczytywanych liczb (mieści każdą poprawną liczbę wejścia) */
+typedef __int128 poly_input_t;
+/** Typ bez znaku tej samej szerokości co poly_input_t */
+typedef unsigned __int128 poly_uinput_t;
+/** maxymalna wartosc poly_coeff_t */
+#define POLY_COEFF_MAX ((poly_coeff_t) (~(poly_ucoeff_t) 0 >> 1))
+/** maksymalny moduł wczytywanej liczby – wczytujemy wszystko, co drukujemy */
+#define POLY_COEFF_INPUT_MAX POLY_COEFF_MAX
+
+#elif defined(POLY_COEFF_MOD)
+
+#ifndef POLY_COEFF_MODULUS
+#define POLY_COEFF_MODULUS UINT64_C(2305843009213693951) ///< moduł, @f$2^{61} - 1@f$
+#endif
+
+_Static_assert(POLY_COEFF_MODULUS % 2 == 1,
+			   "POLY_COEFF_MODULUS must be odd for Montgomery reduction");
+_Static_assert(POLY_COEFF_MODULUS > 2 &&
+			   POLY_COEFF_MODULUS < (UINT64_C(1) << 63),
+			   "POLY_COEFF_MODULUS must be below 2^63 for CoeffAdd and CoeffRedc");
+
+/** Typ współczynników wielomianu (reszta z przedziału [0, moduł)) */
+typedef int64_t poly_coeff_t;
+/** Typ bez znaku tej samej szerokości co poly_coeff_t */
+typedef uint64_t poly_ucoeff_t;
+/** Typ wczytywanych liczb (mieści każdą poprawną liczbę wejścia) */
+typedef int64_t poly_input_t;
+/** Typ bez znaku tej samej szerokości co poly_input_t */
+typedef uint64_t poly_uinput_t;
+#define POLY_COEFF_MAX ((poly_coeff_t) (POLY_COEFF_MODULUS - 1)) ///< maxymalna wartosc poly_coeff_t
+#define POLY_COEFF_INPUT_MAX INT64_MAX ///< maksymalny moduł wczytywanej liczby
+
+#else
+
+/** Typ współczynników wielomianu */
+typedef int64_t poly_coeff_t;
+/** Typ bez znaku tej samej szerokości co poly_coeff_t */
+typedef uint64_t poly_ucoeff_t;
+/** Typ wczytywanych liczb (mieści każdą poprawną liczbę wejścia) */
+typedef int64_t poly_input_t;
+/** Typ bez znaku tej samej szerokości co poly_input_t */
+typedef uint64_t poly_uinput_t;
+#define POLY_COEFF_MAX INT64_MAX ///< maxymalna wartosc poly_coeff_t
+#define POLY_COEFF_INPUT_MAX INT64_MAX ///< maksymalny moduł wczytywanej liczby
+
+#endif
+
+#if defined(POLY_COEFF_MOD)
+
+/**
+ * Zwraca @f$-P^{-1} \bmod 2^{64}@f$ dla modułu P (stała Montgomery'ego).
+ * @return stała Montgomery'ego
+ */
+static inline uint64_t CoeffMontgomeryInv() {
+	uint64_t inv = POLY_COEFF_MODULUS;
+	for (int i = 0; i < 6; i++) {
+		inv *= 2 - POLY_COEFF_MODULUS * inv;
+	}
+	return -inv;
+}
+
+/**
+ * Redukcja Montgomery'ego: zwraca @f$t \cdot 2^{-64} \bmod P@f$.
+ * @param[in] t : liczba mniejsza niż @f$P \cdot 2^{64}@f$
+ * @return wynik redukcji z przedziału [0, P)
+ */
+static inline uint64_t CoeffRedc(unsigned __int128 t) {
+	uint64_t m = (uint64_t) t * CoeffMontgomeryInv();
+	uint64_t r = (t + (unsigned __int128) m * POLY_COEFF_MODULUS) >> 64;
+	return r >= POLY_COEFF_MODULUS ? r - POLY_COEFF_MODULUS : r;
+}
+
+/**
+ * Zamienia liczbę całkowitą na współczynnik.
+ * @param[in] v : liczba
+ * @return współczynnik
+ */
+static inline poly_coeff_t CoeffFromInt(int64_t v) {
+	int64_t r = v % (int64_t) POLY_COEFF_MODULUS;
+	return r < 0 ? r + (int64_t) POLY_COEFF_MODULUS : r;
+}
+
+/**
+ * Dodaje współczynniki.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a + b`
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+	uint64_t r = (uint64_t) a + (uint64_t) b;
+	return r >= POLY_COEFF_MODULUS ? r - POLY_COEFF_MODULUS : r;
+}
+
+/**
+ * Zwraca współczynnik przeciwny.
+ * @param[in] a : współczynnik
+ * @return `-a`
+ */
+static inline poly_coeff_t CoeffNeg(poly_coeff_t a) {
+	return a == 0 ? 0 : (poly_coeff_t) (POLY_COEFF_MODULUS - a);
+}
+
+#if POLY_COEFF_MODULUS == UINT64_C(2305843009213693951)
+
+/**
+ * Mnoży współczynniki.
+ * Dla @f$P = 2^{61} - 1@f$ mamy @f$2^{61} \equiv 1@f$, więc iloczyn
+ * redukujemy, dodając jego młodsze 61 bitów do starszych.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a * b`
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+	unsigned __int128 t = (unsigned __int128) (uint64_t) a * (uint64_t) b;
+	uint64_t r = ((uint64_t) t & POLY_COEFF_MODULUS) + (uint64_t) (t >> 61);
+	r = (r & POLY_COEFF_MODULUS) + (r >> 61);
+	return r >= POLY_COEFF_MODULUS ? r - POLY_COEFF_MODULUS : r;
+}
+
+#else
+
+/**
+ * Mnoży współczynniki.
+ * Pierwsza redukcja daje @f$ab \cdot 2^{-64}@f$, druga – przez pomnożenie
+ * przez @f$2^{128} \bmod P@f$ – przywraca zwykłą postać reszty.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a * b`
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+	const uint64_t r1 = ((unsigned __int128) 1 << 64) % POLY_COEFF_MODULUS;
+	const uint64_t r2 = (unsigned __int128) r1 * r1 % POLY_COEFF_MODULUS;
+	uint64_t t = CoeffRedc((unsigned __int128) (uint64_t) a * (uint64_t) b);
+	return CoeffRedc((unsigned __int128) t * r2);
+}
+
+#endif
+
+#else
+
+/**
+ * Zamienia liczbę całkowitą na współczynnik.
+ * @param[in] v : liczba
+ * @return współczynnik
+ */
+static inline poly_coeff_t CoeffFromInt(poly_input_t v) {
+	return (poly_coeff_t) v;
+}
+
+/**
+ * Dodaje współczynniki (modulo rozmiar typu).
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a + b`
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+	return (poly_coeff_t) ((poly_ucoeff_t) a + (poly_ucoeff_t) b);
+}
+
+/**
+ * Zwraca współczynnik przeciwny (modulo rozmiar typu).
+ * @param[in] a : współczynnik
+ * @return `-a`
+ */
+static inline poly_coeff_t CoeffNeg(poly_coeff_t a) {
+	return (poly_coeff_t) (-(poly_ucoeff_t) a);
+}
+
+/**
+ * Mnoży współczynniki (modulo rozmiar typu).
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return `a * b`
+ */
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+	return (poly_coeff_t) ((poly_ucoeff_t) a * (poly_ucoeff_t) b);
+}
+
+#endif
+
+#endif /* __POLY_COEFF_H__ */
@@ -0,0 +1,367 @@
+/** @file
+   Implementacja płaskiej reprezentacji wielomianów.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "poly.h"
+#include "poly_flat.h"
+
+/**
+ * Zwraca liczbę pól mieszczących się w jednym słowie.
+ * @param[in] layout : upakowanie
+ * @return liczba pól w słowie
+ */
+static inline unsigned FieldsPerWord(FlatLayout layout) {
+	return FLAT_WORD_BITS / layout.bits;
+}
+
+/**
+ * Zwraca słowo, w którym leży pole zmiennej.
+ * @param[in] layout : upakowanie
+ * @param[in] var : indeks zmiennej
+ * @return indeks słowa
+ */
+static inline unsigned FieldWord(FlatLayout layout, unsigned var) {
+	return var / FieldsPerWord(layout);
+}
+
+/**
+ * Zwraca przesunięcie pola zmiennej w słowie.
+ * @param[in] layout : upakowanie
+ * @param[in] var : indeks zmiennej
+ * @return przesunięcie w bitach
+ */
+static inline unsigned FieldShift(FlatLayout layout, unsigned var) {
+	unsigned per_word = FieldsPerWord(layout);
+	return (per_word - 1 - var % per_word) * layout.bits;
+}
+
+/**
+ * Odczytuje wykładnik zmiennej z upakowanego wektora.
+ * @param[in] layout : upakowanie
+ * @param[in] exp : wektor wykładników
+ * @param[in] var : indeks zmiennej
+ * @return wykładnik
+ */
+static inline poly_exp_t FieldGet(FlatLayout layout, const uint64_t exp[],
+								  unsigned var) {
+	uint64_t mask = (UINT64_C(1) << layout.bits) - 1;
+	return (exp[FieldWord(layout, var)] >> FieldShift(layout, var)) & mask;
+}
+
+/**
+ * Zwraca maskę bitów strażników jednego słowa.
+ * @param[in] layout : upakowanie
+ * @return maska strażników
+ */
+static uint64_t GuardMask(FlatLayout layout) {
+	uint64_t mask = 0;
+	for (unsigned i = 0; i < FieldsPerWord(layout); i++) {
+		mask |= UINT64_C(1) << (i * layout.bits + layout.bits - 1);
+	}
+	return mask;
+}
+
+/**
+ * Porównuje upakowane wektory wykładników.
+ * @param[in] a : wektor
+ * @param[in] b : wektor
+ * @return znak różnicy a i b w porządku leksykograficznym
+ */
+static inline int FlatExpCompare(const uint64_t a[], const uint64_t b[]) {
+	for (unsigned w = 0; w < FLAT_WORDS; w++) {
+		if (a[w] != b[w]) {
+			return a[w] < b[w] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+/* Funkcja pomocnicza dla qsort */
+static int FlatTermCompareForQsort(const void *a, const void *b) {
+	return FlatExpCompare(((const FlatTerm *) a)->exp,
+						  ((const FlatTerm *) b)->exp);
+}
+
+/**
+ * Przydziela tablicę jednomianów (co najmniej jednoelementową, żeby pusty
+ * wielomian nie był mylony z brakiem pamięci).
+ * @param[in] count : liczba jednomianów
+ * @return tablica jednomianów
+ */
+static FlatTerm *FlatTermsAlloc(size_t count) {
+	FlatTerm *terms = malloc((count > 0 ? count : 1) * sizeof(FlatTerm));
+	assert(terms != NULL);
+	return terms;
+}
+
+unsigned PolyVarsCount(const Poly *p) {
+	unsigned r = 0;
+	for (size_t i = 0; i < p->monos_count; i++) {
+		unsigned vars = p->skip + 1 + PolyVarsCount(&(p->monos[i].p));
+		if (vars > r) {
+			r = vars;
+		}
+	}
+	return r;
+}
+
+poly_exp_t PolyMaxExp(const Poly *p) {
+	poly_exp_t r = 0;
+	for (size_t i = 0; i < p->monos_count; i++) {
+		poly_exp_t e = PolyMaxExp(&(p->monos[i].p));
+		if (p->monos[i].exp > e) {
+			e = p->monos[i].exp;
+		}
+		if (e > r) {
+			r = e;
+		}
+	}
+	return r;
+}
+
+bool FlatLayoutFit(unsigned vars, poly_exp_t max_exp, FlatLayout *layout) {
+	/* bity na wartość + bit strażnika */
+	unsigned bits = 1;
+	while (bits < 32 && ((uint64_t) max_exp >> bits) != 0) {
+		bits++;
+	}
+	bits++;
+
+	layout->vars = vars;
+	layout->bits = bits;
+	return vars <= FLAT_WORDS * (FLAT_WORD_BITS / bits);
+}
+
+/**
+ * Liczy jednomiany (niezerowe skalary w liściach) wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów płaskiej reprezentacji
+ */
+static size_t PolyTermsCountDeep(const Poly *p) {
+	size_t r = (p->scalar != 0);
+	for (size_t i = 0; i < p->monos_count; i++) {
+		r += PolyTermsCountDeep(&(p->monos[i].p));
+	}
+	return r;
+}
+
+/**
+ * Dopisuje jednomiany wielomianu do płaskiej reprezentacji.
+ * Skalar poprzedza jednomiany o wykładniku 0 z głębszymi zmiennymi, więc
+ * przejście w głąb daje jednomiany od razu posortowane.
+ * @param[in] p : wielomian
+ * @param[in] var : indeks zmiennej wielomianu @p p
+ * @param[in] prefix : wykładniki zmiennych o mniejszych indeksach
+ * @param[in,out] f : wielomian wynikowy
+ */
+static void FlattenInto(const Poly *p, unsigned var, const uint64_t prefix[],
+						FlatPoly *f) {
+	if (p->scalar != 0) {
+		FlatTerm *t = &(f->terms[f->count++]);
+		for (unsigned w = 0; w < FLAT_WORDS; w++) {
+			t->exp[w] = prefix[w];
+		}
+		t->coeff = p->scalar;
+	}
+
+	/* jednomiany są jednomianami zmiennej o skip dalszej */
+	var += p->skip;
+	for (size_t i = 0; i < p->monos_count; i++) {
+		assert(((uint64_t) p->monos[i].exp >> (f->layout.bits - 1)) == 0);
+		uint64_t exp[FLAT_WORDS];
+		for (unsigned w = 0; w < FLAT_WORDS; w++) {
+			exp[w] = prefix[w];
+		}
+		exp[FieldWord(f->layout, var)] |=
+			(uint64_t) p->monos[i].exp << FieldShift(f->layout, var);
+		FlattenInto(&(p->monos[i].p), var + 1, exp, f);
+	}
+}
+
+FlatPoly PolyToFlat(const Poly *p, FlatLayout layout) {
+	assert(layout.vars >= PolyVarsCount(p));
+
+	FlatPoly f;
+	f.layout = layout;
+	f.count = 0;
+	f.terms = FlatTermsAlloc(PolyTermsCountDeep(p));
+
+	uint64_t prefix[FLAT_WORDS] = {0};
+	FlattenInto(p, 0, prefix, &f);
+	return f;
+}
+
+/**
+ * Buduje wielomian drzewiasty z posortowanego fragmentu płaskiej
+ * reprezentacji, w którym wszystkie jednomiany mają te same wykładniki
+ * zmiennych o indeksach mniejszych niż @p var.
+ * @param[in] f : wielomian w płaskiej reprezentacji
+ * @param[in] begin : początek fragmentu
+ * @param[in] end : koniec fragmentu
+ * @param[in] var : indeks zmiennej budowanego wielomianu
+ * @return wielomian
+ */
+static Poly Unflatten(const FlatPoly *f, size_t begin, size_t end,
+					  unsigned var) {
+	if (var == f->layout.vars) {
+		assert(end - begin == 1);
+		return PolyFromCoeff(f->terms[begin].coeff);
+	}
+
+	/* liczymy różne wykładniki zmiennej var */
+	size_t groups = 0;
+	for (size_t i = begin; i < end; i++) {
+		if (i == begin || FieldGet(f->layout, f->terms[i].exp, var) !=
+						  FieldGet(f->layout, f->terms[i - 1].exp, var)) {
+			groups++;
+		}
+	}
+
+	Poly r = PolyZero();
+	r.monos = calloc(groups, sizeof(Mono));
+	assert(r.monos != NULL);
+
+	size_t i = begin;
+	while (i < end) {
+		poly_exp_t exp = FieldGet(f->layout, f->terms[i].exp, var);
+		size_t j = i + 1;
+		while (j < end && FieldGet(f->layout, f->terms[j].exp, var) == exp) {
+			j++;
+		}
+
+		Poly c = Unflatten(f, i, j, var + 1);
+		/* skalar współczynnika przy x^0 jest wyrazem wolnym */
+		if (exp == 0) {
+			r.scalar = c.scalar;
+			c.scalar = 0;
+		}
+		if (!PolyIsZero(&c)) {
+			r.monos[r.monos_count++] = MonoFromPoly(&c, exp);
+		}
+		i = j;
+	}
+
+	if (PolyIsCoeff(&r)) {
+		free(r.monos);
+		r.monos = NULL;
+	}
+	PolyCollapse(&r);
+	return r;
+}
+
+Poly FlatToPoly(const FlatPoly *f) {
+	if (f->count == 0) {
+		return PolyZero();
+	}
+	return Unflatten(f, 0, f->count, 0);
+}
+
+void FlatDestroy(FlatPoly *f) {
+	free(f->terms);
+	f->terms = NULL;
+	f->count = 0;
+}
+
+FlatPoly FlatAdd(const FlatPoly *f, const FlatPoly *g) {
+	assert(f->layout.bits == g->layout.bits &&
+		   f->layout.vars == g->layout.vars);
+
+	FlatPoly r;
+	r.layout = f->layout;
+	r.count = 0;
+	r.terms = FlatTermsAlloc(f->count + g->count);
+
+	size_t i = 0;
+	size_t j = 0;
+	while (i < f->count && j < g->count) {
+		int cmp = FlatExpCompare(f->terms[i].exp, g->terms[j].exp);
+		if (cmp < 0) {
+			r.terms[r.count++] = f->terms[i++];
+		} else if (cmp > 0) {
+			r.terms[r.count++] = g->terms[j++];
+		} else {
+			FlatTerm t = f->terms[i++];
+			t.coeff = CoeffAdd(t.coeff, g->terms[j++].coeff);
+			if (t.coeff != 0) {
+				r.terms[r.count++] = t;
+			}
+		}
+	}
+	while (i < f->count) {
+		r.terms[r.count++] = f->terms[i++];
+	}
+	while (j < g->count) {
+		r.terms[r.count++] = g->terms[j++];
+	}
+
+	return r;
+}
+
+bool FlatMul(const FlatPoly *f, const FlatPoly *g, FlatPoly *r) {
+	assert(f->layout.bits == g->layout.bits &&
+		   f->layout.vars == g->layout.vars);
+
+	r->layout = f->layout;
+	r->count = 0;
+	r->terms = FlatTermsAlloc(f->count * g->count);
+
+	uint64_t guard = GuardMask(f->layout);
+	for (size_t i = 0; i < f->count; i++) {
+		for (size_t j = 0; j < g->count; j++) {
+			FlatTerm *t = &(r->terms[r->count++]);
+			uint64_t overflow = 0;
+			for (unsigned w = 0; w < FLAT_WORDS; w++) {
+				t->exp[w] = f->terms[i].exp[w] + g->terms[j].exp[w];
+				overflow |= t->exp[w] & guard;
+			}
+			if (overflow != 0) {
+				r->count = 0;
+				return false;
+			}
+			t->coeff = CoeffMul(f->terms[i].coeff, g->terms[j].coeff);
+		}
+	}
+
+	qsort(r->terms, r->count, sizeof(FlatTerm), FlatTermCompareForQsort);
+
+	/* łączymy jednomiany o równych wykładnikach, usuwamy zerowe */
+	size_t k = 0;
+	for (size_t i = 0; i < r->count; i++) {
+		if (k > 0 && FlatExpCompare(r->terms[k - 1].exp,
+									r->terms[i].exp) == 0) {
+			r->terms[k - 1].coeff = CoeffAdd(r->terms[k - 1].coeff,
+											 r->terms[i].coeff);
+			if (r->terms[k - 1].coeff == 0) {
+				k--;
+			}
+		} else if (r->terms[i].coeff != 0) {
+			r->terms[k++] = r->terms[i];
+		}
+	}
+	r->count = k;
+
+	return true;
+}
+
+bool FlatIsEq(const FlatPoly *f, const FlatPoly *g) {
+	if (f->count != g->count) {
+		return false;
+	}
+	for (size_t i = 0; i < f->count; i++) {
+		if (f->terms[i].coeff != g->terms[i].coeff ||
+				FlatExpCompare(f->terms[i].exp, g->terms[i].exp) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
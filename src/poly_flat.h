@@ -0,0 +1,126 @@
+/** @file
+   Interfejs płaskiej reprezentacji wielomianów
+
+   Wielomian jest posortowaną tablicą par (wektor wykładników, współczynnik).
+   Wektor wykładników wszystkich zmiennych jest upakowany w FLAT_WORDS
+   słowach maszynowych, więc porównanie jednomianów to porównanie słów,
+   a mnożenie jednomianów to dodawanie słów.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_FLAT_H__
+#define __POLY_FLAT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poly.h"
+
+#define FLAT_WORDS 2 ///< liczba słów na upakowany wektor wykładników
+#define FLAT_WORD_BITS 64 ///< liczba bitów w słowie
+
+/**
+ * Sposób upakowania wykładników.
+ * Każda zmienna zajmuje pole `bits` bitów, którego najstarszy bit jest
+ * bitem strażnika (zawsze 0 w poprawnym wektorze) – przepełnienie pola
+ * przy dodawaniu ustawia strażnika i jest wykrywane.
+ * Pola nie przechodzą przez granicę słów, a zmienna x_0 zajmuje najstarsze
+ * bity pierwszego słowa, więc porządek słów jest porządkiem
+ * leksykograficznym wektorów wykładników.
+ */
+typedef struct FlatLayout {
+	unsigned vars; ///< liczba zmiennych
+	unsigned bits; ///< szerokość pola jednej zmiennej (ze strażnikiem)
+} FlatLayout;
+
+/** Jednomian płaskiej reprezentacji */
+typedef struct FlatTerm {
+	uint64_t exp[FLAT_WORDS]; ///< upakowany wektor wykładników
+	poly_coeff_t coeff; ///< współczynnik
+} FlatTerm;
+
+/** Wielomian w płaskiej reprezentacji */
+typedef struct FlatPoly {
+	FlatLayout layout; ///< sposób upakowania wykładników
+	size_t count; ///< liczba jednomianów
+	FlatTerm *terms; ///< jednomiany posortowane rosnąco według wykładników
+} FlatPoly;
+
+/**
+ * Zwraca liczbę zmiennych występujących w wielomianie (głębokość drzewa).
+ * @param[in] p : wielomian
+ * @return liczba zmiennych
+ */
+unsigned PolyVarsCount(const Poly *p);
+
+/**
+ * Zwraca największy wykładnik występujący w wielomianie (na dowolnym
+ * poziomie), 0 dla skalarów.
+ * @param[in] p : wielomian
+ * @return największy wykładnik
+ */
+poly_exp_t PolyMaxExp(const Poly *p);
+
+/**
+ * Dobiera upakowanie dla @p vars zmiennych i wykładników nie większych
+ * niż @p max_exp.
+ * @param[in] vars : liczba zmiennych
+ * @param[in] max_exp : największy wykładnik
+ * @param[out] layout : dobrane upakowanie
+ * @return Czy wykładniki mieszczą się w FLAT_WORDS słowach?
+ */
+bool FlatLayoutFit(unsigned vars, poly_exp_t max_exp, FlatLayout *layout);
+
+/**
+ * Zamienia wielomian na płaską reprezentację.
+ * Wielomian musi mieścić się w upakowaniu @p layout.
+ * @param[in] p : wielomian
+ * @param[in] layout : upakowanie
+ * @return wielomian w płaskiej reprezentacji
+ */
+FlatPoly PolyToFlat(const Poly *p, FlatLayout layout);
+
+/**
+ * Zamienia wielomian z płaskiej reprezentacji na drzewiastą.
+ * @param[in] f : wielomian w płaskiej reprezentacji
+ * @return wielomian
+ */
+Poly FlatToPoly(const FlatPoly *f);
+
+/**
+ * Usuwa wielomian w płaskiej reprezentacji z pamięci.
+ * @param[in] f : wielomian
+ */
+void FlatDestroy(FlatPoly *f);
+
+/**
+ * Dodaje dwa wielomiany o tym samym upakowaniu.
+ * @param[in] f : wielomian
+ * @param[in] g : wielomian
+ * @return `f + g`
+ */
+FlatPoly FlatAdd(const FlatPoly *f, const FlatPoly *g);
+
+/**
+ * Mnoży dwa wielomiany o tym samym upakowaniu.
+ * @param[in] f : wielomian
+ * @param[in] g : wielomian
+ * @param[out] r : `f * g`
+ * @return Czy wykładniki iloczynu zmieściły się w upakowaniu?
+ * (w przeciwnym razie @p r jest zerem)
+ */
+bool FlatMul(const FlatPoly *f, const FlatPoly *g, FlatPoly *r);
+
+/**
+ * Sprawdza równość dwóch wielomianów o tym samym upakowaniu.
+ * @param[in] f : wielomian
+ * @param[in] g : wielomian
+ * @return `f = g`
+ */
+bool FlatIsEq(const FlatPoly *f, const FlatPoly *g);
+
+#endif /* __POLY_FLAT_H__ */
@@ -0,0 +1,489 @@
+/** @file
+   Implementacja internowania wielomianów.
+
+   Każda internowana tablica jednomianów ma wpis z licznikiem odwołań
+   (z tablic nadrzędnych i z wielomianów na stosie). Wpisy można znaleźć
+   po zawartości tablicy (przy internowaniu) i po jej adresie (przy
+   zwalnianiu).
+
+   Wielomiany usuwają także wątki puli i wątek usuwający w tle, a każde
+   PolyDestroy zwalnia odwołania, więc zwalnianie nie blokuje całej tablicy:
+   indeks adresów jest podzielony na części z osobnymi muteksami, a licznik
+   odwołań jest atomowy. Muteks tablicy (`intern_lock`) chroni indeks
+   zawartości; bierze go internowanie i zwolnienie ostatniego odwołania.
+   Licznik, który raz spadł do zera, już nie rośnie – internowanie pomija
+   taki wpis, a usuwa go wątek, który zwolnił ostatnie odwołanie.
+
+   Internowanie i usuwanie wpisów przechodzą drzewo bez rekurencji, na
+   stosach roboczych wątku (work_stack.h), więc głębokość wielomianu
+   ogranicza tylko rozmiar sterty.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "poly.h"
+#include "poly_cache.h"
+#include "poly_intern.h"
+#include "poly_snapshot.h"
+#include "work_stack.h"
+
+#define INITIAL_BUCKETS_COUNT 1024 ///< początkowa liczba kubełków indeksu zawartości
+#define ADDRESS_STRIPES 64 ///< liczba części indeksu adresów
+#define ADDRESS_INITIAL_BUCKETS_COUNT 64 ///< początkowa liczba kubełków części indeksu adresów
+
+/** Wpis internowanej tablicy jednomianów */
+typedef struct InternNode {
+	Mono *monos; ///< tablica jednomianów
+	size_t count; ///< długość tablicy
+	uint64_t hash; ///< hasz zawartości tablicy
+	atomic_size_t refs; ///< liczba odwołań do tablicy
+	struct InternNode *next_by_content; ///< następny wpis w kubełku zawartości
+	struct InternNode *next_by_address; ///< następny wpis w kubełku adresu
+} InternNode;
+
+/** Część indeksu adresów z własnym muteksem */
+typedef struct AddressStripe {
+	pthread_mutex_t lock; ///< chroni część indeksu
+	InternNode **buckets; ///< kubełki według adresu tablicy
+	size_t buckets_count; ///< liczba kubełków
+	size_t count; ///< liczba wpisów
+} AddressStripe;
+
+/** Tablica internowania */
+typedef struct InternTable {
+	bool enabled; ///< czy internowanie jest włączone
+	InternNode **by_content; ///< kubełki według hasza zawartości
+	size_t buckets_count; ///< liczba kubełków indeksu zawartości
+	size_t nodes_count; ///< liczba wpisów
+	AddressStripe by_address[ADDRESS_STRIPES]; ///< indeks adresów
+} InternTable;
+
+static InternTable table; ///< jedyna instancja tablicy internowania
+/** chroni indeks zawartości i usuwanie wpisów */
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool stripes_ready = false; ///< czy muteksy indeksu adresów są zainicjowane
+
+/**
+ * Miesza wartość z haszem.
+ * @param[in] h : hasz
+ * @param[in] v : wartość
+ * @return nowy hasz
+ */
+static inline uint64_t HashMix(uint64_t h, uint64_t v) {
+	h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	return h * 0xff51afd7ed558ccdULL;
+}
+
+/**
+ * Liczy płytki hasz tablicy jednomianów o internowanych współczynnikach.
+ * @param[in] monos : tablica jednomianów
+ * @param[in] count : długość tablicy
+ * @return hasz
+ */
+static uint64_t MonosHash(const Mono *monos, size_t count) {
+	uint64_t h = HashMix(0, count);
+	for (size_t i = 0; i < count; i++) {
+		h = HashMix(h, (uint64_t) monos[i].exp);
+		h = HashMix(h, (uint64_t) monos[i].p.scalar);
+		h = HashMix(h, (uintptr_t) monos[i].p.monos);
+		h = HashMix(h, monos[i].p.skip);
+	}
+	return h;
+}
+
+/**
+ * Liczy hasz adresu tablicy.
+ * @param[in] monos : tablica jednomianów
+ * @return hasz (część indeksu to reszta z dzielenia przez ADDRESS_STRIPES)
+ */
+static inline uint64_t AddressHash(const Mono *monos) {
+	return HashMix(0, (uintptr_t) monos);
+}
+
+/**
+ * Zwraca część indeksu adresów, w której jest tablica.
+ * @param[in] monos : tablica jednomianów
+ * @return część indeksu
+ */
+static inline AddressStripe *StripeOf(const Mono *monos) {
+	return &(table.by_address[AddressHash(monos) % ADDRESS_STRIPES]);
+}
+
+/**
+ * Zwraca miejsce w kubełku części indeksu adresów, w którym jest (albo
+ * powinien być) wpis tablicy (z zablokowaną częścią).
+ * @param[in] stripe : część indeksu
+ * @param[in] monos : tablica jednomianów
+ * @return miejsce w kubełku
+ */
+static InternNode **AddressLinkLocked(AddressStripe *stripe,
+									  const Mono *monos) {
+	size_t b = AddressHash(monos) / ADDRESS_STRIPES % stripe->buckets_count;
+	InternNode **link = &(stripe->buckets[b]);
+	while (*link != NULL && (*link)->monos != monos) {
+		link = &((*link)->next_by_address);
+	}
+	return link;
+}
+
+/**
+ * Porównuje płytko tablice jednomianów o internowanych współczynnikach.
+ * @param[in] a : tablica jednomianów
+ * @param[in] b : tablica jednomianów
+ * @param[in] count : długość tablic
+ * @return Czy tablice są równe?
+ */
+static bool MonosShallowEq(const Mono *a, const Mono *b, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (a[i].exp != b[i].exp || a[i].p.scalar != b[i].p.scalar ||
+				a[i].p.monos != b[i].p.monos ||
+				a[i].p.monos_count != b[i].p.monos_count ||
+				a[i].p.skip != b[i].p.skip) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Wyszukuje wpis tablicy o podanym adresie.
+ * @param[in] monos : tablica jednomianów
+ * @return wpis albo NULL
+ */
+static InternNode *FindByAddress(const Mono *monos) {
+	AddressStripe *stripe = StripeOf(monos);
+	pthread_mutex_lock(&(stripe->lock));
+	InternNode *node = *AddressLinkLocked(stripe, monos);
+	pthread_mutex_unlock(&(stripe->lock));
+	return node;
+}
+
+/**
+ * Dodaje odwołanie do wpisu, o ile jego licznik nie spadł już do zera.
+ * @param[in] node : wpis
+ * @return Czy udało się dodać odwołanie?
+ */
+static bool Acquire(InternNode *node) {
+	size_t refs = atomic_load(&(node->refs));
+	while (refs > 0) {
+		if (atomic_compare_exchange_weak(&(node->refs), &refs, refs + 1)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Wyszukuje żywy wpis tablicy o podanej zawartości i dodaje do niego
+ * odwołanie (z zablokowanym `intern_lock`).
+ * @param[in] monos : tablica jednomianów
+ * @param[in] count : długość tablicy
+ * @param[in] hash : hasz zawartości
+ * @return wpis albo NULL
+ */
+static InternNode *AcquireByContent(const Mono *monos, size_t count,
+									uint64_t hash) {
+	InternNode *node = table.by_content[hash % table.buckets_count];
+	while (node != NULL && (node->hash != hash || node->count != count ||
+							!MonosShallowEq(node->monos, monos, count) ||
+							!Acquire(node))) {
+		node = node->next_by_content;
+	}
+	return node;
+}
+
+/**
+ * Podwaja liczbę kubełków części indeksu adresów (z zablokowaną częścią).
+ * @param[in,out] stripe : część indeksu
+ */
+static void GrowStripe(AddressStripe *stripe) {
+	size_t old_count = stripe->buckets_count;
+	InternNode **old = stripe->buckets;
+
+	stripe->buckets_count *= 2;
+	stripe->buckets = calloc(stripe->buckets_count, sizeof(InternNode *));
+	assert(stripe->buckets != NULL);
+	for (size_t i = 0; i < old_count; i++) {
+		InternNode *node = old[i];
+		while (node != NULL) {
+			InternNode *next = node->next_by_address;
+			InternNode **link = AddressLinkLocked(stripe, node->monos);
+			node->next_by_address = *link;
+			*link = node;
+			node = next;
+		}
+	}
+	free(old);
+}
+
+/**
+ * Wstawia wpis do indeksów (z zablokowanym `intern_lock`).
+ * @param[in] node : wpis
+ */
+static void Link(InternNode *node) {
+	size_t c = node->hash % table.buckets_count;
+	node->next_by_content = table.by_content[c];
+	table.by_content[c] = node;
+
+	AddressStripe *stripe = StripeOf(node->monos);
+	pthread_mutex_lock(&(stripe->lock));
+	if (stripe->count >= stripe->buckets_count) {
+		GrowStripe(stripe);
+	}
+	InternNode **link = AddressLinkLocked(stripe, node->monos);
+	node->next_by_address = *link;
+	*link = node;
+	stripe->count++;
+	pthread_mutex_unlock(&(stripe->lock));
+}
+
+/**
+ * Usuwa wpis z indeksów (z zablokowanym `intern_lock`).
+ * @param[in] node : wpis
+ */
+static void Unlink(InternNode *node) {
+	InternNode **link = &(table.by_content[node->hash % table.buckets_count]);
+	while (*link != node) {
+		link = &((*link)->next_by_content);
+	}
+	*link = node->next_by_content;
+
+	AddressStripe *stripe = StripeOf(node->monos);
+	pthread_mutex_lock(&(stripe->lock));
+	link = AddressLinkLocked(stripe, node->monos);
+	assert(*link == node);
+	*link = node->next_by_address;
+	stripe->count--;
+	pthread_mutex_unlock(&(stripe->lock));
+}
+
+/**
+ * Podwaja liczbę kubełków indeksu zawartości (z zablokowanym `intern_lock`).
+ */
+static void GrowBuckets() {
+	size_t old_count = table.buckets_count;
+	InternNode **old = table.by_content;
+
+	table.buckets_count *= 2;
+	table.by_content = calloc(table.buckets_count, sizeof(InternNode *));
+	assert(table.by_content != NULL);
+
+	for (size_t i = 0; i < old_count; i++) {
+		InternNode *node = old[i];
+		while (node != NULL) {
+			InternNode *next = node->next_by_content;
+			size_t c = node->hash % table.buckets_count;
+			node->next_by_content = table.by_content[c];
+			table.by_content[c] = node;
+			node = next;
+		}
+	}
+	free(old);
+}
+
+/**
+ * Zwalnia odwołanie do internowanej tablicy wielomianu; wpis, którego
+ * licznik spadł do zera, odkłada na stos wpisów do usunięcia
+ * (z zablokowanym `intern_lock`).
+ * @param[in] p : internowany wielomian
+ * @param[in,out] stack : wpisy do usunięcia (InternNode *)
+ */
+static void ReleaseLocked(const Poly *p, WorkStack *stack) {
+	if (PolyIsCoeff(p)) {
+		return;
+	}
+	InternNode *node = FindByAddress(p->monos);
+	assert(node != NULL);
+	if (atomic_fetch_sub(&(node->refs), 1) == 1) {
+		*(InternNode **) WorkStackPush(stack, sizeof(InternNode *)) = node;
+	}
+}
+
+/**
+ * Usuwa wpisy z wierzchu stosu aż do @p base razem z tablicami i zwalnia
+ * odwołania do ich współczynników (z zablokowanym `intern_lock`).
+ * @param[in,out] stack : wpisy do usunięcia (InternNode *)
+ * @param[in] base : liczba wpisów, które zostają na stosie
+ */
+static void DeleteLocked(WorkStack *stack, size_t base) {
+	while (stack->count > base) {
+		InternNode *node =
+			*(InternNode **) WorkStackPop(stack, sizeof(InternNode *));
+		Unlink(node);
+		table.nodes_count--;
+		for (size_t i = 0; i < node->count; i++) {
+			ReleaseLocked(&(node->monos[i].p), stack);
+		}
+		free(node->monos);
+		free(node);
+	}
+}
+
+/**
+ * Usuwa wpis, którego licznik odwołań spadł do zera
+ * (z zablokowanym `intern_lock`).
+ * @param[in] node : wpis
+ */
+static void DeleteNodeLocked(InternNode *node) {
+	WorkStack *stack = &(ThreadWorkStacks()->intern_delete);
+	size_t base = stack->count;
+	*(InternNode **) WorkStackPush(stack, sizeof(InternNode *)) = node;
+	DeleteLocked(stack, base);
+}
+
+/** Ramka iteracyjnego internowania */
+typedef struct InternFrame {
+	Poly *p; ///< internowane poddrzewo
+	bool children_done; ///< czy współczynniki są już internowane
+} InternFrame;
+
+/**
+ * Internuje tablicę wielomianu, którego współczynniki są już internowane
+ * (z zablokowanym `intern_lock`).
+ * @param[in,out] p : wielomian
+ */
+static void InternNodeLocked(Poly *p) {
+	uint64_t hash = MonosHash(p->monos, p->monos_count);
+	InternNode *node = AcquireByContent(p->monos, p->monos_count, hash);
+	if (node != NULL) {
+		/* taka tablica już jest; jej współczynniki mają własne odwołania */
+		WorkStack *stack = &(ThreadWorkStacks()->intern_delete);
+		size_t base = stack->count;
+		for (size_t i = 0; i < p->monos_count; i++) {
+			ReleaseLocked(&(p->monos[i].p), stack);
+		}
+		DeleteLocked(stack, base);
+		free(p->monos);
+		p->monos = node->monos;
+		return;
+	}
+
+	node = malloc(sizeof(InternNode));
+	assert(node != NULL);
+	node->monos = p->monos;
+	node->count = p->monos_count;
+	node->hash = hash;
+	atomic_init(&(node->refs), 1);
+	Link(node);
+	table.nodes_count++;
+	if (table.nodes_count > table.buckets_count) {
+		GrowBuckets();
+	}
+}
+
+/**
+ * Internuje wielomian od liści w górę (z zablokowanym `intern_lock`).
+ * Poddrzewa czekające na internowanie leżą na stosie roboczym wątku.
+ * @param[in,out] p : wielomian
+ */
+static void InternLocked(Poly *p) {
+	WorkStack *stack = &(ThreadWorkStacks()->intern);
+	size_t base = stack->count;
+	*(InternFrame *) WorkStackPush(stack, sizeof(InternFrame)) =
+		(InternFrame) {p, false};
+	while (stack->count > base) {
+		InternFrame f = *(InternFrame *) WorkStackPop(stack,
+													   sizeof(InternFrame));
+		if (f.children_done) {
+			InternNodeLocked(f.p);
+			continue;
+		}
+		if (PolyIsCoeff(f.p) || FindByAddress(f.p->monos) != NULL) {
+			continue;
+		}
+		*(InternFrame *) WorkStackPush(stack, sizeof(InternFrame)) =
+			(InternFrame) {f.p, true};
+		for (size_t i = 0; i < f.p->monos_count; i++) {
+			*(InternFrame *) WorkStackPush(stack, sizeof(InternFrame)) =
+				(InternFrame) {&(f.p->monos[i].p), false};
+		}
+	}
+}
+
+void PolyInternInit() {
+	PolyInternDestroy();
+	if (!stripes_ready) {
+		for (size_t i = 0; i < ADDRESS_STRIPES; i++) {
+			pthread_mutex_init(&(table.by_address[i].lock), NULL);
+		}
+		stripes_ready = true;
+	}
+	table.buckets_count = INITIAL_BUCKETS_COUNT;
+	table.by_content = calloc(table.buckets_count, sizeof(InternNode *));
+	assert(table.by_content != NULL);
+	for (size_t i = 0; i < ADDRESS_STRIPES; i++) {
+		AddressStripe *stripe = &(table.by_address[i]);
+		stripe->buckets_count = ADDRESS_INITIAL_BUCKETS_COUNT;
+		stripe->buckets = calloc(stripe->buckets_count, sizeof(InternNode *));
+		assert(stripe->buckets != NULL);
+		stripe->count = 0;
+	}
+	table.nodes_count = 0;
+	table.enabled = true;
+}
+
+void PolyInternDestroy() {
+	if (!table.enabled) {
+		return;
+	}
+	assert(table.nodes_count == 0);
+	free(table.by_content);
+	table.by_content = NULL;
+	for (size_t i = 0; i < ADDRESS_STRIPES; i++) {
+		free(table.by_address[i].buckets);
+		table.by_address[i].buckets = NULL;
+		table.by_address[i].buckets_count = 0;
+	}
+	table.enabled = false;
+}
+
+bool PolyInternEnabled() {
+	return table.enabled;
+}
+
+void PolyIntern(Poly *p) {
+	/* wielomiany ze zrzutu i współdzielone wyniki z pamięci podręcznej są
+	   już tylko do odczytu i nie są internowane */
+	if (!table.enabled || PolyIsCoeff(p) || PolySnapshotMapped(p) ||
+			PolyCacheShared(p)) {
+		return;
+	}
+	pthread_mutex_lock(&intern_lock);
+	InternLocked(p);
+	pthread_mutex_unlock(&intern_lock);
+}
+
+bool PolyInternRelease(Poly *p) {
+	if (!table.enabled || PolyIsCoeff(p)) {
+		return false;
+	}
+	/* odwołanie trzymane przez p nie pozwala usunąć wpisu w międzyczasie,
+	   a muteks tablicy potrzebny jest dopiero przy ostatnim odwołaniu */
+	InternNode *node = FindByAddress(p->monos);
+	if (node == NULL) {
+		return false;
+	}
+	if (atomic_fetch_sub(&(node->refs), 1) == 1) {
+		pthread_mutex_lock(&intern_lock);
+		DeleteNodeLocked(node);
+		pthread_mutex_unlock(&intern_lock);
+	}
+	p->monos = NULL;
+	p->monos_count = 0;
+	p->skip = 0;
+	return true;
+}
+
+size_t PolyInternNodes() {
+	return table.nodes_count;
+}
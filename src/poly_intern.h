@@ -0,0 +1,72 @@
+/** @file
+   Interfejs internowania (hash-consingu) wielomianów
+
+   W trybie internowania wielomiany trzymane na stosie kalkulatora nie mają
+   powtarzających się poddrzew: identyczne tablice jednomianów (o tych samych
+   wykładnikach i współczynnikach) występują w pamięci raz, a drzewo staje
+   się DAG-iem. Internowane tablice są tylko do odczytu; wszystkie operacje
+   z poly.h traktują argumenty jako stałe i budują wyniki w nowej pamięci,
+   więc mogą działać na internowanych wielomianach bez zmian.
+
+   Tablica jest internowana, gdy jej współczynniki są już internowane,
+   dlatego porównanie tablic przy wyszukiwaniu jest płytkie (porównuje
+   wskaźniki do tablic współczynników), a dwa internowane wielomiany są
+   równe wtedy i tylko wtedy, gdy mają równe skalary i tę samą tablicę.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_INTERN_H__
+#define __POLY_INTERN_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+
+/** Zmienna środowiskowa włączająca internowanie wielomianów na stosie */
+#define POLY_INTERN_ENV "CALC_POLY_INTERN"
+
+/**
+ * Włącza internowanie.
+ */
+void PolyInternInit();
+
+/**
+ * Wyłącza internowanie i zwalnia tablicę internowania.
+ * Wszystkie internowane wielomiany muszą być wcześniej usunięte.
+ */
+void PolyInternDestroy();
+
+/**
+ * Sprawdza, czy internowanie jest włączone.
+ * @return Czy internowanie jest włączone?
+ */
+bool PolyInternEnabled();
+
+/**
+ * Internuje wielomian w miejscu: każda jego tablica jednomianów jest
+ * zastępowana identyczną tablicą z tablicy internowania (jeśli taka jest)
+ * albo do niej dodawana. Wielomian, który już jest internowany, zostaje bez
+ * zmian. Przy wyłączonym internowaniu nic nie robi.
+ * @param[in,out] p : wielomian
+ */
+void PolyIntern(Poly *p);
+
+/**
+ * Zwalnia odwołanie do internowanego wielomianu; tablice jednomianów,
+ * do których nie ma już odwołań, są usuwane.
+ * @param[in,out] p : wielomian
+ * @return Czy wielomian był internowany (jeśli nie, nic się nie dzieje)?
+ */
+bool PolyInternRelease(Poly *p);
+
+/**
+ * Zwraca liczbę różnych internowanych tablic jednomianów.
+ * @return liczba tablic
+ */
+size_t PolyInternNodes();
+
+#endif /* __POLY_INTERN_H__ */
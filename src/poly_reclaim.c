@@ -0,0 +1,136 @@
+/** @file
+   Implementacja odroczonego usuwania wielomianów
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "poly.h"
+#include "poly_reclaim.h"
+
+/** Kolejka wielomianów do usunięcia (bufor cykliczny) */
+typedef struct ReclaimQueue {
+	Poly *polys; ///< bufor
+	size_t size; ///< pojemność bufora
+	size_t first; ///< indeks najstarszego wielomianu
+	size_t count; ///< liczba wielomianów w kolejce
+	size_t peak; ///< największa liczba wielomianów w kolejce
+	bool running; ///< czy wątek usuwający działa
+	bool stop; ///< czy wątek ma się zakończyć po opróżnieniu kolejki
+	pthread_t thread; ///< wątek usuwający
+	pthread_mutex_t lock; ///< chroni pozostałe pola
+	pthread_cond_t not_empty; ///< sygnalizuje nowy wielomian lub zatrzymanie
+	pthread_cond_t not_full; ///< sygnalizuje zwolnienie miejsca w kolejce
+} ReclaimQueue;
+
+/** Kolejka programu */
+static ReclaimQueue queue = {
+	.polys = NULL,
+	.running = false,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.not_empty = PTHREAD_COND_INITIALIZER,
+	.not_full = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Pętla wątku usuwającego.
+ * @param[in] arg : nieużywany
+ * @return NULL
+ */
+static void *Reclaimer(void *arg) {
+	(void) arg;
+	pthread_mutex_lock(&(queue.lock));
+	while (true) {
+		while (queue.count == 0 && !queue.stop) {
+			pthread_cond_wait(&(queue.not_empty), &(queue.lock));
+		}
+		if (queue.count == 0) {
+			break;
+		}
+
+		Poly p = queue.polys[queue.first];
+		queue.first = (queue.first + 1) % queue.size;
+		queue.count--;
+		pthread_cond_signal(&(queue.not_full));
+
+		pthread_mutex_unlock(&(queue.lock));
+		PolyDestroy(&p);
+		pthread_mutex_lock(&(queue.lock));
+	}
+	pthread_mutex_unlock(&(queue.lock));
+	return NULL;
+}
+
+void PolyReclaimInit(size_t backlog) {
+	PolyReclaimDestroy();
+	if (backlog == 0) {
+		return;
+	}
+
+	queue.polys = calloc(backlog, sizeof(Poly));
+	assert(queue.polys != NULL);
+	queue.size = backlog;
+	queue.first = 0;
+	queue.count = 0;
+	queue.peak = 0;
+	queue.stop = false;
+	queue.running =
+		pthread_create(&(queue.thread), NULL, Reclaimer, NULL) == 0;
+}
+
+void PolyReclaimDestroy() {
+	if (queue.running) {
+		pthread_mutex_lock(&(queue.lock));
+		queue.stop = true;
+		pthread_cond_signal(&(queue.not_empty));
+		pthread_mutex_unlock(&(queue.lock));
+
+		pthread_join(queue.thread, NULL);
+		queue.running = false;
+	}
+	free(queue.polys);
+	queue.polys = NULL;
+}
+
+void PolyReclaim(Poly *p) {
+	/* skalary nie zajmują pamięci */
+	if (!queue.running || PolyIsCoeff(p)) {
+		PolyDestroy(p);
+		return;
+	}
+
+	pthread_mutex_lock(&(queue.lock));
+	while (queue.count == queue.size) {
+		pthread_cond_wait(&(queue.not_full), &(queue.lock));
+	}
+	queue.polys[(queue.first + queue.count) % queue.size] = *p;
+	queue.count++;
+	if (queue.count > queue.peak) {
+		queue.peak = queue.count;
+	}
+	pthread_cond_signal(&(queue.not_empty));
+	pthread_mutex_unlock(&(queue.lock));
+
+	*p = PolyZero();
+}
+
+size_t PolyReclaimPending() {
+	pthread_mutex_lock(&(queue.lock));
+	size_t count = queue.count;
+	pthread_mutex_unlock(&(queue.lock));
+	return count;
+}
+
+size_t PolyReclaimPeak() {
+	pthread_mutex_lock(&(queue.lock));
+	size_t peak = queue.peak;
+	pthread_mutex_unlock(&(queue.lock));
+	return peak;
+}
@@ -0,0 +1,57 @@
+/** @file
+   Interfejs odroczonego usuwania wielomianów
+
+   Usuwanie dużego wielomianu to przejście po całym drzewie i zwolnienie
+   każdej tablicy jednomianów. Kalkulator może przekazać zużyte wielomiany
+   do wątku w tle, który je usuwa, a sam od razu przejść do kolejnego
+   polecenia.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_RECLAIM_H__
+#define __POLY_RECLAIM_H__
+
+#include <stddef.h>
+
+#include "poly.h"
+
+/** Zmienna środowiskowa z długością kolejki wielomianów do usunięcia */
+#define POLY_RECLAIM_ENV "CALC_POLY_RECLAIM"
+
+/**
+ * Uruchamia wątek usuwający wielomiany w tle.
+ * Domyślnie (i dla @p backlog równego 0) PolyReclaim usuwa wielomian od razu.
+ * @param[in] backlog : ile wielomianów może czekać na usunięcie; gdy kolejka
+ * jest pełna, PolyReclaim czeka na zwolnienie miejsca
+ */
+void PolyReclaimInit(size_t backlog);
+
+/**
+ * Czeka na usunięcie wszystkich wielomianów z kolejki i zatrzymuje wątek.
+ */
+void PolyReclaimDestroy();
+
+/**
+ * Usuwa wielomian z pamięci, w tle, jeśli wątek usuwający działa.
+ * Przejmuje na własność zawartość @p p, której nie wolno już używać.
+ * @param[in] p : wielomian
+ */
+void PolyReclaim(Poly *p);
+
+/**
+ * Zwraca liczbę wielomianów czekających na usunięcie.
+ * @return liczba wielomianów w kolejce
+ */
+size_t PolyReclaimPending();
+
+/**
+ * Zwraca największą liczbę wielomianów, które naraz czekały na usunięcie
+ * od uruchomienia wątku usuwającego.
+ * @return największa liczba wielomianów w kolejce
+ */
+size_t PolyReclaimPeak();
+
+#endif /* __POLY_RECLAIM_H__ */
@@ -0,0 +1,97 @@
+/** @file
+   Kolejka bez blokad dla jednego producenta i jednego konsumenta
+
+   Kolejka jest buforem cyklicznym elementów jednego rozmiaru. Producent
+   przesuwa tylko koniec kolejki, a konsument tylko jej początek, więc
+   wystarczą im dwa liczniki atomowe: zapis elementu jest widoczny dla
+   konsumenta dzięki parze release/acquire na końcu kolejki, a zwolnienie
+   miejsca dla producenta – na jej początku. Strona, która musi czekać
+   (na element albo na miejsce), oddaje procesor innym wątkom.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_RING_H__
+#define __POLY_RING_H__
+
+#include <assert.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_CACHE_LINE 64 ///< rozmiar linii pamięci podręcznej (rozdziela liczniki obu stron)
+
+/** Kolejka jednego producenta i jednego konsumenta */
+typedef struct Ring {
+	char *items; ///< bufor elementów
+	size_t item_size; ///< rozmiar elementu
+	size_t mask; ///< pojemność bufora (potęga dwójki) minus 1
+	_Alignas(RING_CACHE_LINE) atomic_size_t head; ///< liczba elementów zdjętych (zmienia konsument)
+	_Alignas(RING_CACHE_LINE) atomic_size_t tail; ///< liczba elementów włożonych (zmienia producent)
+} Ring;
+
+/**
+ * Tworzy pustą kolejkę.
+ * @param[out] r : kolejka
+ * @param[in] item_size : rozmiar elementu
+ * @param[in] size : najmniejsza pojemność kolejki (zaokrąglana w górę do
+ * potęgi dwójki)
+ */
+static inline void RingInit(Ring *r, size_t item_size, size_t size) {
+	size_t capacity = 1;
+	while (capacity < size) {
+		capacity *= 2;
+	}
+	r->items = malloc(capacity * item_size);
+	assert(r->items != NULL);
+	r->item_size = item_size;
+	r->mask = capacity - 1;
+	atomic_init(&(r->head), 0);
+	atomic_init(&(r->tail), 0);
+}
+
+/**
+ * Zwalnia bufor kolejki.
+ * @param[in,out] r : kolejka
+ */
+static inline void RingFree(Ring *r) {
+	free(r->items);
+	r->items = NULL;
+}
+
+/**
+ * Wkłada element na koniec kolejki, czekając na miejsce.
+ * Wywoływana tylko przez producenta.
+ * @param[in,out] r : kolejka
+ * @param[in] item : element (kopiowany do kolejki)
+ */
+static inline void RingPush(Ring *r, const void *item) {
+	size_t tail = atomic_load_explicit(&(r->tail), memory_order_relaxed);
+	while (tail - atomic_load_explicit(&(r->head), memory_order_acquire) >
+		   r->mask) {
+		sched_yield();
+	}
+	memcpy(r->items + (tail & r->mask) * r->item_size, item, r->item_size);
+	atomic_store_explicit(&(r->tail), tail + 1, memory_order_release);
+}
+
+/**
+ * Zdejmuje element z początku kolejki, czekając na niego.
+ * Wywoływana tylko przez konsumenta.
+ * @param[in,out] r : kolejka
+ * @param[out] item : miejsce na element
+ */
+static inline void RingPop(Ring *r, void *item) {
+	size_t head = atomic_load_explicit(&(r->head), memory_order_relaxed);
+	while (atomic_load_explicit(&(r->tail), memory_order_acquire) == head) {
+		sched_yield();
+	}
+	memcpy(item, r->items + (head & r->mask) * r->item_size, r->item_size);
+	atomic_store_explicit(&(r->head), head + 1, memory_order_release);
+}
+
+#endif /* __POLY_RING_H__ */
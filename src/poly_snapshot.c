@@ -0,0 +1,468 @@
+/** @file
+   Implementacja zrzutów stosu wielomianów do pliku.
+
+   Zrzut budowany jest od razu w odwzorowanym w pamięć pliku tymczasowym,
+   a jego adres bazowy to adres tego odwzorowania. Wczytane zrzuty mają
+   liczniki odwołań (z wielomianów na stosie); dostęp do nich chroni muteks,
+   bo wielomiany usuwa też wątek usuwający w tle.
+
+   Każde PolyDestroy pyta, czy wielomian pochodzi ze zrzutu, dlatego
+   odwzorowania są posortowane według adresu (wyszukiwanie binarne),
+   a obszar od początku pierwszego do końca ostatniego jest dostępny bez
+   muteksu – wielomiany spoza niego nie blokują tablicy zrzutów.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#define _POSIX_C_SOURCE 200809L ///< umożliwia użycie 'mmap', 'pread' i 'ftruncate'
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "poly.h"
+#include "poly_snapshot.h"
+#include "work_stack.h"
+
+#define SNAPSHOT_MAGIC "POLYSNAP" ///< pierwsze bajty pliku zrzutu
+#define SNAPSHOT_BYTE_ORDER UINT32_C(0x01020304) ///< znacznik kolejności bajtów
+#define SNAPSHOT_ALIGN 16 ///< wyrównanie części zrzutu (co najmniej _Alignof(Mono))
+
+/** Zaokrągla rozmiar w górę do wielokrotności SNAPSHOT_ALIGN */
+#define SNAPSHOT_ROUND(n) (((n) + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN)
+
+/** Nagłówek pliku zrzutu */
+typedef struct SnapshotHeader {
+	char magic[8]; ///< SNAPSHOT_MAGIC
+	uint32_t byte_order; ///< SNAPSHOT_BYTE_ORDER
+	uint32_t mono_size; ///< sizeof(Mono)
+	uint64_t coeff_max; ///< młodsze 64 bity POLY_COEFF_MAX (wariant współczynników)
+	uint64_t base; ///< adres bazowy, względem którego zapisano wskaźniki
+	uint64_t polys_count; ///< liczba wielomianów stosu
+	uint64_t size; ///< rozmiar pliku
+} SnapshotHeader;
+
+/** Wczytany zrzut */
+typedef struct Snapshot {
+	char *begin; ///< początek odwzorowania
+	size_t size; ///< rozmiar odwzorowania
+	size_t refs; ///< liczba odwołań do zrzutu
+} Snapshot;
+
+static Snapshot *snapshots = NULL; ///< wczytane zrzuty, posortowane według adresu
+static size_t snapshots_count = 0; ///< liczba wczytanych zrzutów
+/** chroni tablicę zrzutów */
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+/** początek obszaru wszystkich odwzorowań (UINTPTR_MAX, gdy ich nie ma) */
+static atomic_uintptr_t mapped_begin = UINTPTR_MAX;
+/** koniec obszaru wszystkich odwzorowań (0, gdy ich nie ma) */
+static atomic_uintptr_t mapped_end = 0;
+
+/**
+ * Zwraca przesunięcie wielomianów stosu w pliku zrzutu.
+ * @return przesunięcie
+ */
+static inline size_t PolysOffset() {
+	return SNAPSHOT_ROUND(sizeof(SnapshotHeader));
+}
+
+/**
+ * Zwraca przesunięcie tablic jednomianów w pliku zrzutu.
+ * @param[in] count : liczba wielomianów stosu
+ * @return przesunięcie
+ */
+static inline size_t MonosOffset(size_t count) {
+	return SNAPSHOT_ROUND(PolysOffset() + count * sizeof(Poly));
+}
+
+/**
+ * Liczy jednomiany wszystkich tablic wielomianów.
+ * @param[in] polys : wielomiany
+ * @param[in] count : liczba wielomianów
+ * @return liczba jednomianów
+ */
+static size_t MonosTotal(const Poly polys[], size_t count) {
+	WorkStack stack = {NULL, 0, 0};
+	size_t total = 0;
+	for (size_t i = 0; i < count; i++) {
+		*(const Poly **) WorkStackPush(&stack, sizeof(Poly *)) = &(polys[i]);
+		while (stack.count > 0) {
+			const Poly *p = *(const Poly **) WorkStackPop(&stack, sizeof(Poly *));
+			total += p->monos_count;
+			for (unsigned j = 0; j < p->monos_count; j++) {
+				if (!PolyIsCoeff(&(p->monos[j].p))) {
+					*(const Poly **) WorkStackPush(&stack, sizeof(Poly *)) =
+						&(p->monos[j].p);
+				}
+			}
+		}
+	}
+	WorkStackFree(&stack);
+	return total;
+}
+
+/** Ramka iteracyjnego zapisu wielomianu */
+typedef struct SaveFrame {
+	const Poly *p; ///< zapisywane poddrzewo
+	Poly *r; ///< jego miejsce w obrazie
+} SaveFrame;
+
+/**
+ * Buduje obraz zrzutu w pamięci.
+ * @param[out] image : pamięć obrazu (adres bazowy)
+ * @param[in] size : rozmiar obrazu
+ * @param[in] polys : wielomiany
+ * @param[in] count : liczba wielomianów
+ */
+static void ImageBuild(char *image, size_t size, const Poly polys[],
+					   size_t count) {
+	SnapshotHeader *h = (SnapshotHeader *) image;
+	memcpy(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic));
+	h->byte_order = SNAPSHOT_BYTE_ORDER;
+	h->mono_size = sizeof(Mono);
+	h->coeff_max = (uint64_t) POLY_COEFF_MAX;
+	h->base = (uintptr_t) image;
+	h->polys_count = count;
+	h->size = size;
+
+	Poly *stack_polys = (Poly *) (image + PolysOffset());
+	size_t next = MonosOffset(count);
+	WorkStack stack = {NULL, 0, 0};
+	for (size_t i = 0; i < count; i++) {
+		stack_polys[i] = polys[i];
+		*(SaveFrame *) WorkStackPush(&stack, sizeof(SaveFrame)) =
+			(SaveFrame) {&(polys[i]), &(stack_polys[i])};
+		while (stack.count > 0) {
+			SaveFrame f = *(SaveFrame *) WorkStackPop(&stack, sizeof(SaveFrame));
+			if (PolyIsCoeff(f.p)) {
+				f.r->monos = NULL;
+				continue;
+			}
+
+			/* tablica trafia za wszystko, co już jest w obrazie */
+			Mono *monos = (Mono *) (image + next);
+			next += f.p->monos_count * sizeof(Mono);
+			memcpy(monos, f.p->monos, f.p->monos_count * sizeof(Mono));
+			f.r->monos = monos;
+			for (unsigned j = 0; j < f.p->monos_count; j++) {
+				*(SaveFrame *) WorkStackPush(&stack, sizeof(SaveFrame)) =
+					(SaveFrame) {&(f.p->monos[j].p), &(monos[j].p)};
+			}
+		}
+	}
+	WorkStackFree(&stack);
+	assert(next == size);
+}
+
+bool PolySnapshotSave(const char *path, const Poly polys[], size_t count) {
+	size_t size = MonosOffset(count) + MonosTotal(polys, count) * sizeof(Mono);
+
+	/* zrzut zapisujemy obok i podmieniamy plik dopiero na koniec */
+	size_t tmp_size = strlen(path) + sizeof(".tmp");
+	char *tmp = malloc(tmp_size);
+	assert(tmp != NULL);
+	snprintf(tmp, tmp_size, "%s.tmp", path);
+
+	bool ok = false;
+	int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (fd >= 0) {
+		if (ftruncate(fd, size) == 0) {
+			char *image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+							   fd, 0);
+			if (image != MAP_FAILED) {
+				ImageBuild(image, size, polys, count);
+				ok = munmap(image, size) == 0;
+			}
+		}
+		ok = close(fd) == 0 && ok;
+	}
+	ok = ok && rename(tmp, path) == 0;
+	if (!ok) {
+		unlink(tmp);
+	}
+	free(tmp);
+	return ok;
+}
+
+/**
+ * Sprawdza i przesuwa wskaźnik wielomianu w obrazie zrzutu.
+ * Tablica musi leżeć w obszarze tablic, za wielomianem @p p, dzięki czemu
+ * obraz nie może zawierać cykli. Wskaźnik pod adresem bazowym nie jest
+ * zapisywany, więc strony obrazu pozostają współdzielone z plikiem.
+ * @param[in,out] p : wielomian w obrazie
+ * @param[in] image : początek obrazu
+ * @param[in] size : rozmiar obrazu
+ * @param[in] monos_begin : przesunięcie obszaru tablic
+ * @param[in] base : adres bazowy zapisany w nagłówku
+ * @return Czy wskaźnik jest poprawny?
+ */
+static bool PolyRelocate(Poly *p, char *image, size_t size,
+						 size_t monos_begin, uintptr_t base) {
+	if (p->monos_count == 0) {
+		return p->monos == NULL;
+	}
+
+	uintptr_t offset = (uintptr_t) p->monos - base;
+	if (offset < monos_begin || offset <= (uintptr_t) ((char *) p - image) ||
+			offset >= size || (offset - monos_begin) % sizeof(Mono) != 0 ||
+			p->monos_count > (size - offset) / sizeof(Mono)) {
+		return false;
+	}
+	if ((char *) p->monos != image + offset) {
+		p->monos = (Mono *) (image + offset);
+	}
+	return true;
+}
+
+/**
+ * Sprawdza, czy tablica jednomianów jest w postaci kanonicznej: wykładniki
+ * są nieujemne i rosną, współczynniki są niezerowe, jednomian o wykładniku
+ * 0 nie ma wyrazu wolnego (należy on do wielomianu) ani nie jest jedynym
+ * jednomianem (zob. PolyCollapse).
+ * @param[in] monos : tablica jednomianów
+ * @param[in] count : długość tablicy
+ * @return Czy tablica jest w postaci kanonicznej?
+ */
+static bool MonosCanonical(const Mono *monos, unsigned count) {
+	for (unsigned i = 0; i < count; i++) {
+		const Poly *c = &(monos[i].p);
+		if (monos[i].exp < 0 || (i > 0 && monos[i].exp <= monos[i - 1].exp) ||
+				PolyIsZero(c)) {
+			return false;
+		}
+		if (monos[i].exp == 0 &&
+				(PolyIsCoeff(c) || c->scalar != 0 || count == 1)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Sprawdza obraz zrzutu i przesuwa jego wskaźniki pod adres @p image.
+ * @param[in,out] image : obraz
+ * @param[in] size : rozmiar obrazu
+ * @return Czy obraz jest poprawnym zrzutem?
+ */
+static bool ImageRelocate(char *image, size_t size) {
+	const SnapshotHeader *h = (const SnapshotHeader *) image;
+	size_t count = h->polys_count;
+	size_t monos_begin = MonosOffset(count);
+	if (monos_begin > size || (size - monos_begin) % sizeof(Mono) != 0) {
+		return false;
+	}
+
+	uintptr_t base = h->base;
+	Poly *stack_polys = (Poly *) (image + PolysOffset());
+	Mono *monos = (Mono *) (image + monos_begin);
+	size_t monos_count = (size - monos_begin) / sizeof(Mono);
+	for (size_t i = 0; i < count + monos_count; i++) {
+		Poly *p = i < count ? &(stack_polys[i]) : &(monos[i - count].p);
+		if (!PolyRelocate(p, image, size, monos_begin, base) ||
+				!MonosCanonical(p->monos, p->monos_count)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Odwzorowuje plik zrzutu w pamięć i sprawdza go.
+ * @param[in] path : ścieżka pliku
+ * @param[out] size : rozmiar odwzorowania
+ * @return początek odwzorowania albo NULL
+ */
+static char *ImageMap(const char *path, size_t *size) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	SnapshotHeader h;
+	struct stat st;
+	if (fstat(fd, &st) != 0 ||
+			pread(fd, &h, sizeof(h), 0) != (ssize_t) sizeof(h) ||
+			memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) != 0 ||
+			h.byte_order != SNAPSHOT_BYTE_ORDER ||
+			h.mono_size != sizeof(Mono) ||
+			h.coeff_max != (uint64_t) POLY_COEFF_MAX ||
+			h.size != (uint64_t) st.st_size ||
+			h.polys_count > (h.size - PolysOffset()) / sizeof(Poly)) {
+		close(fd);
+		return NULL;
+	}
+
+	/* pod adresem bazowym wskaźników nie trzeba przesuwać */
+	*size = h.size;
+	char *image = mmap((void *) (uintptr_t) h.base, *size,
+					   PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED) {
+		return NULL;
+	}
+	if (!ImageRelocate(image, *size) ||
+			mprotect(image, *size, PROT_READ) != 0) {
+		munmap(image, *size);
+		return NULL;
+	}
+	return image;
+}
+
+/**
+ * Sprawdza bez blokowania, czy tablica może pochodzić z któregoś zrzutu.
+ * Tablica, która pochodzi ze zrzutu, trzyma odwołanie do niego, więc
+ * obszar odwzorowań na pewno ją obejmuje.
+ * @param[in] monos : tablica jednomianów
+ * @return Czy tablica leży w obszarze odwzorowań?
+ */
+static inline bool InMappedRange(const Mono *monos) {
+	uintptr_t a = (uintptr_t) monos;
+	return a >= atomic_load(&mapped_begin) && a < atomic_load(&mapped_end);
+}
+
+/**
+ * Uaktualnia obszar odwzorowań (z zablokowanym `snapshot_lock`).
+ */
+static void RangeUpdateLocked() {
+	if (snapshots_count == 0) {
+		atomic_store(&mapped_begin, UINTPTR_MAX);
+		atomic_store(&mapped_end, 0);
+		return;
+	}
+	const Snapshot *last = &(snapshots[snapshots_count - 1]);
+	atomic_store(&mapped_begin, (uintptr_t) snapshots[0].begin);
+	atomic_store(&mapped_end, (uintptr_t) (last->begin + last->size));
+}
+
+/**
+ * Wyszukuje zrzut zawierający tablicę jednomianów
+ * (z zablokowanym `snapshot_lock`).
+ * @param[in] monos : tablica jednomianów
+ * @return indeks zrzutu albo `snapshots_count`
+ */
+static size_t FindLocked(const Mono *monos) {
+	/* ostatni zrzut zaczynający się nie dalej niż tablica */
+	size_t lo = 0;
+	size_t hi = snapshots_count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (snapshots[mid].begin <= (const char *) monos) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == 0 || (const char *) monos >=
+			snapshots[lo - 1].begin + snapshots[lo - 1].size) {
+		return snapshots_count;
+	}
+	return lo - 1;
+}
+
+/**
+ * Zwalnia odwołanie do zrzutu (z zablokowanym `snapshot_lock`).
+ * @param[in] i : indeks zrzutu
+ */
+static void ReleaseLocked(size_t i) {
+	if (--(snapshots[i].refs) > 0) {
+		return;
+	}
+	munmap(snapshots[i].begin, snapshots[i].size);
+	snapshots_count--;
+	memmove(&(snapshots[i]), &(snapshots[i + 1]),
+			(snapshots_count - i) * sizeof(Snapshot));
+	RangeUpdateLocked();
+	if (snapshots_count == 0) {
+		free(snapshots);
+		snapshots = NULL;
+	}
+}
+
+bool PolySnapshotLoad(const char *path, void (*emit)(Poly *p, void *data),
+					  void *data) {
+	size_t size;
+	char *image = ImageMap(path, &size);
+	if (image == NULL) {
+		return false;
+	}
+
+	/* wczytujący trzyma jedno odwołanie, aż przekaże wszystkie wielomiany */
+	pthread_mutex_lock(&snapshot_lock);
+	snapshots = realloc(snapshots, (snapshots_count + 1) * sizeof(Snapshot));
+	assert(snapshots != NULL);
+	size_t at = snapshots_count;
+	while (at > 0 && snapshots[at - 1].begin > image) {
+		snapshots[at] = snapshots[at - 1];
+		at--;
+	}
+	snapshots[at] = (Snapshot) {image, size, 1};
+	snapshots_count++;
+	RangeUpdateLocked();
+	pthread_mutex_unlock(&snapshot_lock);
+
+	const SnapshotHeader *h = (const SnapshotHeader *) image;
+	const Poly *stack_polys = (const Poly *) (image + PolysOffset());
+	for (size_t i = 0; i < h->polys_count; i++) {
+		Poly p = stack_polys[i];
+		PolySnapshotShare(&p);
+		emit(&p, data);
+	}
+
+	pthread_mutex_lock(&snapshot_lock);
+	ReleaseLocked(FindLocked((const Mono *) image));
+	pthread_mutex_unlock(&snapshot_lock);
+	return true;
+}
+
+bool PolySnapshotMapped(const Poly *p) {
+	if (PolyIsCoeff(p) || !InMappedRange(p->monos)) {
+		return false;
+	}
+	pthread_mutex_lock(&snapshot_lock);
+	bool mapped = FindLocked(p->monos) < snapshots_count;
+	pthread_mutex_unlock(&snapshot_lock);
+	return mapped;
+}
+
+bool PolySnapshotShare(const Poly *p) {
+	if (PolyIsCoeff(p) || !InMappedRange(p->monos)) {
+		return false;
+	}
+	pthread_mutex_lock(&snapshot_lock);
+	size_t i = FindLocked(p->monos);
+	bool mapped = i < snapshots_count;
+	if (mapped) {
+		snapshots[i].refs++;
+	}
+	pthread_mutex_unlock(&snapshot_lock);
+	return mapped;
+}
+
+bool PolySnapshotRelease(Poly *p) {
+	if (PolyIsCoeff(p) || !InMappedRange(p->monos)) {
+		return false;
+	}
+	pthread_mutex_lock(&snapshot_lock);
+	size_t i = FindLocked(p->monos);
+	bool mapped = i < snapshots_count;
+	if (mapped) {
+		ReleaseLocked(i);
+		p->monos = NULL;
+		p->monos_count = 0;
+		p->skip = 0;
+	}
+	pthread_mutex_unlock(&snapshot_lock);
+	return mapped;
+}
@@ -0,0 +1,79 @@
+/** @file
+   Interfejs zrzutów stosu wielomianów do pliku (komendy SAVE i LOAD)
+
+   Zrzut jest obrazem pamięci wielomianów: po nagłówku leżą wielomiany
+   stosu, a za nimi wszystkie tablice jednomianów, w takiej postaci, w jakiej
+   są w pamięci. Wskaźniki na tablice zapisane są jako adres bazowy zrzutu
+   plus przesunięcie tablicy w pliku, a tablica leży zawsze za jednomianem
+   lub wielomianem, który na nią wskazuje.
+
+   Wczytanie zrzutu to odwzorowanie pliku w pamięć (`mmap`) – najlepiej pod
+   adresem bazowym; w innym miejscu wskaźniki są przesuwane o różnicę
+   adresów. Wczytane wielomiany są tylko do odczytu, tak jak internowane
+   (zob. poly_intern.h): operacje budują wyniki w nowej pamięci, więc
+   kopiowane są dopiero fragmenty zmieniane. Odwzorowanie jest usuwane, gdy
+   zostanie usunięty ostatni wielomian, który z niego pochodzi.
+
+   Zrzut zależy od typu współczynników i układu struktur, więc można go
+   wczytać tylko w tym samym wariancie kalkulatora.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_SNAPSHOT_H__
+#define __POLY_SNAPSHOT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+
+/**
+ * Zapisuje wielomiany do pliku zrzutu. Plik jest zastępowany w całości
+ * dopiero po zapisaniu zrzutu, więc można nadpisać zrzut, z którego
+ * pochodzą wielomiany.
+ * @param[in] path : ścieżka pliku
+ * @param[in] polys : wielomiany (od spodu stosu)
+ * @param[in] count : liczba wielomianów
+ * @return Czy udało się zapisać zrzut?
+ */
+bool PolySnapshotSave(const char *path, const Poly polys[], size_t count);
+
+/**
+ * Wczytuje zrzut i przekazuje jego wielomiany (od spodu stosu) na własność
+ * funkcji @p emit. Gdy plik nie jest poprawnym zrzutem, @p emit nie jest
+ * wywoływana.
+ * @param[in] path : ścieżka pliku
+ * @param[in] emit : funkcja otrzymująca kolejne wielomiany
+ * @param[in] data : dane przekazywane do @p emit
+ * @return Czy udało się wczytać zrzut?
+ */
+bool PolySnapshotLoad(const char *path, void (*emit)(Poly *p, void *data),
+					  void *data);
+
+/**
+ * Sprawdza, czy wielomian pochodzi z wczytanego zrzutu.
+ * @param[in] p : wielomian
+ * @return Czy tablica jednomianów wielomianu leży w zrzucie?
+ */
+bool PolySnapshotMapped(const Poly *p);
+
+/**
+ * Dodaje odwołanie do zrzutu, z którego pochodzi wielomian; wielomian
+ * można wtedy skopiować płytko.
+ * @param[in] p : wielomian
+ * @return Czy wielomian pochodzi ze zrzutu (jeśli nie, nic się nie dzieje)?
+ */
+bool PolySnapshotShare(const Poly *p);
+
+/**
+ * Zwalnia odwołanie do zrzutu, z którego pochodzi wielomian; zrzut, do
+ * którego nie ma już odwołań, jest usuwany z pamięci.
+ * @param[in,out] p : wielomian
+ * @return Czy wielomian pochodził ze zrzutu (jeśli nie, nic się nie dzieje)?
+ */
+bool PolySnapshotRelease(Poly *p);
+
+#endif /* __POLY_SNAPSHOT_H__ */
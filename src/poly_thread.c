@@ -0,0 +1,167 @@
+/** @file
+   Implementacja puli wątków
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "poly_thread.h"
+
+/** Stan puli wątków */
+typedef struct ThreadPool {
+	pthread_t *threads; ///< wątki pomocnicze
+	unsigned threads_count; ///< liczba wątków pomocniczych
+	pthread_mutex_t lock; ///< chroni pozostałe pola
+	pthread_cond_t work; ///< sygnalizuje nowe zadania lub zatrzymanie
+	pthread_cond_t done; ///< sygnalizuje zakończenie wszystkich zadań
+	void (*task)(void *data, size_t n); ///< bieżąca funkcja zadań
+	void *data; ///< dane bieżących zadań
+	size_t count; ///< liczba bieżących zadań
+	size_t next; ///< numer następnego nieprzydzielonego zadania
+	size_t finished; ///< liczba zakończonych zadań
+	bool busy; ///< czy trwa wykonywanie zadań
+	bool stop; ///< czy wątki mają się zakończyć
+} ThreadPool;
+
+/** Pula wątków programu */
+static ThreadPool pool = {
+	.threads = NULL,
+	.threads_count = 0,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+};
+
+/** Czy bieżący wątek wykonuje właśnie zadanie z puli */
+static _Thread_local bool inside_task = false;
+
+/**
+ * Wykonuje kolejne nieprzydzielone zadania, dopóki takie są.
+ * Wywoływana z zablokowanym `pool.lock`, kończy z zablokowanym.
+ */
+static void TakeTasks() {
+	while (pool.next < pool.count) {
+		size_t n = pool.next++;
+		pthread_mutex_unlock(&(pool.lock));
+
+		inside_task = true;
+		pool.task(pool.data, n);
+		inside_task = false;
+
+		pthread_mutex_lock(&(pool.lock));
+		pool.finished++;
+		if (pool.finished == pool.count) {
+			pthread_cond_signal(&(pool.done));
+		}
+	}
+}
+
+/**
+ * Pętla wątku pomocniczego.
+ * @param[in] arg : nieużywany
+ * @return NULL
+ */
+static void *Worker(void *arg) {
+	(void) arg;
+	pthread_mutex_lock(&(pool.lock));
+	while (!pool.stop) {
+		TakeTasks();
+		pthread_cond_wait(&(pool.work), &(pool.lock));
+	}
+	pthread_mutex_unlock(&(pool.lock));
+	return NULL;
+}
+
+void PolyThreadsInit(unsigned count) {
+	PolyThreadsDestroy();
+	if (count > POLY_THREADS_MAX) {
+		count = POLY_THREADS_MAX;
+	}
+	if (count <= 1) {
+		return;
+	}
+
+	pool.threads = malloc((count - 1) * sizeof(pthread_t));
+	assert(pool.threads != NULL);
+	pool.stop = false;
+	for (unsigned i = 0; i < count - 1; i++) {
+		if (pthread_create(&(pool.threads[i]), NULL, Worker, NULL) != 0) {
+			/* działamy z tyloma wątkami, ile udało się utworzyć */
+			break;
+		}
+		pool.threads_count++;
+	}
+}
+
+void PolyThreadsDestroy() {
+	pthread_mutex_lock(&(pool.lock));
+	pool.stop = true;
+	pthread_cond_broadcast(&(pool.work));
+	pthread_mutex_unlock(&(pool.lock));
+
+	for (unsigned i = 0; i < pool.threads_count; i++) {
+		pthread_join(pool.threads[i], NULL);
+	}
+	free(pool.threads);
+	pool.threads = NULL;
+	pool.threads_count = 0;
+}
+
+unsigned PolyThreadsCount() {
+	return pool.threads_count + 1;
+}
+
+bool PolyThreadsAvailable() {
+	if (pool.threads_count == 0 || inside_task) {
+		return false;
+	}
+	pthread_mutex_lock(&(pool.lock));
+	bool busy = pool.busy;
+	pthread_mutex_unlock(&(pool.lock));
+	return !busy;
+}
+
+void PolyThreadsRun(void (*task)(void *data, size_t n), void *data,
+					size_t count) {
+	bool parallel = false;
+	if (count > 1 && pool.threads_count > 0 && !inside_task) {
+		pthread_mutex_lock(&(pool.lock));
+		/* pula jest zajęta przez inny wątek – liczymy sami */
+		if (!pool.busy) {
+			pool.busy = true;
+			parallel = true;
+		} else {
+			pthread_mutex_unlock(&(pool.lock));
+		}
+	}
+
+	if (!parallel) {
+		for (size_t n = 0; n < count; n++) {
+			task(data, n);
+		}
+		return;
+	}
+
+	pool.task = task;
+	pool.data = data;
+	pool.count = count;
+	pool.next = 0;
+	pool.finished = 0;
+	pthread_cond_broadcast(&(pool.work));
+
+	TakeTasks();
+	while (pool.finished < pool.count) {
+		pthread_cond_wait(&(pool.done), &(pool.lock));
+	}
+
+	pool.count = 0;
+	pool.busy = false;
+	pthread_mutex_unlock(&(pool.lock));
+}
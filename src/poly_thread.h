@@ -0,0 +1,62 @@
+/** @file
+   Interfejs puli wątków dla równoległych operacji na wielomianach
+
+   Pula wykonuje zbiory niezależnych zadań ponumerowanych od 0. Każde
+   zadanie zapisuje swój wynik w osobnym miejscu, więc wynik nie zależy
+   od przydziału zadań do wątków ani od ich liczby.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_THREAD_H__
+#define __POLY_THREAD_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Zmienna środowiskowa z liczbą wątków obliczeniowych */
+#define POLY_THREADS_ENV "CALC_POLY_THREADS"
+
+/** Największa obsługiwana liczba wątków */
+#define POLY_THREADS_MAX 256
+
+/**
+ * Uruchamia pulę wątków.
+ * Domyślnie (i dla @p count równego 1) wszystkie zadania wykonuje wątek
+ * wywołujący, po kolei.
+ * @param[in] count : łączna liczba wątków, razem z wątkiem wywołującym
+ */
+void PolyThreadsInit(unsigned count);
+
+/**
+ * Zatrzymuje pulę wątków.
+ */
+void PolyThreadsDestroy();
+
+/**
+ * Zwraca liczbę wątków, które mogą wykonywać zadania.
+ * @return liczba wątków (co najmniej 1)
+ */
+unsigned PolyThreadsCount();
+
+/**
+ * Sprawdza, czy opłaca się dzielić pracę na zadania, tzn. czy pula działa
+ * i nie jest zajęta (np. przez zadanie, z którego nas wywołano).
+ * @return Czy PolyThreadsRun wykona zadania równolegle?
+ */
+bool PolyThreadsAvailable();
+
+/**
+ * Wykonuje zadania `task(data, 0)`, ..., `task(data, count - 1)`
+ * i czeka na zakończenie wszystkich.
+ * Zadania wywołane z wnętrza innego zadania wykonywane są sekwencyjnie.
+ * @param[in] task : funkcja wykonująca zadanie o podanym numerze
+ * @param[in] data : dane wspólne dla zadań
+ * @param[in] count : liczba zadań
+ */
+void PolyThreadsRun(void (*task)(void *data, size_t n), void *data,
+					size_t count);
+
+#endif /* __POLY_THREAD_H__ */
@@ -0,0 +1,131 @@
+/** @file
+   Binarny format wejścia i wyjścia kalkulatora (tryb `--binary`)
+
+   Wejście i wyjście są ciągami ramek. Ramka to długość treści (varint),
+   po której następuje treść.
+
+   Treść ramki wejściowej zaczyna się kodem operacji (varint, wire_op_e).
+   Po WIRE_POLY następuje wielomian do odłożenia na stos, po WIRE_DEG_BY
+   i WIRE_COMPOSE argument (varint), a po WIRE_AT argument (zigzag).
+   Argumentem WIRE_SAVE i WIRE_LOAD jest ścieżka pliku – reszta ramki.
+   Pozostałe operacje nie mają argumentów.
+
+   Treść ramki wyjściowej zaczyna się znacznikiem (varint, wire_reply_e):
+   po WIRE_REPLY_POLY następuje wielomian (PRINT, MUL_PRINT), a po
+   WIRE_REPLY_INT liczba (zigzag), czyli stopień albo wartość logiczna.
+
+   Wielomian zapisany jest w porządku pre-order, tak jak w formacie
+   tekstowym:
+   - stała to 0, a po nim współczynnik (zigzag),
+   - suma jednomianów to dla każdego jednomianu jego wykładnik powiększony
+     o 1 (varint) i współczynnik jednomianu (wielomian), a na końcu 0.
+
+   Na przykład wielomian `(1,2)+((3,0)+(4,1),5)` ma postać
+   `3 0 2 6 1 0 6 2 0 8 0 0`.
+
+   Liczba varint zapisana jest po 7 bitów na bajt, od najmłodszych;
+   najstarszy bit bajtu oznacza, że liczba ma kolejne bajty. Liczba zigzag
+   to varint @f$2n@f$ dla @f$n \geq 0@f$ i @f$-2n-1@f$ dla @f$n < 0@f$.
+
+   Błędy wypisywane są na stderr tak jak w trybie tekstowym. Numer wiersza
+   jest numerem ramki, a kolumna liczbą przeczytanych bajtów jej treści.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __POLY_WIRE_H__
+#define __POLY_WIRE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poly_coeff.h"
+
+/** Opcja wiersza poleceń włączająca tryb binarny */
+#define POLY_WIRE_OPTION "--binary"
+
+#define WIRE_VARINT_MAX_BYTES 19 ///< maksymalna długość zapisanej liczby (także __int128)
+
+/** Kody operacji w ramkach wejściowych */
+enum wire_op_e {
+	WIRE_POLY = 0,
+	WIRE_ZERO = 1,
+	WIRE_IS_COEFF = 2,
+	WIRE_IS_ZERO = 3,
+	WIRE_CLONE = 4,
+	WIRE_ADD = 5,
+	WIRE_MUL = 6,
+	WIRE_NEG = 7,
+	WIRE_SUB = 8,
+	WIRE_IS_EQ = 9,
+	WIRE_DEG = 10,
+	WIRE_DEG_BY = 11,
+	WIRE_AT = 12,
+	WIRE_PRINT = 13,
+	WIRE_POP = 14,
+	WIRE_COMPOSE = 15,
+	WIRE_MUL_PRINT = 16,
+	WIRE_SAVE = 17,
+	WIRE_LOAD = 18
+};
+
+/** Znaczniki ramek wyjściowych */
+enum wire_reply_e {
+	WIRE_REPLY_POLY = 0,
+	WIRE_REPLY_INT = 1
+};
+
+/**
+ * Zapisuje liczbę jako varint.
+ * @param[in] v : liczba
+ * @param[out] buf : bufor na co najmniej WIRE_VARINT_MAX_BYTES bajtów
+ * @return liczba zapisanych bajtów
+ */
+static inline size_t WireVarintEncode(uint64_t v, unsigned char buf[]) {
+	size_t n = 0;
+	while (v >= 0x80) {
+		buf[n++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = (unsigned char) v;
+	return n;
+}
+
+/**
+ * Zapisuje współczynnik jako zigzag.
+ * @param[in] c : współczynnik
+ * @param[out] buf : bufor na co najmniej WIRE_VARINT_MAX_BYTES bajtów
+ * @return liczba zapisanych bajtów
+ */
+static inline size_t WireCoeffEncode(poly_coeff_t c, unsigned char buf[]) {
+	poly_ucoeff_t v = ((poly_ucoeff_t) c << 1) ^ (c < 0 ? ~(poly_ucoeff_t) 0 : 0);
+	size_t n = 0;
+	while (v >= 0x80) {
+		buf[n++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = (unsigned char) v;
+	return n;
+}
+
+/**
+ * Zamienia liczbę ze znakiem na wartość zigzag.
+ * @param[in] n : liczba
+ * @return wartość zigzag
+ */
+static inline uint64_t WireZigzagEncode(int64_t n) {
+	return ((uint64_t) n << 1) ^ (n < 0 ? ~(uint64_t) 0 : 0);
+}
+
+/**
+ * Odczytuje liczbę ze znakiem z wartości zigzag.
+ * @param[in] v : wartość zigzag
+ * @return liczba
+ */
+static inline int64_t WireZigzagDecode(uint64_t v) {
+	return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+#endif /* __POLY_WIRE_H__ */
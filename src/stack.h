@@ -14,6 +14,7 @@
 #include <stdlib.h>
 
 #include "poly.h"
+#include "poly_intern.h"
 
 #define STACK_SIZE 65536 ///< Początkowy rozmiar stosu
 
@@ -60,8 +61,22 @@ static inline void GrowStack(Stack *s) {
 	assert(s->elements != NULL);
 }
 
+/**
+ * Powiększa pojemność stosu do co najmniej `size` elementów.
+ * @param[in] s : stos
+ * @param[in] size : potrzebna pojemność
+ */
+static inline void StackReserve(Stack *s, size_t size) {
+	if (s->size < size) {
+		s->size = size;
+		s->elements = (Poly *) realloc(s->elements, s->size * sizeof(Poly));
+		assert(s->elements != NULL);
+	}
+}
+
 /**
  * Wrzuca wielomian na stos.
+ * W trybie internowania wielomian jest najpierw internowany.
  * @param[in] s : stos
  * @param[in] p : wielomian do wrzucenia na stos
  */
@@ -69,6 +84,7 @@ static inline void Push(Stack *s, Poly *p) {
 	if (s->element_count == s->size) {
 		GrowStack(s);
 	}
+	PolyIntern(p);
 	s->elements[s->element_count] = *p;
 	s->element_count++;
 }
@@ -18,13 +18,26 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <setjmp.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
 
 #include "cmocka.h"
 
+#include "calc.h"
 #include "poly.h"
+#include "poly_cache.h"
+#include "poly_flat.h"
+#include "poly_intern.h"
+#include "poly_reclaim.h"
+#include "poly_snapshot.h"
+#include "poly_thread.h"
+#include "poly_wire.h"
 
 /**
   * oblicza wielkość tablicy w jednostce rozmiaru pojedynczego elementu zamiast w bajtach
@@ -149,6 +162,899 @@ static void test_poly_x_compose_x(void **state) {
 }
 
 
+/* * * TESTY FUNKCJI PolyMul * * */
+
+
+/**
+ * Pomocnicza funkcja, tworzy wielomian c * x0^e
+ * @param[in] c : współczynnik
+ * @param[in] e : wykładnik
+ */
+Poly poly_cx0(poly_coeff_t c, poly_exp_t e) {
+	Poly mp = PolyFromCoeff(c);
+	Mono m = MonoFromPoly(&mp, e);
+	return PolyAddMonos(1, &m);
+}
+
+/** Test: (x0 + x0^2)^2 – serie iloczynów zachodzą na siebie */
+static void test_mul_merges_runs(void **state) {
+	(void) state;
+
+	Poly a = poly_cx0(1, 1);
+	Poly b = poly_cx0(1, 2);
+	Poly p = PolyAdd(&a, &b);
+	Poly r = PolyMul(&p, &p);
+
+	assert_int_equal(r.monos_count, 3);
+	assert_int_equal(r.monos[0].exp, 2);
+	assert_int_equal(r.monos[0].p.scalar, 1);
+	assert_int_equal(r.monos[1].exp, 3);
+	assert_int_equal(r.monos[1].p.scalar, 2);
+	assert_int_equal(r.monos[2].exp, 4);
+	assert_int_equal(r.monos[2].p.scalar, 1);
+
+	PolyDestroy(&a);
+	PolyDestroy(&b);
+	PolyDestroy(&p);
+	PolyDestroy(&r);
+}
+
+
+/** Test: (x0 + 1)(x0 - 1) – wyrazy się znoszą */
+static void test_mul_cancels_terms(void **state) {
+	(void) state;
+
+	Poly x = poly_cx0(1, 1);
+	Poly one = PolyFromCoeff(1);
+	Poly p = PolyAdd(&x, &one);
+	Poly q = PolySub(&x, &one);
+	Poly r = PolyMul(&p, &q);
+
+	Poly x2 = poly_cx0(1, 2);
+	Poly expected = PolySub(&x2, &one);
+	assert_true(PolyIsEq(&r, &expected));
+
+	PolyDestroy(&x);
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&r);
+	PolyDestroy(&x2);
+	PolyDestroy(&expected);
+}
+
+/** Test: mnożenie przez jednomian przesuwa wykładniki */
+static void test_mul_by_mono(void **state) {
+	(void) state;
+
+	Poly m = poly_cx0(3, 2);
+	Poly a = poly_cx0(1, 1);
+	Poly one = PolyFromCoeff(2);
+	Poly p = PolyAdd(&a, &one);
+	Poly r = PolyMul(&m, &p);
+
+	assert_int_equal(r.scalar, 0);
+	assert_int_equal(r.monos_count, 2);
+	assert_int_equal(r.monos[0].exp, 2);
+	assert_int_equal(r.monos[0].p.scalar, 6);
+	assert_int_equal(r.monos[1].exp, 3);
+	assert_int_equal(r.monos[1].p.scalar, 3);
+
+	PolyDestroy(&m);
+	PolyDestroy(&a);
+	PolyDestroy(&p);
+	PolyDestroy(&r);
+}
+
+/**
+ * Pomocnicza funkcja, sprawdza PolyPow z iloczynem @p e kopii wielomianu.
+ * @param[in] p : wielomian
+ * @param[in] e : wykładnik
+ */
+static void check_pow(const Poly *p, poly_exp_t e) {
+	Poly expected = PolyFromCoeff(1);
+	for (poly_exp_t k = 0; k < e; k++) {
+		Poly next = PolyMul(&expected, p);
+		PolyDestroy(&expected);
+		expected = next;
+	}
+	Poly r = PolyPow(p, e);
+	assert_true(PolyIsEq(&r, &expected));
+	PolyDestroy(&r);
+	PolyDestroy(&expected);
+}
+
+/** Test: (x0 + 1)^e oraz ((x1 + 1) x0 + (x1 + 2) x0^2)^e – małe potęgi
+ * dwumianu liczone są ze wzoru Newtona, a duże przez podnoszenie do kwadratu */
+static void test_pow_binomial(void **state) {
+	(void) state;
+
+	Poly x0 = poly_cx0(1, 1);
+	Poly one = PolyFromCoeff(1);
+	Poly p = PolyAdd(&x0, &one);
+	check_pow(&p, 2);
+	check_pow(&p, 37);
+
+	Mono monos[2];
+	for (int i = 0; i < 2; i++) {
+		Poly c = PolyFromCoeff(i + 1);
+		Poly coeff = PolyAdd(&x0, &c);
+		monos[i] = MonoFromPoly(&coeff, i + 1);
+	}
+	Poly q = PolyAddMonos(2, monos);
+	check_pow(&q, 8);
+	check_pow(&q, 24);
+
+	PolyDestroy(&x0);
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+}
+
+
+/* * * TESTY PAMIĘCI PODRĘCZNEJ * * */
+
+
+/** Test: powtórzone mnożenie trafia w pamięć podręczną */
+static void test_cache_hit(void **state) {
+	(void) state;
+
+	PolyCacheInit(1 << 20);
+	Poly a = poly_cx0(2, 1);
+	Poly one = PolyFromCoeff(1);
+	Poly p = PolyAdd(&a, &one);
+	Poly q = PolySub(&a, &one);
+
+	Poly r1 = PolyMulCached(&p, &q);
+	Poly r2 = PolyMulCached(&p, &q);
+	assert_int_equal(PolyCacheMisses(), 1);
+	assert_int_equal(PolyCacheHits(), 1);
+	assert_true(PolyIsEq(&r1, &r2));
+
+	/* trafienie nie kopiuje wyniku, tylko go współdzieli */
+	assert_true(r1.monos == r2.monos);
+	assert_true(PolyCacheShared(&r1));
+
+	/* współdzielone wyniki przeżywają usunięcie wpisów */
+	PolyCacheDestroy();
+	assert_false(PolyCacheEnabled());
+	assert_true(PolyCacheShared(&r2));
+	Poly expected = PolyMul(&p, &q);
+	assert_true(PolyIsEq(&r2, &expected));
+	PolyDestroy(&expected);
+	PolyDestroy(&a);
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&r1);
+	PolyDestroy(&r2);
+}
+
+/** Test: wpisy są usuwane po przekroczeniu limitu pamięci */
+static void test_cache_budget(void **state) {
+	(void) state;
+
+	PolyCacheInit(1024);
+	Poly one = PolyFromCoeff(1);
+	for (poly_exp_t e = 1; e <= 32; e++) {
+		Poly a = poly_cx0(1, e);
+		Poly p = PolyAdd(&a, &one);
+		Poly r = PolyMulCached(&p, &p);
+		assert_true(PolyCacheBytes() <= 1024);
+		PolyDestroy(&a);
+		PolyDestroy(&p);
+		PolyDestroy(&r);
+	}
+	assert_int_equal(PolyCacheMisses(), 32);
+	PolyCacheDestroy();
+}
+
+
+/* * * TESTY PŁASKIEJ REPREZENTACJI * * */
+
+
+/** Test: konwersja tam i z powrotem oraz mnożenie (x0 + x1 + 1)^2 */
+static void test_flat_mul(void **state) {
+	(void) state;
+
+	Poly x0 = poly_cx0(1, 1);
+	Poly c = poly_cx0(1, 1);
+	Mono m = MonoFromPoly(&c, 0);
+	Poly x1 = PolyAddMonos(1, &m);
+	Poly one = PolyFromCoeff(1);
+	Poly s = PolyAdd(&x0, &x1);
+	Poly p = PolyAdd(&s, &one);
+
+	FlatLayout layout;
+	assert_true(FlatLayoutFit(PolyVarsCount(&p), 2 * PolyMaxExp(&p), &layout));
+	FlatPoly f = PolyToFlat(&p, layout);
+	assert_int_equal(f.count, 3);
+
+	Poly back = FlatToPoly(&f);
+	assert_true(PolyIsEq(&back, &p));
+
+	FlatPoly f2;
+	assert_true(FlatMul(&f, &f, &f2));
+	assert_int_equal(f2.count, 6);
+	Poly r = FlatToPoly(&f2);
+	Poly expected = PolyMul(&p, &p);
+	assert_true(PolyIsEq(&r, &expected));
+
+	FlatDestroy(&f);
+	FlatDestroy(&f2);
+	PolyDestroy(&x0);
+	PolyDestroy(&x1);
+	PolyDestroy(&s);
+	PolyDestroy(&p);
+	PolyDestroy(&back);
+	PolyDestroy(&r);
+	PolyDestroy(&expected);
+}
+
+/**
+ * Zwraca wielomian sum_{i < n} (x1 + i) x0^i.
+ * @param[in] n : liczba jednomianów
+ * @return wielomian
+ */
+Poly poly_rows(int n) {
+	Mono *monos = calloc(n, sizeof(Mono));
+	for (int i = 0; i < n; i++) {
+		Poly x1 = poly_cx0(1, 1);
+		Poly c = PolyFromCoeff(i);
+		Poly coeff = PolyAdd(&x1, &c);
+		PolyDestroy(&x1);
+		monos[i] = MonoFromPoly(&coeff, i);
+	}
+	Poly p = PolyAddMonos(n, monos);
+	free(monos);
+	return p;
+}
+
+/** Test: mnożenie w kilku wątkach daje ten sam wynik co w jednym */
+static void test_mul_parallel(void **state) {
+	(void) state;
+
+	Poly p = poly_rows(40);
+	Poly q = poly_rows(25);
+	Poly expected = PolyMul(&p, &q);
+
+	PolyThreadsInit(4);
+	assert_int_equal(PolyThreadsCount(), 4);
+	Poly r = PolyMul(&p, &q);
+	PolyThreadsDestroy();
+	assert_int_equal(PolyThreadsCount(), 1);
+
+	assert_true(PolyIsEq(&r, &expected));
+
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&expected);
+	PolyDestroy(&r);
+}
+
+/** Test: złożenie w kilku wątkach daje ten sam wynik co w jednym */
+static void test_compose_parallel(void **state) {
+	(void) state;
+
+	Poly p = poly_rows(12);
+	Poly x[2] = {poly_rows(3), poly_cx0(2, 1)};
+	Poly expected = PolyCompose(&p, 2, x);
+
+	PolyThreadsInit(3);
+	Poly r = PolyCompose(&p, 2, x);
+	PolyThreadsDestroy();
+
+	assert_true(PolyIsEq(&r, &expected));
+
+	PolyDestroy(&p);
+	PolyDestroy(&(x[0]));
+	PolyDestroy(&(x[1]));
+	PolyDestroy(&expected);
+	PolyDestroy(&r);
+}
+
+/** Test: dodawanie dużych wielomianów w kilku wątkach */
+static void test_add_parallel(void **state) {
+	(void) state;
+
+	Poly p = poly_rows(3000);
+	Poly q = poly_rows(2000);
+	Poly nq = PolyNeg(&q);
+	Poly x = poly_cx0(1, 2500);
+	Poly s = PolyAdd(&nq, &x);
+	Poly expected = PolyAdd(&p, &s);
+
+	PolyThreadsInit(3);
+	Poly r = PolyAdd(&p, &s);
+	PolyThreadsDestroy();
+
+	assert_int_equal(r.monos_count, 1000);
+	assert_true(PolyIsEq(&r, &expected));
+
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&nq);
+	PolyDestroy(&x);
+	PolyDestroy(&s);
+	PolyDestroy(&expected);
+	PolyDestroy(&r);
+}
+
+/** Test: CLONE, IS_EQ i POP szerokich wielomianów i poddrzew w kilku wątkach */
+static void test_traversal_parallel(void **state) {
+	(void) state;
+
+	Poly p = poly_rows(2000);
+	Poly x = poly_cx0(1, 1999);
+	Poly q = PolyAdd(&p, &x);
+
+	PolyThreadsInit(3);
+	Poly r = PolyClone(&p);
+	assert_true(PolyIsEq(&r, &p));
+	assert_false(PolyIsEq(&q, &p));
+	PolyDestroy(&r);
+	PolyDestroy(&q);
+
+	/* wąski węzeł z szerokimi współczynnikami też jest dzielony */
+	Mono monos[3];
+	for (int i = 0; i < 3; i++) {
+		Poly c = poly_rows(600 + i);
+		monos[i] = MonoFromPoly(&c, i + 1);
+	}
+	Poly w = PolyAddMonos(3, monos);
+	Poly wc = PolyClone(&w);
+	assert_true(PolyIsEq(&wc, &w));
+	PolyDestroy(&(wc.monos[2].p));
+	wc.monos[2].p = poly_rows(601);
+	assert_false(PolyIsEq(&wc, &w));
+	PolyDestroy(&wc);
+	PolyDestroy(&w);
+	PolyThreadsDestroy();
+
+	PolyDestroy(&p);
+	PolyDestroy(&x);
+}
+
+/** Test: usuwanie w tle przy kolejce krótszej niż liczba wielomianów */
+static void test_reclaim(void **state) {
+	(void) state;
+
+	/* internowane tablice liczy tablica internowania, więc widać, czy
+	   wątek usuwający zwolnił wszystkie */
+	PolyInternInit();
+	PolyReclaimInit(2);
+	for (int i = 1; i <= 10; i++) {
+		Poly p = poly_rows(10 * i);
+		if (i % 2 == 0) {
+			PolyIntern(&p);
+		}
+		PolyReclaim(&p);
+		assert_true(PolyIsZero(&p));
+		assert_true(PolyReclaimPending() <= 2);
+	}
+	Poly c = PolyFromCoeff(5);
+	PolyReclaim(&c);
+	PolyReclaimDestroy();
+
+	assert_int_equal(PolyReclaimPending(), 0);
+	assert_true(PolyReclaimPeak() >= 1);
+	assert_true(PolyReclaimPeak() <= 2);
+	assert_int_equal(PolyInternNodes(), 0);
+	PolyInternDestroy();
+}
+
+/** Test: identyczne wielomiany po internowaniu dzielą tablice jednomianów */
+static void test_intern(void **state) {
+	(void) state;
+
+	PolyInternInit();
+	Poly p = poly_rows(50);
+	Poly q = PolyClone(&p);
+	PolyIntern(&p);
+	size_t nodes = PolyInternNodes();
+	PolyIntern(&q);
+	assert_int_equal(PolyInternNodes(), nodes);
+	assert_true(p.monos == q.monos);
+	assert_true(PolyIsEq(&p, &q));
+
+	Poly r = PolyMul(&p, &q);
+	PolyIntern(&r);
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	assert_true(PolyInternNodes() > 0);
+	PolyDestroy(&r);
+	assert_int_equal(PolyInternNodes(), 0);
+	PolyInternDestroy();
+}
+
+/**
+ * Pomocnicza funkcja, tworzy wielomian c * x_var^e zagnieżdżając jednomiany
+ * o wykładniku 0
+ * @param[in] c : współczynnik
+ * @param[in] var : indeks zmiennej
+ * @param[in] e : wykładnik
+ */
+Poly poly_cxn(poly_coeff_t c, unsigned var, poly_exp_t e) {
+	Poly p = poly_cx0(c, e);
+	for (unsigned i = 0; i < var; i++) {
+		Mono m = MonoFromPoly(&p, 0);
+		p = PolyAddMonos(1, &m);
+	}
+	return p;
+}
+
+/** Test: x100 zajmuje jeden węzeł, działania dopasowują pominięte zmienne */
+static void test_skip_levels(void **state) {
+	(void) state;
+
+	Poly p = poly_cxn(2, 100, 3);
+	assert_int_equal(p.skip, 100);
+	assert_int_equal(p.monos_count, 1);
+	assert_true(PolyIsCoeff(&(p.monos[0].p)));
+	assert_int_equal(PolyDegBy(&p, 99), 0);
+	assert_int_equal(PolyDegBy(&p, 100), 3);
+	assert_int_equal(PolyDeg(&p), 3);
+
+	/* (x100 + x40) - x40 wraca do jednego węzła */
+	Poly q = poly_cxn(1, 40, 1);
+	Poly s = PolyAdd(&p, &q);
+	assert_int_equal(s.skip, 40);
+	Poly d = PolySub(&s, &q);
+	assert_int_equal(d.skip, 100);
+	assert_true(PolyIsEq(&d, &p));
+
+	/* x100 * x40 = x40 * x100 */
+	Poly pq = PolyMul(&p, &q);
+	Poly qp = PolyMul(&q, &p);
+	assert_true(PolyIsEq(&pq, &qp));
+	assert_int_equal(PolyDegBy(&pq, 40), 1);
+	assert_int_equal(PolyDegBy(&pq, 100), 3);
+
+	/* PolyAt przesuwa indeksy zmiennych */
+	Poly a = PolyAt(&p, 7);
+	Poly expected = poly_cxn(2, 99, 3);
+	assert_true(PolyIsEq(&a, &expected));
+
+	Poly x[101];
+	for (unsigned i = 0; i < 101; i++) {
+		x[i] = PolyFromCoeff(2);
+	}
+	Poly c = PolyCompose(&p, 100, x);
+	assert_true(PolyIsZero(&c));
+	c = PolyCompose(&p, 101, x);
+	assert_true(PolyIsCoeff(&c) && c.scalar == 16);
+
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&s);
+	PolyDestroy(&d);
+	PolyDestroy(&pq);
+	PolyDestroy(&qp);
+	PolyDestroy(&a);
+	PolyDestroy(&expected);
+}
+
+#define DEEP_NESTING_LEVELS 100000 ///< głębokość wielomianu w test_deep_nesting
+#define DEEP_NESTING_STACK (256 * 1024) ///< stos wątku w test_deep_nesting
+
+/** Wyniki działań na głębokim wielomianie */
+typedef struct DeepNestingResult {
+	poly_exp_t deg_last; ///< stopień sumy ze względu na ostatnią zmienną
+	poly_exp_t deg_after; ///< stopień sumy ze względu na zmienną za ostatnią
+	bool shared; ///< czy po internowaniu kopia dzieli tablice z oryginałem
+	poly_exp_t deg; ///< stopień sumy
+	bool commutes; ///< czy suma nie zależy od kolejności składników
+	bool cancels; ///< czy różnica wielomianu i kopii jest zerem
+	poly_exp_t deg_at; ///< stopień wielomianu po podstawieniu pod x0
+} DeepNestingResult;
+
+/**
+ * Buduje wielomian x0 x1 ... x(n-1), kopiuje go (przy włączonym
+ * internowaniu internuje oba), dodaje, odejmuje, porównuje, podstawia
+ * pod x0 i usuwa.
+ * @param[out] arg : wyniki (DeepNestingResult)
+ * @return NULL
+ */
+static void *deep_nesting_ops(void *arg) {
+	DeepNestingResult *result = arg;
+	Poly p = PolyFromCoeff(1);
+	for (unsigned i = 0; i < DEEP_NESTING_LEVELS; i++) {
+		Mono m = MonoFromPoly(&p, 1);
+		p = PolyAddMonos(1, &m);
+	}
+
+	Poly q = PolyClone(&p);
+	PolyIntern(&p);
+	PolyIntern(&q);
+	result->shared = p.monos == q.monos;
+	Poly s = PolyAdd(&p, &q);
+	result->deg_last = PolyDegBy(&s, DEEP_NESTING_LEVELS - 1);
+	result->deg_after = PolyDegBy(&s, DEEP_NESTING_LEVELS);
+	result->deg = PolyDeg(&s);
+
+	Poly d = PolyAdd(&q, &p);
+	result->commutes = PolyIsEq(&s, &d);
+	Poly z = PolySub(&p, &q);
+	result->cancels = PolyIsZero(&z);
+	Poly a = PolyAt(&p, 2);
+	result->deg_at = PolyDeg(&a);
+
+	PolyDestroy(&p);
+	PolyDestroy(&q);
+	PolyDestroy(&s);
+	PolyDestroy(&d);
+	PolyDestroy(&z);
+	PolyDestroy(&a);
+	return NULL;
+}
+
+/** Test: przejścia głębokiego wielomianu mieszczą się w małym stosie wątku */
+static void test_deep_nesting(void **state) {
+	(void) state;
+
+	for (int intern = 0; intern <= 1; intern++) {
+		if (intern) {
+			PolyInternInit();
+		}
+		pthread_attr_t attr;
+		pthread_attr_init(&attr);
+		pthread_attr_setstacksize(&attr, DEEP_NESTING_STACK);
+		pthread_t thread;
+		DeepNestingResult result;
+		assert_int_equal(pthread_create(&thread, &attr, deep_nesting_ops,
+										&result), 0);
+		pthread_join(thread, NULL);
+		pthread_attr_destroy(&attr);
+
+		assert_int_equal(result.deg_last, 1);
+		assert_int_equal(result.deg_after, 0);
+		assert_int_equal(result.shared, intern);
+		assert_int_equal(result.deg, DEEP_NESTING_LEVELS);
+		assert_true(result.commutes);
+		assert_true(result.cancels);
+		assert_int_equal(result.deg_at, DEEP_NESTING_LEVELS - 1);
+		if (intern) {
+			assert_int_equal(PolyInternNodes(), 0);
+			PolyInternDestroy();
+		}
+	}
+}
+
+/** Wielomiany wczytane ze zrzutu w teście */
+typedef struct LoadedPolys {
+	Poly polys[4]; ///< wielomiany
+	size_t count; ///< liczba wielomianów
+} LoadedPolys;
+
+/**
+ * Pomocnicza funkcja, zbiera wielomiany wczytane ze zrzutu.
+ * @param[in] p : wielomian
+ * @param[in] data : zebrane wielomiany (LoadedPolys)
+ */
+static void snapshot_collect(Poly *p, void *data) {
+	LoadedPolys *loaded = data;
+	assert_true(loaded->count < array_length(loaded->polys));
+	loaded->polys[loaded->count++] = *p;
+}
+
+/** Test: zrzut odtwarza wielomiany, z których można dalej liczyć */
+static void test_snapshot(void **state) {
+	(void) state;
+
+	const char *path = "unit_tests_poly.snapshot";
+	Poly polys[3] = {poly_rows(20), PolyFromCoeff(7), poly_cxn(3, 5, 2)};
+	assert_true(PolySnapshotSave(path, polys, 3));
+
+	LoadedPolys loaded = {.count = 0};
+	assert_true(PolySnapshotLoad(path, snapshot_collect, &loaded));
+	assert_int_equal(loaded.count, 3);
+	for (size_t i = 0; i < 3; i++) {
+		assert_true(PolyIsEq(&(loaded.polys[i]), &(polys[i])));
+	}
+	assert_true(PolySnapshotMapped(&(loaded.polys[0])));
+	assert_false(PolySnapshotMapped(&(polys[0])));
+
+	/* wynik działania na wczytanym wielomianie jest w zwykłej pamięci */
+	Poly r = PolyAdd(&(loaded.polys[0]), &(loaded.polys[2]));
+	Poly e = PolyAdd(&(polys[0]), &(polys[2]));
+	assert_false(PolySnapshotMapped(&r));
+	assert_true(PolyIsEq(&r, &e));
+
+	for (size_t i = 0; i < 3; i++) {
+		PolyDestroy(&(loaded.polys[i]));
+		PolyDestroy(&(polys[i]));
+	}
+	PolyDestroy(&r);
+	PolyDestroy(&e);
+
+	/* plik, który nie jest zrzutem, nie jest wczytywany */
+	FILE *f = fopen(path, "w");
+	assert_true(f != NULL);
+	fputs("(1,2)\n", f);
+	fclose(f);
+	assert_false(PolySnapshotLoad(path, snapshot_collect, &loaded));
+	assert_int_equal(loaded.count, 3);
+
+	/* dwa wczytania tego samego zrzutu to dwa niezależne odwzorowania */
+	Poly x3 = poly_cxn(1, 0, 3);
+	Poly x5 = poly_cxn(1, 0, 5);
+	Poly x = PolyAdd(&x3, &x5);
+	PolyDestroy(&x3);
+	PolyDestroy(&x5);
+	assert_true(PolySnapshotSave(path, &x, 1));
+	loaded.count = 0;
+	assert_true(PolySnapshotLoad(path, snapshot_collect, &loaded));
+	assert_true(PolySnapshotLoad(path, snapshot_collect, &loaded));
+	assert_int_equal(loaded.count, 2);
+	assert_true(PolySnapshotMapped(&(loaded.polys[0])));
+	assert_true(PolySnapshotMapped(&(loaded.polys[1])));
+	PolyDestroy(&(loaded.polys[0]));
+	assert_true(PolySnapshotMapped(&(loaded.polys[1])));
+	assert_true(PolyIsEq(&(loaded.polys[1]), &x));
+	PolyDestroy(&(loaded.polys[1]));
+
+	/* zrzut z jednomianami w złej kolejności nie jest wczytywany */
+	Mono monos[2];
+	f = fopen(path, "r+b");
+	assert_true(f != NULL);
+	assert_int_equal(fseek(f, -(long) sizeof(monos), SEEK_END), 0);
+	assert_int_equal(fread(monos, sizeof(Mono), 2, f), 2);
+	poly_exp_t exp = monos[0].exp;
+	monos[0].exp = monos[1].exp;
+	monos[1].exp = exp;
+	assert_int_equal(fseek(f, -(long) sizeof(monos), SEEK_END), 0);
+	assert_int_equal(fwrite(monos, sizeof(Mono), 2, f), 2);
+	fclose(f);
+	loaded.count = 0;
+	assert_false(PolySnapshotLoad(path, snapshot_collect, &loaded));
+	assert_int_equal(loaded.count, 0);
+	PolyDestroy(&x);
+	unlink(path);
+}
+
+
+/** Wyjście kalkulatora zebrane w teście */
+typedef struct FeedOutput {
+	char data[256]; ///< zebrane bajty (zakończone bajtem 0)
+	size_t len; ///< liczba zebranych bajtów
+} FeedOutput;
+
+/**
+ * Pomocnicza funkcja, dopisuje wyjście kalkulatora do FeedOutput.
+ * @param[in] data : bajty
+ * @param[in] size : liczba bajtów
+ * @param[in] user : FeedOutput
+ */
+static void feed_write(const char *data, size_t size, void *user) {
+	FeedOutput *out = user;
+	assert_true(out->len + size < sizeof(out->data));
+	memcpy(out->data + out->len, data, size);
+	out->len += size;
+	out->data[out->len] = '\0';
+}
+
+/**
+ * Pomocnicza funkcja, przekazuje kalkulatorowi napis.
+ * @param[in,out] calc : kalkulator
+ * @param[in] s : napis
+ */
+static void feed(Calc *calc, const char *s) {
+	CalcFeed(calc, s, strlen(s));
+}
+
+/**
+ * Pomocnicza funkcja, sprawdza, że kalkulator wczytuje to, co drukuje:
+ * kwadrat @f$cx_0@f$ dla największego wczytywanego c, wydrukowany w trybie
+ * tekstowym i binarnym, podany z powrotem na wejście jest równy wyliczonemu.
+ */
+static void check_round_trip() {
+#if defined(POLY_COEFF_I32)
+	const char *text = "(2147483647,1)\nCLONE\nMUL\nCLONE\nPRINT\n";
+	poly_coeff_t c = CoeffFromInt(INT32_MAX);
+#else
+	const char *text = "(9223372036854775807,1)\nCLONE\nMUL\nCLONE\nPRINT\n";
+	poly_coeff_t c = CoeffFromInt(INT64_MAX);
+#endif
+
+	FeedOutput out = {.len = 0};
+	Calc *calc = CalcNew(CALC_TEXT, feed_write, feed_write, &out);
+	CalcSetInteractive(calc, true);
+	feed(calc, text);
+	char line[sizeof(out.data)];
+	memcpy(line, out.data, out.len + 1);
+#if defined(POLY_COEFF_I128)
+	assert_string_equal(line, "(85070591730234615847396907784232501249,2)\n");
+#endif
+	out.len = 0;
+	feed(calc, line);
+	feed(calc, "IS_EQ\n");
+	CalcFinish(calc);
+	CalcDelete(calc);
+	assert_string_equal(out.data, "1\n");
+
+	/* ramka wyniku PRINT jest zarazem ramką POLY z tym samym wielomianem */
+	char in[64] = {0, WIRE_POLY, 2, 0};
+	size_t len = 4 + WireCoeffEncode(c, (unsigned char *) in + 4);
+	in[len++] = 0;
+	in[0] = (char) (len - 1);
+	const char ops[] = {1, WIRE_CLONE, 1, WIRE_MUL, 1, WIRE_CLONE,
+						1, WIRE_PRINT};
+	memcpy(in + len, ops, sizeof(ops));
+	len += sizeof(ops);
+
+	out.len = 0;
+	calc = CalcNew(CALC_BINARY, feed_write, feed_write, &out);
+	CalcSetInteractive(calc, true);
+	CalcFeed(calc, in, len);
+	assert_true(out.len > 0 && out.len < sizeof(in));
+	memcpy(in, out.data, out.len);
+	len = out.len;
+	in[len++] = 1;
+	in[len++] = WIRE_IS_EQ;
+	out.len = 0;
+	CalcFeed(calc, in, len);
+	CalcFinish(calc);
+	CalcDelete(calc);
+	const char is_eq[] = {2, WIRE_REPLY_INT, 2};
+	assert_int_equal(out.len, sizeof(is_eq));
+	assert_int_equal(memcmp(out.data, is_eq, sizeof(is_eq)), 0);
+}
+
+/**
+ * Pomocnicza funkcja, sprawdza @f$(ax_0 + b)^2 = a^2x_0^2 + 2abx_0 + b^2@f$
+ * w arytmetyce współczynników wybranego wariantu.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ */
+static void check_square(poly_coeff_t a, poly_coeff_t b) {
+	Poly ax = poly_cx0(a, 1);
+	Poly pb = PolyFromCoeff(b);
+	Poly p = PolyAdd(&ax, &pb);
+	Poly r = PolyMul(&p, &p);
+
+	Poly t2 = poly_cx0(CoeffMul(a, a), 2);
+	Poly t1 = poly_cx0(CoeffMul(CoeffFromInt(2), CoeffMul(a, b)), 1);
+	Poly t0 = PolyFromCoeff(CoeffMul(b, b));
+	Poly s = PolyAdd(&t2, &t1);
+	Poly e = PolyAdd(&s, &t0);
+	assert_true(PolyIsEq(&r, &e));
+
+	PolyDestroy(&ax);
+	PolyDestroy(&p);
+	PolyDestroy(&r);
+	PolyDestroy(&t2);
+	PolyDestroy(&t1);
+	PolyDestroy(&s);
+	PolyDestroy(&e);
+}
+
+/** Test: przepełnienia i arytmetyka modularna wariantu współczynników */
+static void test_coeff_arithmetic(void **state) {
+	(void) state;
+
+#if defined(POLY_COEFF_I32)
+	assert_int_equal(sizeof(poly_coeff_t), 4);
+	assert_true(CoeffAdd(POLY_COEFF_MAX, 1) == INT32_MIN);
+	assert_true(CoeffMul(65536, 65536) == 0);
+	assert_true(CoeffNeg(INT32_MIN) == INT32_MIN);
+#elif defined(POLY_COEFF_I128)
+	assert_int_equal(sizeof(poly_coeff_t), 16);
+	poly_coeff_t big = CoeffMul(INT64_MAX, INT64_MAX);
+	assert_true(big > 0 && big / INT64_MAX == INT64_MAX);
+	assert_true(CoeffAdd(POLY_COEFF_MAX, 1) < 0);
+#elif defined(POLY_COEFF_MOD)
+	const poly_coeff_t m1 = POLY_COEFF_MAX;
+	assert_true(CoeffFromInt(-1) == m1);
+	assert_true(CoeffAdd(m1, 1) == 0);
+	assert_true(CoeffNeg(1) == m1);
+	assert_true(CoeffMul(m1, m1) == 1);
+	/* odwrotność 2 to (P + 1) / 2 */
+	assert_true(CoeffMul(2, (POLY_COEFF_MODULUS + 1) / 2) == 1);
+	const poly_coeff_t x = CoeffFromInt(INT64_MAX);
+	assert_true(CoeffMul(x, x) ==
+				(poly_coeff_t) ((unsigned __int128) x * x % POLY_COEFF_MODULUS));
+#else
+	assert_int_equal(sizeof(poly_coeff_t), 8);
+	assert_true(CoeffAdd(POLY_COEFF_MAX, 1) == INT64_MIN);
+	assert_true(CoeffMul((poly_coeff_t) 1 << 32, (poly_coeff_t) 1 << 32) == 0);
+#endif
+
+	check_square(CoeffFromInt(3), CoeffFromInt(-5));
+	check_square(CoeffFromInt(65536), CoeffFromInt(65535));
+	check_square(POLY_COEFF_MAX, CoeffNeg(POLY_COEFF_MAX));
+	check_round_trip();
+}
+
+/** Test: dwa kalkulatory wykonują przeplatane porcje wejścia niezależnie */
+static void test_feed(void **state) {
+	(void) state;
+
+	FeedOutput text = {.len = 0}, compiled = {.len = 0};
+	Calc *a = CalcNew(CALC_TEXT, feed_write, feed_write, &text);
+	Calc *b = CalcNew(CALC_COMPILE, feed_write, feed_write, &compiled);
+
+	/* porcje kończą się w środku linii, które czekają na resztę */
+	feed(a, "(1,2)\nCL");
+	feed(b, "PRINT\n(3,");
+	feed(a, "ONE\nMUL\nPRI");
+	assert_int_equal(strcmp(text.data, ""), 0);
+	feed(a, "NT\nDEG");
+	assert_int_equal(strcmp(text.data, "(1,4)\n"), 0);
+	feed(b, "0)\nPRINT\n");
+
+	/* skompilowany program jest wykonywany dopiero na końcu wejścia */
+	assert_int_equal(compiled.len, 0);
+	CalcFinish(a);
+	CalcFinish(b);
+	assert_int_equal(strcmp(text.data, "(1,4)\n4\n"), 0);
+	assert_int_equal(strcmp(compiled.data, "ERROR 1 STACK UNDERFLOW\n3\n"), 0);
+	assert_int_equal(CalcStatus(b), 0);
+
+	/* ostatnia linia bez znaku nowej linii */
+	compiled.len = 0;
+	compiled.data[0] = '\0';
+	feed(b, "(1,2)\nPRINT");
+	CalcFinish(b);
+	assert_int_equal(strcmp(compiled.data, "(1,2)\n"), 0);
+	assert_int_not_equal(CalcStatus(b), 0);
+	assert_int_equal(CalcStatus(b), CalcStatus(a));
+
+	CalcDelete(a);
+	CalcDelete(b);
+}
+
+
+/** Test: wyniki i błędy trafiają do wspólnego odbiorcy w kolejności linii,
+ * niezależnie od podziału wejścia na porcje */
+static void test_feed_order(void **state) {
+	(void) state;
+
+	const char in[] = "(1,2)\nPRINT\nADD\nDEG\n(1,\nCLONE\nIS_EQ\n"
+		"POP\nPOP\nDEG\nNEG\n";
+	const char expected[] = "(1,2)\nERROR 3 STACK UNDERFLOW\n2\nERROR 5 4\n"
+		"1\nERROR 10 STACK UNDERFLOW\nERROR 11 STACK UNDERFLOW\n";
+	const size_t chunks[] = {1, 13, sizeof(in)};
+
+	for (size_t i = 0; i < array_length(chunks); i++) {
+		FeedOutput out = {.len = 0};
+		Calc *calc = CalcNew(CALC_TEXT, feed_write, feed_write, &out);
+		CalcSetInteractive(calc, false);
+		for (size_t pos = 0; pos < sizeof(in) - 1; pos += chunks[i]) {
+			size_t size = sizeof(in) - 1 - pos;
+			CalcFeed(calc, in + pos, size < chunks[i] ? size : chunks[i]);
+		}
+		CalcFinish(calc);
+		assert_string_equal(out.data, expected);
+		CalcDelete(calc);
+	}
+}
+
+
+/** Test: przy wykonaniu potokowym wyniki i błędy trafiają do wspólnego
+ * odbiorcy w tej samej kolejności co przy wykonaniu w jednym wątku */
+static void test_pipeline_order(void **state) {
+	(void) state;
+
+	char in[] = "(1,2)\nPRINT\nADD\nCLONE\nPRINT\nMUL_PRINT\n(1,\n(2,1)\n"
+		"DEG\nPOP\nPOP\nIS_ZERO\n(1,1)\nPRINT\nNEG\nPRINT\n";
+
+	FeedOutput expected = {.len = 0};
+	Calc *calc = CalcNew(CALC_TEXT, feed_write, feed_write, &expected);
+	feed(calc, in);
+	CalcFinish(calc);
+	CalcDelete(calc);
+
+	for (int i = 0; i < 10; i++) {
+		FeedOutput out = {.len = 0};
+		FILE *f = fmemopen(in, strlen(in), "r");
+		assert_true(f != NULL);
+		calc = CalcNew(CALC_TEXT, feed_write, feed_write, &out);
+		CalcSetInteractive(calc, true);
+		CalcRunFile(calc, f, 2);
+		CalcDelete(calc);
+		fclose(f);
+		assert_string_equal(out.data, expected.data);
+	}
+}
+
+
 /* * * TESTY PARSERA * * */
 
 
@@ -161,7 +1067,35 @@ static int exit_status; ///< wartość zwracana przez main po wykonaniu
  */
 int mock_main() {
 	if (!setjmp(jmp_at_exit))
-		return calculator_main();
+		return calculator_main(1, (char *[]) {"calc_poly", NULL});
+	return exit_status;
+}
+
+/**
+ * Atrapa funkcji main uruchamiająca kalkulator w trybie binarnym
+ */
+int mock_main_binary() {
+	if (!setjmp(jmp_at_exit))
+		return calculator_main(2, (char *[]) {"calc_poly", "--binary", NULL});
+	return exit_status;
+}
+
+/**
+ * Atrapa funkcji main uruchamiająca kalkulator w trybie łańcucha
+ * @param[in] dir : katalog łańcucha
+ */
+int mock_main_chain(char *dir) {
+	if (!setjmp(jmp_at_exit))
+		return calculator_main(3, (char *[]) {"calc_poly", "--chain", dir, NULL});
+	return exit_status;
+}
+
+/**
+ * Atrapa funkcji main uruchamiająca kalkulator w trybie kompilacji
+ */
+int mock_main_compile() {
+	if (!setjmp(jmp_at_exit))
+		return calculator_main(2, (char *[]) {"calc_poly", "--compile", NULL});
 	return exit_status;
 }
 
@@ -205,6 +1139,20 @@ int mock_printf(const char *format, ...) {
 	return return_value;
 }
 
+/**
+ * Atrapa funkcji write.
+ * Obsługiwane jest tylko standardowe wyjście.
+ */
+ssize_t mock_write(int fd, const void *buf, size_t count) {
+	assert_int_equal(fd, STDOUT_FILENO);
+	assert_true(printf_position + count < sizeof(printf_buffer));
+
+	memcpy(printf_buffer + printf_position, buf, count);
+	printf_position += count;
+	printf_buffer[printf_position] = '\0';
+	return count;
+}
+
 /**
  * Atrapa funkcji fprintf
  */
@@ -276,10 +1224,31 @@ char *mock_fgets(char *__s, int __n, FILE *__stream) {
 	FILE *stream = fmemopen(in, strlen(in), "r");
 	int new_line_pos = strcspn(in, "\n");
 	input_stream_position += (new_line_pos + 1);
+	if (input_stream_position > input_stream_end) {
+		input_stream_position = input_stream_end;
+	}
 
 	return fgets(__s, __n, stream);
 }
 
+/**
+ * Atrapa funkcji fread używana do przechwycenia czytania z stdin.
+ */
+size_t mock_fread(void *ptr, size_t size, size_t nmemb, FILE *stream) {
+	/* pliki łańcucha czytamy naprawdę */
+	if (stream != stdin) {
+		return fread(ptr, size, nmemb, stream);
+	}
+
+	size_t n = (input_stream_end - input_stream_position) / size;
+	if (n > nmemb) {
+		n = nmemb;
+	}
+	memcpy(ptr, input_stream_buffer + input_stream_position, n * size);
+	input_stream_position += n * size;
+	return n;
+}
+
 
 /**
  * Atrapa funkcji getchar używana do przechwycenia czytania z stdin.
@@ -314,6 +1283,17 @@ static void init_input_stream(const char *str) {
 	strcpy(input_stream_buffer, str);
 }
 
+/**
+ * Funkcja inicjująca binarne dane wejściowe (mogące zawierać bajty 0).
+ */
+static void init_input_bytes(const char *bytes, size_t n) {
+	memset(input_stream_buffer, 0, sizeof(input_stream_buffer));
+	input_stream_position = 0;
+	input_stream_end = n;
+	assert_true(n < sizeof(input_stream_buffer));
+	memcpy(input_stream_buffer, bytes, n);
+}
+
 /**
  * Funkcja wołana przed każdym testem.
  */
@@ -448,6 +1428,220 @@ static void test_compose_digits_and_letters(void **state) {
 	assert_int_equal(strcmp(fprintf_buffer, "ERROR 2 WRONG COUNT\n"), 0);
 }
 
+/** Test: MUL_PRINT drukuje iloczyn i zdejmuje czynniki ze stosu */
+static void test_mul_print(void **state) {
+	(void) state;
+
+	init_input_stream("(1,0)+(1,1)\n(1,0)+(-1,1)\nMUL_PRINT\nIS_ZERO\n");
+
+	assert_int_equal(mock_main(), 0);
+
+#if defined(POLY_COEFF_MOD)
+	char expected[64];
+	snprintf(expected, sizeof(expected), "(1,0)+(%" PRIu64 ",2)\n",
+			 (uint64_t) POLY_COEFF_MODULUS - 1);
+	assert_int_equal(strcmp(printf_buffer, expected), 0);
+#else
+	assert_int_equal(strcmp(printf_buffer, "(1,0)+(-1,2)\n"), 0);
+#endif
+	assert_int_equal(strcmp(fprintf_buffer, "ERROR 4 STACK UNDERFLOW\n"), 0);
+}
+
+/** Test: tryb binarny odkłada wielomian, drukuje go i jego stopień */
+static void test_binary_mode(void **state) {
+	(void) state;
+
+	/* (1,2) jako ramka POLY, potem ramki PRINT i DEG */
+	const char in[] = {5, 0, 3, 0, 2, 0, 1, 13, 1, 10};
+	const char out[] = {5, 0, 3, 0, 2, 0, 2, 1, 4};
+	init_input_bytes(in, sizeof(in));
+
+	assert_int_equal(mock_main_binary(), 0);
+
+	assert_int_equal(printf_position, sizeof(out));
+	assert_int_equal(memcmp(printf_buffer, out, sizeof(out)), 0);
+	assert_int_equal(strcmp(fprintf_buffer, ""), 0);
+}
+
+/** Test: w trybie binarnym MUL_PRINT wypisuje ramkę z długością całej treści */
+static void test_binary_mul_print(void **state) {
+	(void) state;
+
+	/* (1,0)+(1,1) jako ramka POLY, potem ramki CLONE i MUL_PRINT */
+	const char in[] = {8, 0, 1, 0, 2, 2, 0, 2, 0, 1, 4, 1, 16};
+	const char out[] = {11, 0, 1, 0, 2, 2, 0, 4, 3, 0, 2, 0};
+	init_input_bytes(in, sizeof(in));
+
+	assert_int_equal(mock_main_binary(), 0);
+
+	assert_int_equal(printf_position, sizeof(out));
+	assert_int_equal(memcmp(printf_buffer, out, sizeof(out)), 0);
+	assert_int_equal(strcmp(fprintf_buffer, ""), 0);
+}
+
+/** Test: skompilowane wejście daje te same wyniki i błędy co wykonywane linia po linii */
+static void test_compile(void **state) {
+	(void) state;
+
+	/* CLONE i POP w wierszach 2-3 oraz obliczenia w wierszach 6-9 znoszą
+	   się przy kompilacji, a błędy z kompilacji (wiersz 5) i z wykonania
+	   muszą pozostać w kolejności wierszy */
+	init_input_stream("(1,2)\nCLONE\nPOP\nADD\n(1,\n(2,1)\nCLONE\nMUL\nPOP\n"
+					  "PRINT\nPOP\nPOP\n");
+
+	assert_int_equal(mock_main_compile(), 0);
+
+	assert_int_equal(strcmp(printf_buffer, "(1,2)\n"), 0);
+	assert_int_equal(strcmp(fprintf_buffer, "ERROR 4 STACK UNDERFLOW\n"
+							"ERROR 5 4\nERROR 12 STACK UNDERFLOW\n"), 0);
+}
+
+/** Test: ostatnia linia bez znaku nowej linii jest skompilowana jak każda inna */
+static void test_compile_no_newline(void **state) {
+	(void) state;
+
+	init_input_stream("(1,2)\nPRINT");
+
+	/* jak przy wykonaniu linia po linii, flaga końca wejścia jest wynikiem */
+	int status = mock_main_compile();
+	init_input_stream("(1,2)\nPRINT");
+	assert_int_equal(mock_main(), status);
+
+	assert_int_equal(strcmp(printf_buffer, "(1,2)\n(1,2)\n"), 0);
+	assert_int_equal(strcmp(fprintf_buffer, ""), 0);
+}
+
+/**
+ * Pomocnicza funkcja, wykonuje przez harmonogram łańcuch 1000 dodawań,
+ * w którym każda suma pośrednia jest większa od poprzedniej.
+ * @return 0, gdy wynik jest poprawny, a szczytowa pamięć procesu wzrosła
+ * o mniej niż 32 MB (zachowanie wszystkich sum zajęłoby ich kilkaset)
+ */
+static int schedule_chain(void) {
+	struct rusage before, after;
+	FeedOutput out = {.len = 0};
+	char line[512];
+
+	getrusage(RUSAGE_SELF, &before);
+	PolyThreadsInit(4);
+	Calc *calc = CalcNew(CALC_COMPILE, feed_write, feed_write, &out);
+	for (int k = 0; k < 1000; k++) {
+		size_t len = 0;
+		for (int j = 0; j < 16; j++) {
+			len += sprintf(line + len, "%s(1,%d)", j > 0 ? "+" : "", 16 * k + j);
+		}
+		line[len++] = '\n';
+		CalcFeed(calc, line, len);
+		if (k > 0) {
+			feed(calc, "ADD\n");
+		}
+	}
+	feed(calc, "DEG\n");
+	CalcFinish(calc);
+	CalcDelete(calc);
+	PolyThreadsDestroy();
+	getrusage(RUSAGE_SELF, &after);
+
+	return strcmp(out.data, "15999\n") != 0 ||
+		   after.ru_maxrss - before.ru_maxrss >= 32 * 1024;
+}
+
+/** Test: harmonogram nie zatrzymuje wartości pośrednich długiego łańcucha
+ * zależnych obliczeń */
+static void test_schedule_chain(void **state) {
+	(void) state;
+
+	/* szczytowa pamięć jest mierzona w osobnym procesie, żeby nie zależała
+	   od poprzednich testów */
+	pid_t pid = fork();
+	assert_true(pid >= 0);
+	if (pid == 0) {
+		_exit(schedule_chain());
+	}
+	int status;
+	assert_int_equal(waitpid(pid, &status, 0), pid);
+	assert_true(WIFEXITED(status));
+	assert_int_equal(WEXITSTATUS(status), 0);
+}
+
+/** Test: harmonogram liczy niezależne wartości razem i drukuje je w kolejności */
+static void test_schedule(void **state) {
+	(void) state;
+
+	/* oba MUL w wierszach 3 i 6 są na tym samym poziomie grafu, a CLONE
+	   w wierszu 8 odkłada jedną wartość dwa razy */
+	init_input_stream("(1,1)\n(1,2)\nMUL\n(2,1)\nCLONE\nMUL\nADD\nCLONE\n"
+					  "(1,0)+(1,1)\nCOMPOSE 1\nPRINT\nPOP\nPRINT\nNEG\nPOP\nADD\n");
+
+	setenv("CALC_POLY_THREADS", "2", 1);
+	int status = mock_main_compile();
+	unsetenv("CALC_POLY_THREADS");
+	assert_int_equal(status, 0);
+
+	assert_int_equal(strcmp(printf_buffer,
+							"(1,0)+(4,2)+(1,3)\n(4,2)+(1,3)\n"), 0);
+	assert_int_equal(strcmp(fprintf_buffer, "ERROR 16 STACK UNDERFLOW\n"), 0);
+}
+
+/** Test: wykonanie potokowe drukuje wyniki i błędy w kolejności wierszy */
+static void test_pipeline(void **state) {
+	(void) state;
+
+	init_input_stream("(1,2)\nCLONE\nMUL_PRINT\n(1,\n(2,1)\nCLONE\nDEG\nPRINT\n"
+					  "IS_EQ\nPOP\nPOP\nPOP\n");
+
+	/* kolejki krótsze niż liczba wyników – wątki muszą na siebie czekać */
+	setenv("CALC_POLY_PIPELINE", "2", 1);
+	int status = mock_main();
+	unsetenv("CALC_POLY_PIPELINE");
+	assert_int_equal(status, 0);
+
+	assert_int_equal(strcmp(printf_buffer, "(1,4)\n1\n(2,1)\n1\n"), 0);
+	assert_int_equal(strcmp(fprintf_buffer,
+							"ERROR 4 4\nERROR 12 STACK UNDERFLOW\n"), 0);
+}
+
+/**
+ * Pomocnicza funkcja, zapisuje plik łańcucha.
+ * @param[in] dir : katalog
+ * @param[in] name : nazwa pliku
+ * @param[in] content : zawartość
+ */
+static void chain_file(const char *dir, const char *name, const char *content) {
+	char path[256];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE *f = fopen(path, "w");
+	assert_true(f != NULL);
+	fputs(content, f);
+	fclose(f);
+}
+
+/** Test: wyniki kroku łańcucha leżą na stosie w następnym kroku */
+static void test_chain(void **state) {
+	(void) state;
+
+	char dir[] = "/tmp/unit_tests_poly_chainXXXXXX";
+	assert_true(mkdtemp(dir) != NULL);
+	chain_file(dir, "a", "PRINT\nSTOP\n");
+	chain_file(dir, "b", "START\n(1,1)\nCLONE\nPRINT\nMUL_PRINT\nFILE c\n");
+	chain_file(dir, "c", "ADD\nPRINT\nIS_EQ\nFILE a\n");
+
+	assert_int_equal(mock_main_chain(dir), 0);
+
+	/* b przekazuje c wyniki (1,1) i (1,2); c wypisuje ich sumę, a w wierszu
+	   5 (po dwóch przekazanych wynikach) zabraknie mu wielomianu do IS_EQ */
+	assert_int_equal(strcmp(printf_buffer, "(1,1)+(1,2)\n"), 0);
+	assert_int_equal(strcmp(fprintf_buffer, "ERROR 5 STACK UNDERFLOW\n"), 0);
+
+	char path[256];
+	const char *names[] = {"a", "b", "c"};
+	for (size_t i = 0; i < array_length(names); i++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+		unlink(path);
+	}
+	rmdir(dir);
+}
+
 /**
  * Główna funkcja testująca
  * @return sumaryczny wynik testów (>0 = źle)
@@ -461,6 +1655,27 @@ int main(void) {
 		cmocka_unit_test(test_poly_x),
 		cmocka_unit_test(test_poly_x_compose_scalar),
 		cmocka_unit_test(test_poly_x_compose_x),
+		cmocka_unit_test(test_mul_merges_runs),
+		cmocka_unit_test(test_coeff_arithmetic),
+		cmocka_unit_test(test_mul_cancels_terms),
+		cmocka_unit_test(test_mul_by_mono),
+		cmocka_unit_test(test_pow_binomial),
+		cmocka_unit_test(test_cache_hit),
+		cmocka_unit_test(test_cache_budget),
+		cmocka_unit_test(test_flat_mul),
+		cmocka_unit_test(test_mul_parallel),
+		cmocka_unit_test(test_compose_parallel),
+		cmocka_unit_test(test_add_parallel),
+		cmocka_unit_test(test_traversal_parallel),
+		cmocka_unit_test(test_reclaim),
+		cmocka_unit_test(test_intern),
+		cmocka_unit_test(test_skip_levels),
+		cmocka_unit_test(test_deep_nesting),
+		cmocka_unit_test(test_snapshot),
+		cmocka_unit_test(test_feed),
+		cmocka_unit_test(test_feed_order),
+		cmocka_unit_test(test_pipeline_order),
+		cmocka_unit_test(test_schedule_chain),
 	};
 
 	const struct CMUnitTest tests_parser[] = {
@@ -471,7 +1686,15 @@ int main(void) {
 		cmocka_unit_test_setup_teardown(test_compose_unsigned_max_plus_1, test_setup, test_teardown),
 		cmocka_unit_test_setup_teardown(test_compose_big_int, test_setup, test_teardown),
 		cmocka_unit_test_setup_teardown(test_compose_letters, test_setup, test_teardown),
-		cmocka_unit_test_setup_teardown(test_compose_digits_and_letters, test_setup, test_teardown)
+		cmocka_unit_test_setup_teardown(test_compose_digits_and_letters, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_mul_print, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_binary_mode, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_binary_mul_print, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_compile, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_compile_no_newline, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_pipeline, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_schedule, test_setup, test_teardown),
+		cmocka_unit_test_setup_teardown(test_chain, test_setup, test_teardown)
 	};
 
 	int r = cmocka_run_group_tests(tests_poly, NULL, NULL);
@@ -23,6 +23,7 @@
 #ifdef UNIT_TESTING
 
 #include <stdio.h>
+#include <sys/types.h>
 
 
 /* Redirect exit to a function in the test application so it's possible to
@@ -49,6 +50,14 @@ extern int mock_printf(const char *format, ...);
 #define fprintf(...) mock_fprintf(__VA_ARGS__)
 extern int mock_fprintf(FILE * const file, const char *format, ...);
 
+/* Redirect write to a function in the test application so it's possible to
+ * test the standard output written in blocks. */
+#ifdef write
+#undef write
+#endif /* write */
+#define write(fd, buf, count) mock_write(fd, buf, count)
+extern ssize_t mock_write(int fd, const void *buf, size_t count);
+
 /* Redirect scanf to a function in the test application so it's possible to
  * test the standard input. */
 #ifdef scanf
@@ -66,6 +75,13 @@ extern int mock_scanf(const char *format, ...);
 #define fgets(s, n, stream) mock_fgets(s, n, stream)
 extern char *fgets(char *__s, int __n, FILE *__stream);
 
+/* Redirect fread to a function in the test application so it's possible to
+ * test the standard input. */
+#ifdef fread
+#undef fread
+#endif /* fread */
+#define fread(ptr, size, nmemb, stream) mock_fread(ptr, size, nmemb, stream)
+extern size_t mock_fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
 
 /* Redirect getchar to a function in the test application so it's possible to
  * test the standard input. */
@@ -0,0 +1,94 @@
+/** @file
+   Stos roboczy iteracyjnych przejść drzewa wielomianu
+
+   Przejścia, które rekurencyjnie schodziłyby o poziom na każdą zmienną,
+   trzymają swoje ramki na stercie, w buforze używanym ponownie przez kolejne
+   wywołania. Głębokość wielomianu ogranicza wtedy rozmiar sterty, a nie
+   rozmiar stosu wywołań.
+
+   Wywołanie zagnieżdżone w przejściu tego samego rodzaju (np. zadanie puli
+   wątków wykonywane przez wątek wywołujący) używa tego samego stosu: pamięta
+   liczbę ramek na początku i zdejmuje tylko ramki położone nad nimi.
+
+   @author Tomasz Necio <Tomasz.Necio@fuw.edu.pl>
+   @copyright Uniwersytet Warszawski
+   @date 2026-10-19
+*/
+
+#ifndef __WORK_STACK_H__
+#define __WORK_STACK_H__
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define WORK_STACK_INITIAL_SIZE 64 ///< początkowa pojemność stosu roboczego
+
+/** Stos ramek jednego rodzaju */
+typedef struct WorkStack {
+	void *items; ///< bufor ramek
+	size_t count; ///< liczba ramek na stosie
+	size_t size; ///< pojemność bufora
+} WorkStack;
+
+/**
+ * Odkłada nową ramkę na stos.
+ * Wskaźnik jest ważny do następnego WorkStackPush.
+ * @param[in,out] s : stos
+ * @param[in] item_size : rozmiar ramki
+ * @return miejsce na ramkę
+ */
+static inline void *WorkStackPush(WorkStack *s, size_t item_size) {
+	if (s->count == s->size) {
+		s->size = s->size > 0 ? 2 * s->size : WORK_STACK_INITIAL_SIZE;
+		s->items = realloc(s->items, s->size * item_size);
+		assert(s->items != NULL);
+	}
+	return (char *) s->items + (s->count++) * item_size;
+}
+
+/**
+ * Zdejmuje ramkę ze stosu.
+ * Wskaźnik jest ważny do następnego WorkStackPush.
+ * @param[in,out] s : niepusty stos
+ * @param[in] item_size : rozmiar ramki
+ * @return zdjęta ramka
+ */
+static inline void *WorkStackPop(WorkStack *s, size_t item_size) {
+	assert(s->count > 0);
+	return (char *) s->items + (--s->count) * item_size;
+}
+
+/**
+ * Zwalnia bufor stosu.
+ * @param[in,out] s : stos
+ */
+static inline void WorkStackFree(WorkStack *s) {
+	free(s->items);
+	s->items = NULL;
+	s->count = 0;
+	s->size = 0;
+}
+
+/** Stosy robocze iteracyjnych przejść drzewa, osobne dla każdego wątku */
+typedef struct WorkStacks {
+	WorkStack destroy; ///< wielomiany do usunięcia (Poly)
+	WorkStack clone; ///< kopiowane poddrzewa (CloneFrame)
+	WorkStack add; ///< dodawane poddrzewa (AddFrame)
+	WorkStack scalar_mul; ///< poddrzewa mnożone przez skalar (ScalarMulFrame)
+	WorkStack deg_by; ///< poddrzewa przeszukiwane przez PolyDegBy (DegByFrame)
+	WorkStack deg; ///< poddrzewa przeszukiwane przez PolyDeg (DegFrame)
+	WorkStack is_eq; ///< porównywane pary poddrzew (IsEqFrame)
+	WorkStack is_zero; ///< poddrzewa sprawdzane przez MonoIsZero (const Poly *)
+	WorkStack intern; ///< internowane poddrzewa (InternFrame, poly_intern.c)
+	WorkStack intern_delete; ///< usuwane wpisy tablicy internowania (InternNode *)
+} WorkStacks;
+
+/**
+ * Zwraca stosy robocze bieżącego wątku, tworząc je przy pierwszym użyciu.
+ * Stosy zwalniane są przy końcu wątku.
+ * @return stosy robocze
+ */
+WorkStacks *ThreadWorkStacks();
+
+#endif /* __WORK_STACK_H__ */